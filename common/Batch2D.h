@@ -0,0 +1,418 @@
+//
+//  Batch2D.h
+//
+//  Desenho 2D em lote para os exercícios de triângulos e quadrados: em vez
+//  de um VAO, um setupShader e uma chamada de desenho com uniforms por
+//  forma, as formas (triângulos, quadrados, linhas e pontos, com cor e
+//  textura opcional) são acumuladas na CPU já transformadas e vão para a
+//  GPU de uma vez. O lote é descarregado (flush) quando o tipo de primitiva
+//  ou a textura mudam, quando enche ou no fim do quadro, então milhares de
+//  formas custam poucas chamadas de desenho.
+//
+//  O VBO é um anel de streaming: cada descarga escreve logo depois da
+//  anterior com um mapeamento sem sincronização, e só quando o anel acaba
+//  o buffer é "órfão" (glBufferData com NULL), para o driver não esperar
+//  pelos desenhos que ainda leem a parte antiga.
+//
+//  Batch2DBuffer guarda formas que não mudam de um quadro para o outro em
+//  um VBO próprio que cresce dobrando: só as novas são enviadas, e
+//  Batch2D::draw desenha todas com o mesmo shader em uma chamada.
+//
+
+#ifndef Batch2D_h
+#define Batch2D_h
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+using namespace std;
+
+// Vértice do lote: posição já transformada, coordenada de textura e cor RGBA8
+struct Batch2DVertex {
+    float x, y;
+    float u, v;
+    uint32_t color;
+};
+
+inline uint32_t batch2DColor(const glm::vec4 &c) {
+    unsigned char bytes[4];
+    for (int i = 0; i < 4; i++) {
+        float v = c[i] < 0 ? 0 : (c[i] > 1 ? 1 : c[i]);
+        bytes[i] = (unsigned char)(v * 255.0f + 0.5f);
+    }
+    uint32_t packed;
+    memcpy(&packed, bytes, 4);
+    return packed;
+}
+
+// Ponteiros de atributos do Batch2DVertex para o VBO vinculado (no VAO vinculado)
+inline void batch2DLayout() {
+    GLsizei stride = sizeof(Batch2DVertex);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (GLvoid *)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (GLvoid *)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (GLvoid *)(4 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+}
+
+inline GLuint batch2DShader(const char *who, GLenum type, const char *source) {
+    GLuint s = glCreateShader(type);
+    glShaderSource(s, 1, &source, NULL);
+    glCompileShader(s);
+    GLint ok;
+    glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[512];
+        glGetShaderInfoLog(s, 512, NULL, log);
+        cerr << who << ": erro no shader\n" << log << endl;
+        glDeleteShader(s);
+        return 0;
+    }
+    return s;
+}
+
+// Compila e liga o programa; 0 (com o log em cerr) se falhar
+inline GLuint batch2DProgram(const char *who, const char *vertexSource, const char *fragmentSource) {
+    GLuint vs = batch2DShader(who, GL_VERTEX_SHADER, vertexSource);
+    GLuint fs = batch2DShader(who, GL_FRAGMENT_SHADER, fragmentSource);
+    if (!vs || !fs) {
+        if (vs) glDeleteShader(vs);
+        if (fs) glDeleteShader(fs);
+        return 0;
+    }
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glLinkProgram(program);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+    GLint ok;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[512];
+        glGetProgramInfoLog(program, 512, NULL, log);
+        cerr << who << ": erro ao ligar o shader\n" << log << endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+class Batch2DBuffer {
+    GLuint vao, vbo;
+    vector<Batch2DVertex> data;     // cópia na CPU, reenviada só ao crescer
+    size_t sent;                    // vértices já no VBO
+    size_t capacity;                // vértices que cabem no VBO
+    size_t dirtyBegin, dirtyEnd;    // vértices já enviados e depois alterados
+
+public:
+    Batch2DBuffer() : vao(0), vbo(0), sent(0), capacity(0), dirtyBegin(0), dirtyEnd(0) {}
+
+    void triangle(const glm::vec2 &a, const glm::vec2 &b, const glm::vec2 &c, const glm::vec4 &color) {
+        uint32_t packed = batch2DColor(color);
+        Batch2DVertex va = { a.x, a.y, 0, 0, packed }, vb = { b.x, b.y, 0, 0, packed }, vc = { c.x, c.y, 0, 0, packed };
+        data.push_back(va);
+        data.push_back(vb);
+        data.push_back(vc);
+    }
+
+    // Troca o triângulo i (na ordem em que foram criados); só ele é reenviado
+    void setTriangle(size_t i, const glm::vec2 &a, const glm::vec2 &b, const glm::vec2 &c, const glm::vec4 &color) {
+        uint32_t packed = batch2DColor(color);
+        Batch2DVertex va = { a.x, a.y, 0, 0, packed }, vb = { b.x, b.y, 0, 0, packed }, vc = { c.x, c.y, 0, 0, packed };
+        data[3 * i] = va;
+        data[3 * i + 1] = vb;
+        data[3 * i + 2] = vc;
+        if (3 * i >= sent) return;
+        dirtyBegin = dirtyBegin < dirtyEnd && dirtyBegin < 3 * i ? dirtyBegin : 3 * i;
+        dirtyEnd = dirtyEnd > 3 * i + 3 ? dirtyEnd : 3 * i + 3;
+    }
+
+    // Troca todo o conteúdo por 'n' vértices já no layout do VBO (por
+    // exemplo, os de uma cena mapeada); vão para a GPU no próximo upload
+    void assign(const Batch2DVertex *vertices, size_t n) {
+        data.assign(vertices, vertices + n);
+        sent = 0;
+        dirtyBegin = dirtyEnd = 0;
+    }
+
+    void clear() {
+        data.clear();
+        sent = 0;
+        dirtyBegin = dirtyEnd = 0;
+    }
+
+    size_t size() const {
+        return data.size();
+    }
+
+    const Batch2DVertex *vertices() const {
+        return data.data();
+    }
+
+    // Envia as formas novas e as alteradas: só elas, com glBufferSubData, ou
+    // tudo de novo em um buffer com o dobro da capacidade quando não cabem
+    GLuint upload() {
+        if (!vao) {
+            glGenVertexArrays(1, &vao);
+            glGenBuffers(1, &vbo);
+            glBindVertexArray(vao);
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+            batch2DLayout();
+            glBindVertexArray(0);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        size_t sz = sizeof(Batch2DVertex);
+        if (data.size() > capacity) {
+            capacity = data.size() > 2 * capacity ? data.size() : 2 * capacity;
+            glBufferData(GL_ARRAY_BUFFER, capacity * sz, NULL, GL_DYNAMIC_DRAW);
+            sent = 0;
+            dirtyBegin = dirtyEnd = 0;
+        }
+        if (dirtyBegin < dirtyEnd) {
+            glBufferSubData(GL_ARRAY_BUFFER, dirtyBegin * sz, (dirtyEnd - dirtyBegin) * sz, &data[dirtyBegin]);
+            dirtyBegin = dirtyEnd = 0;
+        }
+        if (data.size() > sent) {
+            glBufferSubData(GL_ARRAY_BUFFER, sent * sz, (data.size() - sent) * sz, &data[sent]);
+            sent = data.size();
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return vao;
+    }
+};
+
+// Contadores desde o último begin
+struct Batch2DStats {
+    int drawCalls;
+    size_t vertices;
+    int wraps;                      // voltas do anel (buffer órfão)
+
+    Batch2DStats() : drawCalls(0), vertices(0), wraps(0) {}
+};
+
+class Batch2D {
+    GLuint program, vao, vbo, whiteTex;
+    GLint projectionLoc;
+    glm::mat4 projection, transform;
+    bool transformed;
+    vector<Batch2DVertex> pending;
+    size_t capacity;                // vértices no anel
+    size_t offset;                  // próximo vértice livre no anel
+    GLenum mode;
+    GLuint texture;
+    Batch2DStats counters;
+
+    // troca de primitiva descarrega; lote cheio também
+    void reserve(GLenum m, size_t n) {
+        if (m != mode) {
+            flush();
+            mode = m;
+        }
+        if (pending.size() + n > capacity) flush();
+    }
+
+    void put(float x, float y, float u, float v, uint32_t color) {
+        if (transformed) {
+            glm::vec4 p = transform * glm::vec4(x, y, 0.0f, 1.0f);
+            x = p.x;
+            y = p.y;
+        }
+        Batch2DVertex vertex = { x, y, u, v, color };
+        pending.push_back(vertex);
+    }
+
+    void bindState(GLuint vertexArray, GLuint tex) {
+        glUseProgram(program);
+        glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, tex ? tex : whiteTex);
+        glBindVertexArray(vertexArray);
+    }
+
+public:
+    Batch2D() : program(0), vao(0), vbo(0), whiteTex(0), projectionLoc(-1), projection(1.0f), transform(1.0f),
+                transformed(false), capacity(0), offset(0), mode(GL_TRIANGLES), texture(0) {}
+
+    // Shader, VAO e anel de 'vertices' vértices (o lote nunca passa disso);
+    // precisa do contexto OpenGL. Falso se o shader não compila
+    bool init(size_t vertices = 1 << 18) {
+        const char *vertexSource = R"(
+#version 330 core
+layout (location = 0) in vec2 position;
+layout (location = 1) in vec2 texCoord;
+layout (location = 2) in vec4 color;
+uniform mat4 projection;
+out vec2 vTexCoord;
+out vec4 vColor;
+void main()
+{
+    gl_Position = projection * vec4(position, 0.0, 1.0);
+    vTexCoord = texCoord;
+    vColor = color;
+}
+)";
+        // sem textura o lote usa uma branca de 1 texel: o mesmo shader serve
+        const char *fragmentSource = R"(
+#version 330 core
+in vec2 vTexCoord;
+in vec4 vColor;
+uniform sampler2D tex;
+out vec4 fragColor;
+void main()
+{
+    fragColor = vColor * texture(tex, vTexCoord);
+}
+)";
+        program = batch2DProgram("Batch2D", vertexSource, fragmentSource);
+        if (!program) return false;
+        projectionLoc = glGetUniformLocation(program, "projection");
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "tex"), 0);
+
+        glGenTextures(1, &whiteTex);
+        glBindTexture(GL_TEXTURE_2D, whiteTex);
+        const unsigned char white[4] = { 255, 255, 255, 255 };
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        capacity = vertices < 6 ? 6 : vertices;
+        pending.reserve(capacity);
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Batch2DVertex), NULL, GL_STREAM_DRAW);
+        batch2DLayout();
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return true;
+    }
+
+    // Começa um quadro: projeção das coordenadas das formas, sem
+    // transformação nem textura, contadores zerados
+    void begin(const glm::mat4 &projection) {
+        this->projection = projection;
+        resetTransform();
+        texture = 0;
+        counters = Batch2DStats();
+    }
+
+    void end() {
+        flush();
+    }
+
+    const Batch2DStats &stats() const {
+        return counters;
+    }
+
+    // Matriz de modelo aplicada (na CPU) às formas seguintes; não descarrega
+    void setTransform(const glm::mat4 &model) {
+        transform = model;
+        transformed = true;
+    }
+
+    void resetTransform() {
+        transform = glm::mat4(1.0f);
+        transformed = false;
+    }
+
+    // Textura das formas seguintes (0: só a cor); descarrega se mudar
+    void setTexture(GLuint tex) {
+        if (tex == texture) return;
+        flush();
+        texture = tex;
+    }
+
+    void triangle(const glm::vec2 &a, const glm::vec2 &b, const glm::vec2 &c, const glm::vec4 &color) {
+        reserve(GL_TRIANGLES, 3);
+        uint32_t packed = batch2DColor(color);
+        put(a.x, a.y, 0, 0, packed);
+        put(b.x, b.y, 0, 0, packed);
+        put(c.x, c.y, 0, 0, packed);
+    }
+
+    // Quadrilátero p0 p1 p2 p3 (em ordem ao redor), com a textura inteira:
+    // (0,0) em p0 até (1,1) em p2
+    void quad(const glm::vec2 &p0, const glm::vec2 &p1, const glm::vec2 &p2, const glm::vec2 &p3, const glm::vec4 &color) {
+        reserve(GL_TRIANGLES, 6);
+        uint32_t packed = batch2DColor(color);
+        put(p0.x, p0.y, 0, 0, packed);
+        put(p1.x, p1.y, 1, 0, packed);
+        put(p2.x, p2.y, 1, 1, packed);
+        put(p0.x, p0.y, 0, 0, packed);
+        put(p2.x, p2.y, 1, 1, packed);
+        put(p3.x, p3.y, 0, 1, packed);
+    }
+
+    // Retângulo alinhado aos eixos de 'min' a 'max'
+    void rect(const glm::vec2 &min, const glm::vec2 &max, const glm::vec4 &color) {
+        quad(min, glm::vec2(max.x, min.y), max, glm::vec2(min.x, max.y), color);
+    }
+
+    void line(const glm::vec2 &a, const glm::vec2 &b, const glm::vec4 &color) {
+        reserve(GL_LINES, 2);
+        uint32_t packed = batch2DColor(color);
+        put(a.x, a.y, 0, 0, packed);
+        put(b.x, b.y, 0, 0, packed);
+    }
+
+    void point(const glm::vec2 &p, const glm::vec4 &color) {
+        reserve(GL_POINTS, 1);
+        put(p.x, p.y, 0, 0, batch2DColor(color));
+    }
+
+    // Desenha o que está acumulado em uma chamada
+    void flush() {
+        if (pending.empty()) return;
+        size_t n = pending.size(), sz = sizeof(Batch2DVertex);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        if (offset + n > capacity) {
+            glBufferData(GL_ARRAY_BUFFER, capacity * sz, NULL, GL_STREAM_DRAW);
+            offset = 0;
+            counters.wraps++;
+        }
+        void *dst = glMapBufferRange(GL_ARRAY_BUFFER, offset * sz, n * sz,
+                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (dst) {
+            memcpy(dst, pending.data(), n * sz);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        } else {
+            glBufferSubData(GL_ARRAY_BUFFER, offset * sz, n * sz, pending.data());
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        bindState(vao, texture);
+        glDrawArrays(mode, (GLint)offset, (GLsizei)n);
+        glBindVertexArray(0);
+        offset += n;
+        counters.drawCalls++;
+        counters.vertices += n;
+        pending.clear();
+    }
+
+    // Desenha as formas guardadas em 'buffer' (enviando as novas) em uma
+    // chamada, na ordem certa em relação ao que já está no lote
+    void draw(Batch2DBuffer &buffer) {
+        flush();
+        GLuint bufferVAO = buffer.upload();
+        if (buffer.size() == 0) return;
+        bindState(bufferVAO, 0);
+        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)buffer.size());
+        glBindVertexArray(0);
+        counters.drawCalls++;
+        counters.vertices += buffer.size();
+    }
+};
+
+#endif /* Batch2D_h */
@@ -0,0 +1,453 @@
+//
+//  Bvh2D.h
+//
+//  Seleção de triângulos por ponto ou retângulo em cenas grandes: em vez de
+//  testar todos os triângulos a cada clique ou movimento do mouse (como um
+//  laço com triangleCollidePoint2D do ltMath), uma hierarquia de caixas
+//  (BVH) construída por SAH em faixas (binned) descarta de uma vez os
+//  grupos cujas caixas não tocam a consulta.
+//
+//  Nas folhas os triângulos ficam em estrutura de arrays, na ordem da
+//  árvore, e são testados em lote por trianglesTouchRect: um laço sem
+//  desvios que o compilador vetoriza. Um ponto é um retângulo de largura
+//  zero, então as duas consultas usam o mesmo núcleo.
+//
+//  Edições não reconstroem nada na hora: mover um triângulo só reajusta
+//  (refit) as caixas da folha até a raiz, e triângulos novos ficam em uma
+//  faixa de pendentes testada por varredura. Quando os pendentes ou os
+//  reajustes acumulam, update() reconstrói a árvore em uma thread
+//  separada, a partir de uma cópia dos triângulos, e adota a nova quando
+//  fica pronta, reaplicando as edições feitas nesse meio-tempo.
+//
+
+#ifndef Bvh2D_h
+#define Bvh2D_h
+
+#include <float.h>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+using namespace std;
+
+struct Bvh2DBox {
+    float minX, minY, maxX, maxY;
+
+    Bvh2DBox() : minX(FLT_MAX), minY(FLT_MAX), maxX(-FLT_MAX), maxY(-FLT_MAX) {}
+
+    void grow(float x, float y) {
+        minX = x < minX ? x : minX;
+        minY = y < minY ? y : minY;
+        maxX = x > maxX ? x : maxX;
+        maxY = y > maxY ? y : maxY;
+    }
+
+    void grow(const Bvh2DBox &b) {
+        minX = b.minX < minX ? b.minX : minX;
+        minY = b.minY < minY ? b.minY : minY;
+        maxX = b.maxX > maxX ? b.maxX : maxX;
+        maxY = b.maxY > maxY ? b.maxY : maxY;
+    }
+
+    bool overlaps(float x0, float y0, float x1, float y1) const {
+        return minX <= x1 && maxX >= x0 && minY <= y1 && maxY >= y0;
+    }
+
+    // o SAH em 2D usa o perímetro no lugar da área da superfície
+    float perimeter() const {
+        return maxX < minX ? 0.0f : (maxX - minX) + (maxY - minY);
+    }
+};
+
+// Triângulos em estrutura de arrays, sempre com a mesma orientação
+// (b - a) x (c - a) >= 0, para o interior ficar do mesmo lado das arestas
+struct Bvh2DTriangles {
+    vector<float> ax, ay, bx, by, cx, cy;
+
+    size_t size() const {
+        return ax.size();
+    }
+
+    void resize(size_t n) {
+        ax.resize(n); ay.resize(n);
+        bx.resize(n); by.resize(n);
+        cx.resize(n); cy.resize(n);
+    }
+
+    void set(size_t i, const glm::vec2 &a, glm::vec2 b, glm::vec2 c) {
+        if ((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x) < 0) swap(b, c);
+        ax[i] = a.x; ay[i] = a.y;
+        bx[i] = b.x; by[i] = b.y;
+        cx[i] = c.x; cy[i] = c.y;
+    }
+
+    void copy(size_t i, const Bvh2DTriangles &from, size_t j) {
+        ax[i] = from.ax[j]; ay[i] = from.ay[j];
+        bx[i] = from.bx[j]; by[i] = from.by[j];
+        cx[i] = from.cx[j]; cy[i] = from.cy[j];
+    }
+
+    Bvh2DBox box(size_t i) const {
+        Bvh2DBox b;
+        b.grow(ax[i], ay[i]);
+        b.grow(bx[i], by[i]);
+        b.grow(cx[i], cy[i]);
+        return b;
+    }
+};
+
+// maior valor da função da aresta p -> q (positiva do lado de dentro) no
+// retângulo: o canto escolhido é o que fica mais para dentro
+inline float bvh2DEdgeMax(float px, float py, float qx, float qy, float x0, float y0, float x1, float y1) {
+    float x = qy < py ? x1 : x0;
+    float y = qx > px ? y1 : y0;
+    return (qx - px) * (y - py) - (qy - py) * (x - px);
+}
+
+// Núcleo em lote: hit[k] = 1 se o triângulo first + k toca o retângulo
+// [x0, x1] x [y0, y1], para k < n. Eixos separadores em 2D: os dois do
+// retângulo (caixas) e as normais das três arestas do triângulo
+inline void trianglesTouchRect(const Bvh2DTriangles &t, size_t first, size_t n,
+                               float x0, float y0, float x1, float y1, unsigned char *hit) {
+    const float *ax = &t.ax[first], *ay = &t.ay[first];
+    const float *bx = &t.bx[first], *by = &t.by[first];
+    const float *cx = &t.cx[first], *cy = &t.cy[first];
+    for (size_t k = 0; k < n; k++) {
+        float e0 = bvh2DEdgeMax(ax[k], ay[k], bx[k], by[k], x0, y0, x1, y1);
+        float e1 = bvh2DEdgeMax(bx[k], by[k], cx[k], cy[k], x0, y0, x1, y1);
+        float e2 = bvh2DEdgeMax(cx[k], cy[k], ax[k], ay[k], x0, y0, x1, y1);
+        float minX = std::min(ax[k], std::min(bx[k], cx[k])), maxX = std::max(ax[k], std::max(bx[k], cx[k]));
+        float minY = std::min(ay[k], std::min(by[k], cy[k])), maxY = std::max(ay[k], std::max(by[k], cy[k]));
+        hit[k] = (unsigned char)((e0 >= 0) & (e1 >= 0) & (e2 >= 0) &
+                                 (minX <= x1) & (maxX >= x0) & (minY <= y1) & (maxY >= y0));
+    }
+}
+
+struct Bvh2DNode {
+    Bvh2DBox box;
+    int first;                      // folha: primeira posição; interno: filho da esquerda (o direito é first + 1)
+    int count;                      // triângulos na folha; 0 em nó interno
+};
+
+// Uma árvore pronta sobre os ids 0..size-1, com cópia própria dos triângulos
+struct Bvh2DTree {
+    vector<Bvh2DNode> nodes;
+    vector<int> parent;
+    Bvh2DTriangles tris;            // na ordem das folhas
+    vector<int> ids;                // id de cada posição
+    vector<int> slot;               // posição de cada id
+    vector<int> leaf;               // folha de cada posição
+    size_t size;
+
+    static const int BINS = 16;
+    static const int MIN_LEAF = 4;  // abaixo disso não compensa dividir
+    static const int MAX_LEAF = 16; // acima disso divide mesmo se o SAH não quiser
+    static constexpr float TRAVERSAL = 2.0f; // custo de visitar um nó, em testes de triângulo
+
+    Bvh2DTree() : size(0) {}
+
+    void build(const Bvh2DTriangles &source, size_t n) {
+        size = n;
+        nodes.clear();
+        parent.clear();
+        ids.resize(n);
+        vector<Bvh2DBox> boxes(n);
+        vector<float> centers(2 * n);
+        for (size_t i = 0; i < n; i++) {
+            ids[i] = (int)i;
+            boxes[i] = source.box(i);
+            centers[2 * i] = 0.5f * (boxes[i].minX + boxes[i].maxX);
+            centers[2 * i + 1] = 0.5f * (boxes[i].minY + boxes[i].maxY);
+        }
+
+        Bvh2DNode root;
+        root.first = 0;
+        root.count = (int)n;
+        nodes.push_back(root);
+        parent.push_back(-1);
+        vector<int> stack(1, 0);
+        while (!stack.empty()) {
+            int k = stack.back();
+            stack.pop_back();
+            int first = nodes[k].first, count = nodes[k].count;
+            Bvh2DBox box, centerBox;
+            for (int i = first; i < first + count; i++) {
+                box.grow(boxes[ids[i]]);
+                centerBox.grow(centers[2 * ids[i]], centers[2 * ids[i] + 1]);
+            }
+            nodes[k].box = box;
+
+            int mid = split(first, count, box, centerBox, boxes, centers);
+            if (mid < 0) continue;
+            Bvh2DNode left, right;
+            left.first = first;
+            left.count = mid - first;
+            right.first = mid;
+            right.count = first + count - mid;
+            nodes[k].first = (int)nodes.size();
+            nodes[k].count = 0;
+            nodes.push_back(left);
+            nodes.push_back(right);
+            parent.push_back(k);
+            parent.push_back(k);
+            stack.push_back(nodes[k].first);
+            stack.push_back(nodes[k].first + 1);
+        }
+
+        tris.resize(n);
+        slot.resize(n);
+        leaf.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            tris.copy(i, source, ids[i]);
+            slot[ids[i]] = (int)i;
+        }
+        for (size_t k = 0; k < nodes.size(); k++) {
+            if (!nodes[k].count) continue;
+            for (int i = nodes[k].first; i < nodes[k].first + nodes[k].count; i++) leaf[i] = (int)k;
+        }
+    }
+
+    // Troca o triângulo 'id' e reajusta as caixas da folha até a raiz
+    void refit(int id, const Bvh2DTriangles &source) {
+        int pos = slot[id];
+        tris.copy(pos, source, id);
+        int k = leaf[pos];
+        Bvh2DBox box;
+        for (int i = nodes[k].first; i < nodes[k].first + nodes[k].count; i++) box.grow(tris.box(i));
+        nodes[k].box = box;
+        for (k = parent[k]; k >= 0; k = parent[k]) {
+            Bvh2DBox b = nodes[nodes[k].first].box;
+            b.grow(nodes[nodes[k].first + 1].box);
+            nodes[k].box = b;
+        }
+    }
+
+private:
+    // Posição que divide ids[first..first+count) em dois, ou -1 para folha
+    int split(int first, int count, const Bvh2DBox &box, const Bvh2DBox &centerBox,
+              const vector<Bvh2DBox> &boxes, const vector<float> &centers) {
+        if (count <= MIN_LEAF) return -1;
+        float bestCost = FLT_MAX;
+        int bestAxis = -1, bestBin = 0;
+        float lo[2] = { centerBox.minX, centerBox.minY };
+        float extent[2] = { centerBox.maxX - centerBox.minX, centerBox.maxY - centerBox.minY };
+        for (int axis = 0; axis < 2; axis++) {
+            if (extent[axis] <= 0) continue;
+            Bvh2DBox binBox[BINS];
+            int binCount[BINS] = { 0 };
+            float scale = BINS / extent[axis];
+            for (int i = first; i < first + count; i++) {
+                int b = bin(centers[2 * ids[i] + axis], lo[axis], scale);
+                binCount[b]++;
+                binBox[b].grow(boxes[ids[i]]);
+            }
+            // varredura da direita guarda o custo de cada lado direito
+            float rightCost[BINS];
+            Bvh2DBox right;
+            int rightCount = 0;
+            for (int b = BINS - 1; b > 0; b--) {
+                right.grow(binBox[b]);
+                rightCount += binCount[b];
+                rightCost[b] = rightCount * right.perimeter();
+            }
+            Bvh2DBox left;
+            int leftCount = 0;
+            for (int b = 0; b < BINS - 1; b++) {
+                left.grow(binBox[b]);
+                leftCount += binCount[b];
+                if (leftCount == 0 || leftCount == count) continue;
+                float cost = leftCount * left.perimeter() + rightCost[b + 1];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+
+        float leafCost = count * box.perimeter();
+        bool worth = bestAxis >= 0 && TRAVERSAL * box.perimeter() + bestCost < leafCost;
+        if (!worth && count <= MAX_LEAF) return -1;
+        if (bestAxis < 0) return first + count / 2; // centros iguais: divide ao meio
+
+        float scale = BINS / extent[bestAxis];
+        int *mid = std::partition(&ids[first], &ids[first] + count, [&](int id) {
+            return bin(centers[2 * id + bestAxis], lo[bestAxis], scale) <= bestBin;
+        });
+        return (int)(mid - &ids[0]);
+    }
+
+    static int bin(float center, float lo, float scale) {
+        int b = (int)((center - lo) * scale);
+        return b < 0 ? 0 : (b >= BINS ? BINS - 1 : b);
+    }
+};
+
+class Bvh2D {
+    Bvh2DTriangles tris;            // todos, por id
+    unique_ptr<Bvh2DTree> tree;     // ids abaixo de tree->size; os demais são pendentes
+    size_t refits;                  // reajustes desde a construção da árvore atual
+
+    // reconstrução em segundo plano
+    thread worker;
+    unique_ptr<Bvh2DTree> next;
+    atomic<bool> nextReady;
+    bool building;
+    vector<int> editedWhileBuilding;
+
+    vector<unsigned char> hit;      // rascunho do núcleo
+    vector<int> stack, found;
+
+    // testa os triângulos das posições [first, first + n) de 't' e guarda
+    // os ids (pelo mapa 'ids', ou a própria posição) dos que tocam
+    void collect(const Bvh2DTriangles &t, size_t first, size_t n, const int *ids,
+                 float x0, float y0, float x1, float y1, vector<int> &out) {
+        if (hit.size() < n) hit.resize(n);
+        trianglesTouchRect(t, first, n, x0, y0, x1, y1, &hit[0]);
+        for (size_t k = 0; k < n; k++) {
+            if (hit[k]) out.push_back(ids ? ids[first + k] : (int)(first + k));
+        }
+    }
+
+    void join() {
+        if (worker.joinable()) worker.join();
+    }
+
+public:
+    Bvh2D() : tree(new Bvh2DTree()), refits(0), nextReady(false), building(false) {}
+
+    ~Bvh2D() {
+        join();
+    }
+
+    size_t size() const {
+        return tris.size();
+    }
+
+    bool rebuilding() const {
+        return building;
+    }
+
+    // Acrescenta um triângulo e devolve o id dele (0, 1, 2...); até a
+    // próxima reconstrução ele é testado por varredura
+    int add(const glm::vec2 &a, const glm::vec2 &b, const glm::vec2 &c) {
+        size_t id = tris.size();
+        tris.resize(id + 1);
+        tris.set(id, a, b, c);
+        return (int)id;
+    }
+
+    // Move o triângulo 'id': só reajusta as caixas acima dele
+    void set(int id, const glm::vec2 &a, const glm::vec2 &b, const glm::vec2 &c) {
+        tris.set(id, a, b, c);
+        if ((size_t)id < tree->size) {
+            tree->refit(id, tris);
+            refits++;
+        }
+        if (building) editedWhileBuilding.push_back(id);
+    }
+
+    // Esquece todos os triângulos (e uma reconstrução em andamento)
+    void clear() {
+        join();
+        building = false;
+        nextReady = false;
+        editedWhileBuilding.clear();
+        tris = Bvh2DTriangles();
+        tree.reset(new Bvh2DTree());
+        next.reset();
+        refits = 0;
+    }
+
+    // Constrói a árvore agora, nesta thread (para a cena inicial)
+    void build() {
+        join();
+        building = false;
+        nextReady = false;
+        editedWhileBuilding.clear();
+        tree->build(tris, tris.size());
+        refits = 0;
+    }
+
+    // Chamar uma vez por quadro: adota a árvore reconstruída se estiver
+    // pronta e dispara outra reconstrução quando pendentes ou reajustes
+    // passam de uma fração da árvore
+    void update() {
+        if (building && nextReady) {
+            join();
+            building = false;
+            nextReady = false;
+            tree.swap(next);
+            next.reset();
+            refits = 0;
+            for (size_t i = 0; i < editedWhileBuilding.size(); i++) {
+                int id = editedWhileBuilding[i];
+                if ((size_t)id < tree->size) {
+                    tree->refit(id, tris);
+                    refits++;
+                }
+            }
+            editedWhileBuilding.clear();
+        }
+        if (building) return;
+
+        size_t indexed = tree->size, pending = tris.size() - indexed;
+        if (pending > 64 + indexed / 8 || refits > 64 + indexed / 2) rebuild();
+    }
+
+    // Começa a reconstruir em outra thread; as consultas seguem na árvore
+    // atual até update() adotar a nova
+    void rebuild() {
+        if (building) return;
+        building = true;
+        nextReady = false;
+        Bvh2DTriangles snapshot = tris;
+        next.reset(new Bvh2DTree());
+        Bvh2DTree *target = next.get();
+        worker = thread([this, target, snapshot = move(snapshot)] {
+            target->build(snapshot, snapshot.size());
+            nextReady = true;
+        });
+    }
+
+    // Ids de todos os triângulos que tocam o retângulo, em ordem crescente
+    void queryRect(const glm::vec2 &min, const glm::vec2 &max, vector<int> &out) {
+        out.clear();
+        float x0 = std::min(min.x, max.x), x1 = std::max(min.x, max.x);
+        float y0 = std::min(min.y, max.y), y1 = std::max(min.y, max.y);
+        const Bvh2DTree &t = *tree;
+        if (t.size > 0) {
+            stack.clear();
+            stack.push_back(0);
+            while (!stack.empty()) {
+                const Bvh2DNode &node = t.nodes[stack.back()];
+                stack.pop_back();
+                if (!node.box.overlaps(x0, y0, x1, y1)) continue;
+                if (node.count) {
+                    collect(t.tris, node.first, node.count, &t.ids[0], x0, y0, x1, y1, out);
+                } else {
+                    stack.push_back(node.first);
+                    stack.push_back(node.first + 1);
+                }
+            }
+            sort(out.begin(), out.end());
+        }
+        if (tris.size() > t.size) collect(tris, t.size, tris.size() - t.size, NULL, x0, y0, x1, y1, out);
+    }
+
+    void queryPoint(const glm::vec2 &p, vector<int> &out) {
+        queryRect(p, p, out);
+    }
+
+    // Triângulo de cima (o último criado) que contém p, ou -1
+    int pick(const glm::vec2 &p) {
+        queryRect(p, p, found);
+        return found.empty() ? -1 : found.back();
+    }
+};
+
+#endif /* Bvh2D_h */
@@ -0,0 +1,63 @@
+//
+//  GLContext.h
+//
+//  Contexto OpenGL 3.3 sem janela na tela, para quem só desenha em
+//  framebuffers e lê o resultado (filtros na GPU, gravação de quadros):
+//  janela invisível na plataforma normal ou, sem display, a plataforma nula
+//  da GLFW 3.4 com OSMesa (llvmpipe).
+//
+
+#ifndef GLContext_h
+#define GLContext_h
+
+#include <iostream>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+using namespace std;
+
+inline GLFWwindow *glTryHiddenWindow(int contextApi) {
+    glfwDefaultWindowHints();
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, contextApi);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+    return glfwCreateWindow(16, 16, "GLContext", NULL, NULL);
+}
+
+// Cria o contexto, torna-o corrente e carrega a GLAD. Retorna NULL (e a
+// GLFW finalizada) se nem a janela invisível nem o OSMesa derem certo.
+inline GLFWwindow *glCreateHiddenContext() {
+    GLFWwindow *window = NULL;
+    if (glfwInit()) {
+        window = glTryHiddenWindow(GLFW_NATIVE_CONTEXT_API);
+        if (!window) glfwTerminate();
+    }
+#ifdef GLFW_PLATFORM_NULL
+    if (!window) {
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+        if (glfwInit()) {
+            window = glTryHiddenWindow(GLFW_OSMESA_CONTEXT_API);
+            if (!window) glfwTerminate();
+        }
+        glfwInitHint(GLFW_PLATFORM, GLFW_ANY_PLATFORM);
+    }
+#endif
+    if (!window) {
+        cerr << "Sem contexto OpenGL 3.3 (nem janela invisível nem OSMesa)" << endl;
+        return NULL;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        cerr << "Falha ao carregar as funções OpenGL" << endl;
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return NULL;
+    }
+    return window;
+}
+
+#endif /* GLContext_h */
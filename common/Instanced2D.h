@@ -0,0 +1,192 @@
+//
+//  Instanced2D.h
+//
+//  Desenho instanciado de muitas cópias de um mesmo triângulo: em vez de
+//  uma matriz de modelo por forma (montada na CPU e enviada com
+//  glUniformMatrix4fv, ou aplicada vértice a vértice pelo Batch2D), cada
+//  instância guarda só posição, dimensões, rotação e cor (28 bytes, contra
+//  64 de uma mat4) e o vertex shader compõe translação * rotação * escala.
+//
+//  As instâncias ficam em um VBO persistente que cresce dobrando; só o
+//  trecho alterado desde o último desenho (as formas criadas ou editadas
+//  por cliques) é reenviado. A rotação pode ter velocidade angular, e o
+//  giro é calculado no shader a partir do tempo: animar não envia nada.
+//
+
+#ifndef Instanced2D_h
+#define Instanced2D_h
+
+#include "Batch2D.h"
+
+// Uma instância: centro, largura e altura, ângulo (radianos) e velocidade
+// angular (radianos por segundo), cor RGBA8
+struct Instance2D {
+    float x, y;
+    float width, height;
+    float angle, spin;
+    uint32_t color;
+};
+
+inline Instance2D instance2D(const glm::vec2 &position, const glm::vec2 &dimensions, float degrees,
+                             const glm::vec4 &color, float spin = 0.0f) {
+    Instance2D instance = { position.x, position.y, dimensions.x, dimensions.y,
+                            glm::radians(degrees), spin, batch2DColor(color) };
+    return instance;
+}
+
+class Instanced2D {
+    GLuint program, vao, shapeVBO, instanceVBO;
+    GLint projectionLoc, timeLoc;
+    vector<Instance2D> instances;
+    size_t capacity;                // instâncias que cabem no VBO
+    size_t dirtyBegin, dirtyEnd;    // trecho a reenviar: [begin, end)
+    size_t uploaded;                // bytes enviados no último draw
+
+    void touch(size_t i) {
+        if (dirtyBegin >= dirtyEnd) {
+            dirtyBegin = i;
+            dirtyEnd = i + 1;
+        } else {
+            dirtyBegin = i < dirtyBegin ? i : dirtyBegin;
+            dirtyEnd = i + 1 > dirtyEnd ? i + 1 : dirtyEnd;
+        }
+    }
+
+    // Envia o trecho alterado, ou tudo em um buffer com o dobro da
+    // capacidade quando as instâncias não cabem mais
+    void upload() {
+        uploaded = 0;
+        size_t sz = sizeof(Instance2D);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        if (instances.size() > capacity) {
+            capacity = instances.size() > 2 * capacity ? instances.size() : 2 * capacity;
+            glBufferData(GL_ARRAY_BUFFER, capacity * sz, NULL, GL_DYNAMIC_DRAW);
+            dirtyBegin = 0;
+            dirtyEnd = instances.size();
+        }
+        if (dirtyBegin < dirtyEnd) {
+            glBufferSubData(GL_ARRAY_BUFFER, dirtyBegin * sz, (dirtyEnd - dirtyBegin) * sz, &instances[dirtyBegin]);
+            uploaded = (dirtyEnd - dirtyBegin) * sz;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        dirtyBegin = dirtyEnd = 0;
+    }
+
+public:
+    Instanced2D() : program(0), vao(0), shapeVBO(0), instanceVBO(0), projectionLoc(-1), timeLoc(-1),
+                    capacity(0), dirtyBegin(0), dirtyEnd(0), uploaded(0) {}
+
+    // Shader, VAO e o triângulo a, b, c (coordenadas locais, escaladas
+    // pelas dimensões de cada instância); precisa do contexto OpenGL
+    bool init(const glm::vec2 &a = glm::vec2(-0.5f, -0.5f), const glm::vec2 &b = glm::vec2(0.5f, -0.5f),
+              const glm::vec2 &c = glm::vec2(0.0f, 0.5f)) {
+        const char *vertexSource = R"(
+#version 330 core
+layout (location = 0) in vec2 position;
+layout (location = 1) in vec4 placement;   // centro xy, dimensões zw
+layout (location = 2) in vec2 rotation;    // ângulo, velocidade angular
+layout (location = 3) in vec4 color;
+uniform mat4 projection;
+uniform float time;
+out vec4 vColor;
+void main()
+{
+    float a = rotation.x + rotation.y * time;
+    float c = cos(a), s = sin(a);
+    vec2 p = position * placement.zw;
+    p = vec2(c * p.x - s * p.y, s * p.x + c * p.y) + placement.xy;
+    gl_Position = projection * vec4(p, 0.0, 1.0);
+    vColor = color;
+}
+)";
+        const char *fragmentSource = R"(
+#version 330 core
+in vec4 vColor;
+out vec4 fragColor;
+void main()
+{
+    fragColor = vColor;
+}
+)";
+        program = batch2DProgram("Instanced2D", vertexSource, fragmentSource);
+        if (!program) return false;
+        projectionLoc = glGetUniformLocation(program, "projection");
+        timeLoc = glGetUniformLocation(program, "time");
+
+        GLfloat shape[] = { a.x, a.y, b.x, b.y, c.x, c.y };
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &shapeVBO);
+        glGenBuffers(1, &instanceVBO);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, shapeVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(shape), shape, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (GLvoid *)0);
+        glEnableVertexAttribArray(0);
+
+        // atributos por instância: avançam uma vez por triângulo (divisor 1)
+        GLsizei stride = sizeof(Instance2D);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (GLvoid *)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (GLvoid *)(4 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribDivisor(2, 1);
+        glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (GLvoid *)(6 * sizeof(float)));
+        glEnableVertexAttribArray(3);
+        glVertexAttribDivisor(3, 1);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+        return true;
+    }
+
+    // Acrescenta uma instância e devolve o índice dela
+    size_t add(const Instance2D &instance) {
+        instances.push_back(instance);
+        touch(instances.size() - 1);
+        return instances.size() - 1;
+    }
+
+    // Troca a instância i; só ela é reenviada no próximo draw
+    void set(size_t i, const Instance2D &instance) {
+        instances[i] = instance;
+        touch(i);
+    }
+
+    const Instance2D &operator[](size_t i) const {
+        return instances[i];
+    }
+
+    size_t size() const {
+        return instances.size();
+    }
+
+    void reserve(size_t n) {
+        instances.reserve(n);
+    }
+
+    void clear() {
+        instances.clear();
+        dirtyBegin = dirtyEnd = 0;
+    }
+
+    // Bytes de instâncias enviados no último draw (0 se nada mudou)
+    size_t lastUpload() const {
+        return uploaded;
+    }
+
+    // Todas as instâncias em uma chamada; 'time' em segundos gira as que
+    // têm velocidade angular
+    void draw(const glm::mat4 &projection, float time = 0.0f) {
+        upload();
+        if (instances.empty()) return;
+        glUseProgram(program);
+        glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+        glUniform1f(timeLoc, time);
+        glBindVertexArray(vao);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 3, (GLsizei)instances.size());
+        glBindVertexArray(0);
+    }
+};
+
+#endif /* Instanced2D_h */
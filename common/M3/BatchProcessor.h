@@ -0,0 +1,448 @@
+//
+//  BatchProcessor.h
+//
+//  Modo em lote do exemplo_03: a mesma cadeia de filtros aplicada a muitos
+//  arquivos, sem perguntas pelo cin.
+//
+//  A cadeia vem de um texto ("key:0,255,0,0.4;gray;blur:2") e os arquivos
+//  de diretórios, padrões com * e ? ou nomes soltos. Cada arquivo passa por
+//  três estágios ligados por filas limitadas: threads de leitura carregam
+//  as próximas imagens, a thread que chamou filtra a atual (com todos os
+//  núcleos, via FilterExecutor) e threads de gravação salvam as anteriores.
+//  As filas limitam quantas imagens estão na memória ao mesmo tempo.
+//
+
+#ifndef BatchProcessor_h
+#define BatchProcessor_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+
+#include "PPM.h"
+#include "FilterExecutor.h"
+#include "FilterChain.h"
+#include "StreamProcessor.h"
+#include "Resample.h"
+
+using namespace std;
+
+// Lê os números de um parâmetro "a,b,c"; falso se não forem exatamente 'count'.
+inline bool batchNumbers(const string &args, double *v, int count) {
+    stringstream in(args);
+    string item;
+    int n = 0;
+    while (getline(in, item, ',')) {
+        if (n == count) return false;
+        char *end;
+        v[n] = strtod(item.c_str(), &end);
+        if (end == item.c_str() || *end != '\0') return false;
+        n++;
+    }
+    return n == count;
+}
+
+// Monta a cadeia a partir de passos separados por ';', cada um no formato
+// nome ou nome:parâmetros (separados por vírgula):
+//   key:r,g,b,tol[,suavidade,reflexo]   gray[:s]   colorize:r,g,b   negative
+//   brightness:delta   contrast:fator   gamma:g   blur:sigma   box:raio
+//   sharpen:sigma,intensidade   sobel   equalize[:rgb]   levels[:corte]
+//   clahe[:regiões,limite]
+inline bool parseFilterChain(const string &spec, FilterChain &chain) {
+    stringstream in(spec);
+    string step;
+    while (getline(in, step, ';')) {
+        if (step.empty()) continue;
+        size_t colon = step.find(':');
+        string name = step.substr(0, colon);
+        string args = colon == string::npos ? "" : step.substr(colon + 1);
+        double v[6];
+        bool ok = true;
+
+        if (name == "key") {
+            if (batchNumbers(args, v, 6)) {
+                chain.softChromaKey((int)v[0], (int)v[1], (int)v[2], v[3], v[4], v[5]);
+            } else if ((ok = batchNumbers(args, v, 4))) {
+                chain.chromaKey((int)v[0], (int)v[1], (int)v[2], v[3]);
+            }
+        } else if (name == "gray") {
+            ok = args.empty() || args == "s";
+            chain.grayScale(args.empty());
+        } else if (name == "colorize") {
+            if ((ok = batchNumbers(args, v, 3))) chain.colorize((int)v[0], (int)v[1], (int)v[2]);
+        } else if (name == "negative") {
+            ok = args.empty();
+            chain.negative();
+        } else if (name == "brightness") {
+            if ((ok = batchNumbers(args, v, 1))) chain.brightness((int)v[0]);
+        } else if (name == "contrast") {
+            if ((ok = batchNumbers(args, v, 1))) chain.contrast(v[0]);
+        } else if (name == "gamma") {
+            if ((ok = batchNumbers(args, v, 1) && v[0] > 0)) chain.gamma(v[0]);
+        } else if (name == "blur") {
+            if ((ok = batchNumbers(args, v, 1))) chain.gaussianBlur(v[0]);
+        } else if (name == "box") {
+            if ((ok = batchNumbers(args, v, 1))) chain.boxBlur((int)v[0]);
+        } else if (name == "sharpen") {
+            if ((ok = batchNumbers(args, v, 2))) chain.unsharpMask(v[0], v[1]);
+        } else if (name == "sobel") {
+            ok = args.empty();
+            chain.sobel();
+        } else if (name == "equalize") {
+            ok = args.empty() || args == "rgb";
+            chain.equalize(!args.empty());
+        } else if (name == "levels") {
+            if (args.empty()) {
+                chain.autoLevels();
+            } else if ((ok = batchNumbers(args, v, 1))) {
+                chain.autoLevels(v[0]);
+            }
+        } else if (name == "clahe") {
+            if (args.empty()) {
+                chain.clahe();
+            } else if ((ok = batchNumbers(args, v, 2) && v[0] >= 1)) {
+                chain.clahe((int)v[0], v[1]);
+            }
+        } else {
+            cerr << "Filtro desconhecido: " << name << endl;
+            return false;
+        }
+        if (!ok) {
+            cerr << "Parâmetros inválidos em '" << step << "'" << endl;
+            return false;
+        }
+    }
+    if (chain.empty()) {
+        cerr << "Nenhum filtro em '" << spec << "'" << endl;
+        return false;
+    }
+    return true;
+}
+
+// '*' casa qualquer sequência e '?' um caractere
+inline bool batchMatch(const char *pattern, const char *name) {
+    const char *star = NULL, *resume = NULL;
+    while (*name) {
+        if (*pattern == '?' || *pattern == *name) {
+            pattern++;
+            name++;
+        } else if (*pattern == '*') {
+            star = pattern++;
+            resume = name;
+        } else if (star) {
+            pattern = star + 1;
+            name = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*') pattern++;
+    return *pattern == '\0';
+}
+
+inline bool isNetpbmFile(const filesystem::path &p) {
+    string ext = p.extension().string();
+    transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".ppm" || ext == ".pgm" || ext == ".pnm";
+}
+
+// Expande um diretório (os .ppm/.pgm/.pnm dele), um padrão com * ou ? no
+// nome do arquivo ou um nome de arquivo. Acrescenta em 'files', ordenado.
+inline bool listInputs(const string &input, vector<string> &files) {
+    namespace fs = filesystem;
+    error_code ec;
+    vector<string> found;
+    fs::path path(input);
+
+    if (fs::is_directory(path, ec)) {
+        for (fs::directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->is_regular_file(ec) && isNetpbmFile(it->path())) found.push_back(it->path().string());
+        }
+    } else if (input.find_first_of("*?") != string::npos) {
+        fs::path dir = path.parent_path();
+        string pattern = path.filename().string();
+        for (fs::directory_iterator it(dir.empty() ? fs::path(".") : dir, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->is_regular_file(ec) && batchMatch(pattern.c_str(), it->path().filename().string().c_str())) {
+                found.push_back(it->path().string());
+            }
+        }
+    } else if (fs::is_regular_file(path, ec)) {
+        found.push_back(input);
+    }
+    if (ec) {
+        cerr << input << ": " << ec.message() << endl;
+        return false;
+    }
+    if (found.empty()) {
+        cerr << input << ": nenhuma imagem encontrada" << endl;
+        return false;
+    }
+    sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+    return true;
+}
+
+struct BatchOptions {
+    string outputDir;           // onde gravar (mesmo nome, extensão .ppm)
+    int readers;                // threads de leitura
+    int writers;                // threads de gravação
+    int inFlight;               // imagens esperando entre dois estágios
+    long long streamThreshold;  // arquivos maiores são filtrados em faixas
+    const char *comment;
+    bool quiet;                 // sem uma linha por arquivo
+    int width, height;          // redimensiona antes dos filtros (resampleSize); 0 e 0 mantém
+    ResampleFilter filter;
+
+    BatchOptions() : readers(2), writers(2), inFlight(4), streamThreshold(512LL * 1024 * 1024),
+                     comment(NULL), quiet(false), width(0), height(0), filter(RESAMPLE_BICUBIC) {}
+};
+
+// Tamanho de saída "LxA", opcionalmente com o filtro ("320x240:lanczos"):
+// exatamente L x A, ou com uma das medidas 0 ela segue a proporção da imagem.
+inline bool parseResize(const string &spec, BatchOptions &opt) {
+    string size = spec, filter;
+    size_t colon = spec.find(':');
+    if (colon != string::npos) {
+        size = spec.substr(0, colon);
+        filter = spec.substr(colon + 1);
+    }
+    int w, h;
+    char x, extra;
+    if (sscanf(size.c_str(), "%d%c%d%c", &w, &x, &h, &extra) != 3 || (x != 'x' && x != 'X') || w < 0 || h < 0 ||
+        w + h == 0) {
+        cerr << "Tamanho inválido: '" << spec << "' (ex.: 320x240, 0x480)" << endl;
+        return false;
+    }
+    if (filter.empty() || filter == "bicubic") {
+        opt.filter = RESAMPLE_BICUBIC;
+    } else if (filter == "bilinear") {
+        opt.filter = RESAMPLE_BILINEAR;
+    } else if (filter == "lanczos") {
+        opt.filter = RESAMPLE_LANCZOS;
+    } else {
+        cerr << "Filtro de redimensionamento desconhecido: " << filter << endl;
+        return false;
+    }
+    opt.width = w;
+    opt.height = h;
+    return true;
+}
+
+struct BatchStats {
+    int files, failed;
+    double megapixels, megabytes;   // lidos
+    double seconds;                 // tempo total (parede)
+
+    BatchStats() : files(0), failed(0), megapixels(0), megabytes(0), seconds(0) {}
+};
+
+class BatchProcessor {
+    typedef chrono::steady_clock Clock;
+
+    struct Job {
+        string in, out;
+        PPMImage img;
+        bool stream, ok;
+        long long bytes;
+        double megapixels;      // lidos, antes de redimensionar
+        double readMs, computeMs, writeMs;
+    };
+
+    static double msSince(Clock::time_point t) {
+        return chrono::duration<double, milli>(Clock::now() - t).count();
+    }
+
+    // Puxa as páginas do mapeamento para a memória ainda na thread de
+    // leitura; sem isso o disco só seria lido durante os filtros.
+    static void prefault(const PPMImage &img) {
+        const volatile unsigned char *p = img.data();
+        size_t bytes = (size_t)img.width * img.height * img.channels * (img.maxval > 255 ? 2 : 1);
+        unsigned char sum = 0;
+        for (size_t i = 0; i < bytes; i += 4096) sum += p[i];
+        (void)sum;
+    }
+
+    FilterChain &chain;
+    FilterExecutor &exec;
+    BatchOptions opt;
+    mutex printMutex;
+
+    void report(const Job &j) {
+        if (opt.quiet) return;
+        lock_guard<mutex> lock(printMutex);
+        if (!j.ok) {
+            cout << j.in << ": FALHOU" << endl;
+            return;
+        }
+        double total = j.readMs + j.computeMs + j.writeMs;
+        double mp = j.megapixels;
+        printf("%s: leitura %.1f ms, filtros %.1f ms, gravação %.1f ms", j.in.c_str(), j.readMs, j.computeMs, j.writeMs);
+        if (j.stream) {
+            printf(" (em faixas, %.1f MB/s)\n", j.bytes / 1e3 / (total > 0 ? total : 1));
+        } else {
+            printf(" (%.1f MP/s nos filtros)\n", j.computeMs > 0 ? mp * 1e3 / j.computeMs : 0.0);
+        }
+    }
+
+    bool resizing() const {
+        return opt.width > 0 || opt.height > 0;
+    }
+
+    void resize(PPMImage &img) {
+        int w = opt.width, h = opt.height;
+        resampleSize(img.width, img.height, w, h);
+        if (w == img.width && h == img.height) return;
+        PPMImage out;
+        out.allocate(w, h, 3, 255);
+        resample(exec, ImageView<RGB8>(img.data(), img.width, img.height), ImageView<RGB8>(out.data(), w, h), opt.filter);
+        img = std::move(out);
+    }
+
+public:
+    BatchProcessor(FilterChain &chain, FilterExecutor &exec, const BatchOptions &opt = BatchOptions())
+        : chain(chain), exec(exec), opt(opt) {}
+
+    // Filtra todos os arquivos; falso se algum falhou (os outros seguem).
+    bool run(const vector<string> &files, BatchStats &stats) {
+        namespace fs = filesystem;
+        error_code ec;
+        if (!opt.outputDir.empty()) fs::create_directories(opt.outputDir, ec);
+        if (ec) {
+            cerr << "Erro ao criar " << opt.outputDir << ": " << ec.message() << endl;
+            return false;
+        }
+
+        int readers = opt.readers > 0 ? opt.readers : 1;
+        int writers = opt.writers > 0 ? opt.writers : 1;
+        size_t capacity = opt.inFlight > 0 ? opt.inFlight : 1;
+        BlockingQueue<Job *> ready(capacity), done(capacity);
+        atomic<size_t> next(0);
+        atomic<int> readersLeft(readers);
+        mutex statsMutex;
+        stats = BatchStats();
+        Clock::time_point start = Clock::now();
+
+        // entradas de diretórios (ou extensões) diferentes com o mesmo nome
+        // dariam a mesma saída: só a primeira é gravada, as outras falham
+        vector<string> outputs(files.size());
+        vector<size_t> owner(files.size());
+        map<string, size_t> taken;
+        for (size_t i = 0; i < files.size(); i++) {
+            fs::path out = fs::path(opt.outputDir.empty() ? "." : opt.outputDir) / fs::path(files[i]).filename();
+            out.replace_extension(".ppm");
+            outputs[i] = out.string();
+            owner[i] = taken.insert(make_pair(out.lexically_normal().string(), i)).first->second;
+        }
+
+        vector<thread> threads;
+        for (int r = 0; r < readers; r++) {
+            threads.push_back(thread([&] {
+                size_t i;
+                while ((i = next++) < files.size()) {
+                    Job *j = new Job();
+                    j->in = files[i];
+                    j->out = outputs[i];
+                    j->ok = true;
+                    j->stream = false;
+                    j->computeMs = j->writeMs = 0;
+                    j->megapixels = 0;
+
+                    Clock::time_point t = Clock::now();
+                    error_code e;
+                    j->bytes = (long long)fs::file_size(j->in, e);
+                    if (e) {
+                        cerr << "Erro ao abrir " << j->in << endl;
+                        j->ok = false;
+                    } else if (owner[i] != i) {
+                        cerr << j->in << ": a saída " << j->out << " já é de " << files[owner[i]] << endl;
+                        j->ok = false;
+                    } else if (fs::exists(j->out, e) && fs::equivalent(j->in, j->out, e)) {
+                        cerr << j->in << ": a saída seria o próprio arquivo de entrada" << endl;
+                        j->ok = false;
+                    } else {
+                        // ajustes automáticos e redimensionamento precisam da imagem inteira
+                        j->stream = j->bytes > opt.streamThreshold && !chain.wholeImage() && !resizing();
+                        if (!j->stream) {
+                            j->ok = readPPM(j->in, j->img);
+                            if (j->ok) {
+                                prefault(j->img);
+                                ppmToRGB8(j->img);
+                                j->megapixels = (double)j->img.width * j->img.height / 1e6;
+                            }
+                        }
+                    }
+                    j->readMs = msSince(t);
+                    ready.push(j);
+                }
+                if (--readersLeft == 0) ready.close();
+            }));
+        }
+        for (int w = 0; w < writers; w++) {
+            threads.push_back(thread([&] {
+                Job *j;
+                while (done.pop(j)) {
+                    if (j->ok && !j->stream) {
+                        Clock::time_point t = Clock::now();
+                        PPMWriteOptions wo;
+                        wo.comment = opt.comment;
+                        j->ok = writePPM(j->out, ppmView(j->img.data(), j->img.width, j->img.height), wo);
+                        j->writeMs = msSince(t);
+                    }
+                    report(*j);
+                    {
+                        lock_guard<mutex> lock(statsMutex);
+                        stats.files++;
+                        if (!j->ok) {
+                            stats.failed++;
+                        } else {
+                            stats.megabytes += j->bytes / 1e6;
+                            stats.megapixels += j->megapixels;
+                        }
+                    }
+                    delete j;
+                }
+            }));
+        }
+
+        // a thread que chamou filtra; o executor divide cada imagem entre os núcleos
+        Job *j;
+        while (ready.pop(j)) {
+            if (j->ok) {
+                Clock::time_point t = Clock::now();
+                if (j->stream) {
+                    PPMStreamOptions so;
+                    so.comment = opt.comment;
+                    j->ok = streamChain(j->in, j->out, chain, exec, so);
+                } else {
+                    if (resizing()) resize(j->img);
+                    chain.apply(exec, j->img.data(), j->img.width, j->img.height);
+                }
+                j->computeMs = msSince(t);
+            }
+            done.push(j);
+        }
+        done.close();
+        for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+
+        stats.seconds = chrono::duration<double>(Clock::now() - start).count();
+        return stats.failed == 0;
+    }
+};
+
+inline void printBatchStats(const BatchStats &s) {
+    double t = s.seconds > 0 ? s.seconds : 1e-9;
+    printf("%d arquivos (%d com erro) em %.2f s: %.1f arquivos/s, %.1f MP/s, %.1f MB/s\n",
+           s.files, s.failed, s.seconds, (s.files - s.failed) / t, s.megapixels / t, s.megabytes / t);
+}
+
+#endif /* BatchProcessor_h */
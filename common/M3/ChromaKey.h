@@ -0,0 +1,300 @@
+//
+//  ChromaKey.h
+//
+//  Chroma-key com máscara suave (canal alfa) e remoção do reflexo da cor-chave.
+//
+//  O cubo RGB é dividido em 32^3 (ou 64^3) células. Quase todas ficam
+//  inteiras dentro ou fora da chave: para elas a tabela guarda o alfa pronto
+//  e o pixel custa uma única consulta. Nas células de borda o alfa vem da
+//  distância exata à cor-chave, por uma segunda tabela indexada pelo
+//  quadrado da distância (inteiro), então não há sqrt por pixel e uma chave
+//  menor que a célula continua sendo recortada.
+//
+//  Remoção de reflexo: o canal dominante da cor-chave (o verde de uma tela
+//  verde) é puxado para o maior dos outros dois, o que tira a borda
+//  esverdeada que a luz rebatida deixa no objeto.
+//
+//  Com AVX2 as células de 8 pixels são buscadas de uma vez (gather), e as
+//  de borda fazem a conta da distância e a segunda busca também em lote.
+//
+
+#ifndef ChromaKey_h
+#define ChromaKey_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+
+#include "ImageFilters.h"
+#include "FilterExecutor.h"
+
+using namespace std;
+
+class ChromaKeyLUT {
+    static const unsigned char CELL_MIXED = 1;  // célula na borda da chave: usa a distância
+
+    int bits;                   // células por eixo = 1 << bits
+    int key[3];
+    vector<unsigned char> ramp;     // alfa pelo quadrado da distância à chave
+    int rampLast;                   // índice do último (255); distâncias maiores vão nele
+    vector<unsigned char> cells;    // alfa da célula inteira ou CELL_MIXED
+    int spillChannel;               // canal dominante da chave, -1 sem remoção
+    int spillAmount;                // 0..256
+
+    static double smoothStep(double e0, double e1, double x) {
+        if (x <= e0) return 0.0;
+        if (x >= e1) return 1.0;
+        double t = (x - e0) / (e1 - e0);
+        return t * t * (3.0 - 2.0 * t);
+    }
+
+    // quadrado da menor e da maior distância de 'key' a [lo, hi]
+    static void span(int key, int lo, int hi, int &nearest, int &farthest) {
+        int n = key < lo ? lo - key : (key > hi ? key - hi : 0);
+        int f = key - lo > hi - key ? key - lo : hi - key;
+        nearest = n * n;
+        farthest = f * f;
+    }
+
+    unsigned char rampAlpha(int d2) const {
+        return ramp[d2 < rampLast ? d2 : rampLast];
+    }
+
+public:
+    ChromaKeyLUT() : bits(0), key{0, 0, 0}, rampLast(0), spillChannel(-1), spillAmount(0) {}
+
+    // tolerance e softness são frações da maior distância possível no cubo
+    // RGB, como no chroma-key original: alfa é 0 até 'tolerance' e sobe
+    // suavemente até 1 em 'tolerance + softness'. spill vai de 0 (nada) a
+    // 1 (remove todo o excesso do canal dominante). bits = 5 ou 6.
+    void build(int r, int g, int b, double tolerance, double softness = 0.1, double spill = 1.0, int bits = 5) {
+        this->bits = bits < 4 ? 4 : (bits > 7 ? 7 : bits);
+        int n = 1 << this->bits;
+        int step = 256 >> this->bits;
+        key[0] = r;
+        key[1] = g;
+        key[2] = b;
+
+        // alfa para cada quadrado de distância até o raio externo; dali em
+        // diante é sempre 255 (3 bytes extras: o gather lê 32 bits)
+        const double dmax = sqrt(3.0) * 255.0;
+        double inner = tolerance * dmax;
+        double outer = (tolerance + (softness > 0 ? softness : 0)) * dmax;
+        double reach = outer > inner ? outer : inner;
+        rampLast = reach * reach < 3 * 255 * 255 ? (int)(reach * reach) + 1 : 3 * 255 * 255 + 1;
+        ramp.assign((size_t)rampLast + 4, 255);
+        for (int d2 = 0; d2 < rampLast; d2++) {
+            double d = sqrt((double)d2);
+            double a = outer > inner ? smoothStep(inner, outer, d) : (d < inner ? 0.0 : 1.0);
+            ramp[d2] = (unsigned char)(a * 255.0 + 0.5);
+        }
+
+        // o alfa cresce com a distância: a célula é uniforme quando o ponto
+        // mais próximo e o mais distante da chave têm o mesmo alfa
+        cells.assign((size_t)n * n * n + 3, 0);
+        int nr[256], fr[256], ng[256], fg[256], nb[256], fb[256];
+        for (int i = 0; i < n; i++) {
+            span(r, i * step, i * step + step - 1, nr[i], fr[i]);
+            span(g, i * step, i * step + step - 1, ng[i], fg[i]);
+            span(b, i * step, i * step + step - 1, nb[i], fb[i]);
+        }
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                for (int k = 0; k < n; k++) {
+                    unsigned char a = rampAlpha(nr[i] + ng[j] + nb[k]);
+                    // alfa 1 uniforme também vira CELL_MIXED: a distância dá o mesmo
+                    cells[((size_t)i * n + j) * n + k] = a == rampAlpha(fr[i] + fg[j] + fb[k]) ? a : CELL_MIXED;
+                }
+            }
+        }
+
+        // sem canal dominante (chave acinzentada) não há reflexo a remover
+        int hi = r >= g ? (r >= b ? 0 : 2) : (g >= b ? 1 : 2);
+        int other = hi == 0 ? (g > b ? g : b) : (hi == 1 ? (r > b ? r : b) : (r > g ? r : g));
+        spillChannel = (spill > 0 && key[hi] > other) ? hi : -1;
+        spillAmount = (int)((spill > 1 ? 1 : spill) * 256.0 + 0.5);
+    }
+
+    // bytes das duas tabelas
+    size_t tableBytes() const {
+        return ramp.size() + cells.size() - 6;
+    }
+
+    // Alfa pelo quadrado da distância para quem refaz a conta fora daqui
+    // (GLFilters.h): rampSize() valores, o último (255) vale para todas as
+    // distâncias maiores. Com ele a resposta é a mesma das células prontas.
+    const unsigned char *rampData() const {
+        return ramp.data();
+    }
+
+    int rampSize() const {
+        return rampLast + 1;
+    }
+
+    int keyChannel(int c) const {
+        return key[c];
+    }
+
+    // canal da remoção de reflexo (-1 sem remoção) e intensidade 0..256
+    int spillChannelIndex() const {
+        return spillChannel;
+    }
+
+    int spillStrength() const {
+        return spillAmount;
+    }
+
+    unsigned char alpha(unsigned char r, unsigned char g, unsigned char b) const {
+        int shift = 8 - bits;
+        int n = 1 << bits;
+        int i = r >> shift, j = g >> shift, k = b >> shift;
+        unsigned char cell = cells[((i << bits) + j) * n + k];
+        if (cell != CELL_MIXED) return cell;
+
+        int dr = r - key[0], dg = g - key[1], db = b - key[2];
+        return rampAlpha(dr * dr + dg * dg + db * db);
+    }
+
+    // reduz o canal dominante da chave em direção ao maior dos outros dois
+    void suppressSpill(unsigned char *px) const {
+        if (spillChannel < 0) return;
+        int c = spillChannel;
+        int a = px[c == 0 ? 1 : 0], b = px[c == 2 ? 1 : 2];
+        int limit = a > b ? a : b;
+        if (px[c] > limit) px[c] = (unsigned char)(px[c] - (((px[c] - limit) * spillAmount + 128) >> 8));
+    }
+
+    void keyRGBAScalar(const unsigned char *rgb, unsigned char *rgba, size_t pixels) const {
+        for (size_t i = 0; i < pixels; i++, rgb += 3, rgba += 4) {
+            rgba[0] = rgb[0];
+            rgba[1] = rgb[1];
+            rgba[2] = rgb[2];
+            rgba[3] = alpha(rgb[0], rgb[1], rgb[2]);
+            if (rgba[3] != 0) suppressSpill(rgba);
+        }
+    }
+
+#ifdef IF_X86_SIMD
+    // byte baixo de cada um dos 8 inteiros de 32 bits, em ordem
+    __attribute__((target("avx2"))) static __m128i packLowBytes(__m256i v) {
+        const __m256i firstBytes = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                    0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        v = _mm256_shuffle_epi8(v, firstBytes);
+        return _mm_unpacklo_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    }
+
+    // Mesma conta de alpha() nas células de borda, para 8 pixels (r, g, b
+    // em 32 bits): quadrado da distância e busca na rampa com gather
+    __attribute__((target("avx2"))) __m256i distanceAlphaAVX2(__m256i r, __m256i g, __m256i b) const {
+        __m256i dr = _mm256_sub_epi32(r, _mm256_set1_epi32(key[0]));
+        __m256i dg = _mm256_sub_epi32(g, _mm256_set1_epi32(key[1]));
+        __m256i db = _mm256_sub_epi32(b, _mm256_set1_epi32(key[2]));
+        __m256i d2 = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(dr, dr), _mm256_mullo_epi32(dg, dg)),
+                                      _mm256_mullo_epi32(db, db));
+        d2 = _mm256_min_epi32(d2, _mm256_set1_epi32(rampLast));
+        return _mm256_and_si256(_mm256_i32gather_epi32((const int *)ramp.data(), d2, 1), _mm256_set1_epi32(0xff));
+    }
+
+    // 16 pixels por iteração: separa R, G e B com pshufb (como em
+    // ImageFilters.h), busca as células com dois gathers de 8, calcula a
+    // distância só quando alguma delas é de borda e intercala RGBA com unpack.
+    __attribute__((target("avx2"))) void keyRGBAAVX2(const unsigned char *rgb, unsigned char *rgba, size_t pixels) const {
+        const RGBShuffleMasks &m = rgbShuffleMasks();
+        __m128i split[3][3];
+        for (int c = 0; c < 3; c++) {
+            for (int k = 0; k < 3; k++) split[c][k] = _mm_load_si128((const __m128i *)m.split[c][k]);
+        }
+        const __m128i shift = _mm_cvtsi32_si128(8 - bits);
+        const __m128i shiftG = _mm_cvtsi32_si128(bits);
+        const __m128i shiftR = _mm_cvtsi32_si128(2 * bits);
+        const __m256i lowByte = _mm256_set1_epi32(0xff);
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i mixed = _mm_set1_epi8((char)CELL_MIXED);
+        const __m128i amount = _mm_set1_epi16((short)spillAmount);
+        const __m128i half = _mm_set1_epi16(128);
+        const int *table = (const int *)cells.data();
+
+        size_t i = 0;
+        for (; i + 16 <= pixels; i += 16) {
+            const __m128i *s = (const __m128i *)(rgb + i * 3);
+            __m128i v0 = _mm_loadu_si128(s), v1 = _mm_loadu_si128(s + 1), v2 = _mm_loadu_si128(s + 2);
+            __m128i ch[4];
+            for (int k = 0; k < 3; k++) {
+                ch[k] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, split[k][0]), _mm_shuffle_epi8(v1, split[k][1])),
+                                     _mm_shuffle_epi8(v2, split[k][2]));
+            }
+
+            __m256i r[2], g[2], b[2];
+            __m128i part[2];
+            for (int h = 0; h < 2; h++) {
+                r[h] = _mm256_cvtepu8_epi32(h ? _mm_unpackhi_epi64(ch[0], ch[0]) : ch[0]);
+                g[h] = _mm256_cvtepu8_epi32(h ? _mm_unpackhi_epi64(ch[1], ch[1]) : ch[1]);
+                b[h] = _mm256_cvtepu8_epi32(h ? _mm_unpackhi_epi64(ch[2], ch[2]) : ch[2]);
+                __m256i idx = _mm256_or_si256(_mm256_or_si256(_mm256_sll_epi32(_mm256_srl_epi32(r[h], shift), shiftR),
+                                                              _mm256_sll_epi32(_mm256_srl_epi32(g[h], shift), shiftG)),
+                                              _mm256_srl_epi32(b[h], shift));
+                part[h] = packLowBytes(_mm256_and_si256(_mm256_i32gather_epi32(table, idx, 1), lowByte));
+            }
+            ch[3] = _mm_unpacklo_epi64(part[0], part[1]);
+
+            __m128i border = _mm_cmpeq_epi8(ch[3], mixed);
+            if (_mm_movemask_epi8(border)) {
+                __m128i smooth = _mm_unpacklo_epi64(packLowBytes(distanceAlphaAVX2(r[0], g[0], b[0])),
+                                                    packLowBytes(distanceAlphaAVX2(r[1], g[1], b[1])));
+                ch[3] = _mm_blendv_epi8(ch[3], smooth, border);
+            }
+
+            if (spillChannel >= 0) {
+                int c = spillChannel;
+                __m128i limit = _mm_max_epu8(ch[c == 0 ? 1 : 0], ch[c == 2 ? 1 : 2]);
+                __m128i excess = _mm_subs_epu8(ch[c], limit);
+                __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(excess, zero), amount), half), 8);
+                __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(excess, zero), amount), half), 8);
+                __m128i cut = _mm_andnot_si128(_mm_cmpeq_epi8(ch[3], zero), _mm_packus_epi16(lo, hi));
+                ch[c] = _mm_sub_epi8(ch[c], cut);
+            }
+
+            __m128i rgLo = _mm_unpacklo_epi8(ch[0], ch[1]), rgHi = _mm_unpackhi_epi8(ch[0], ch[1]);
+            __m128i baLo = _mm_unpacklo_epi8(ch[2], ch[3]), baHi = _mm_unpackhi_epi8(ch[2], ch[3]);
+            __m128i *d = (__m128i *)(rgba + i * 4);
+            _mm_storeu_si128(d, _mm_unpacklo_epi16(rgLo, baLo));
+            _mm_storeu_si128(d + 1, _mm_unpackhi_epi16(rgLo, baLo));
+            _mm_storeu_si128(d + 2, _mm_unpacklo_epi16(rgHi, baHi));
+            _mm_storeu_si128(d + 3, _mm_unpackhi_epi16(rgHi, baHi));
+        }
+        keyRGBAScalar(rgb + i * 3, rgba + i * 4, pixels - i);
+    }
+#endif
+
+    // RGB8 para RGBA8 (alfa não pré-multiplicado)
+    void keyRGBA(const unsigned char *rgb, unsigned char *rgba, size_t pixels) const {
+#ifdef IF_X86_SIMD
+        if (g_simdLevel == SIMD_AVX2) return keyRGBAAVX2(rgb, rgba, pixels);
+#endif
+        keyRGBAScalar(rgb, rgba, pixels);
+    }
+
+    // no lugar, compondo sobre fundo preto (como o chroma-key original)
+    void keyRGB(unsigned char *rgb, size_t pixels) const {
+        unsigned char rgba[1024 * 4];
+        for (size_t first = 0; first < pixels; first += 1024) {
+            size_t n = pixels - first < 1024 ? pixels - first : 1024;
+            unsigned char *p = rgb + first * 3;
+            keyRGBA(p, rgba, n);
+            for (size_t k = 0; k < n; k++) {
+                unsigned a = rgba[4 * k + 3];
+                for (int c = 0; c < 3; c++) p[3 * k + c] = (unsigned char)((rgba[4 * k + c] * a + 127) / 255);
+            }
+        }
+    }
+
+    void keyRGBA(FilterExecutor &exec, const unsigned char *rgb, unsigned char *rgba, size_t pixels) const {
+        unsigned char *src = (unsigned char *)rgb;
+        exec.run(src, pixels, 3, [&](unsigned char *p, size_t n) {
+            keyRGBA(p, rgba + (size_t)(p - src) / 3 * 4, n);
+        });
+    }
+};
+
+#endif /* ChromaKey_h */
@@ -0,0 +1,219 @@
+//
+//  ColorGrid.h
+//
+//  Tabuleiro do jogo das cores (M3JogoCores) com tamanho escolhido em tempo
+//  de execução. Cada atributo das células fica em um vetor próprio (SoA),
+//  linha a linha, para que uma varredura leia só o que usa: a eliminação por
+//  cor percorre r, g, b e eliminated sem arrastar o resto. A posição de uma
+//  célula não é guardada; vem de (coluna, linha), em unidades de célula.
+//
+//  GridCamera leva da tela ao tabuleiro e de volta (deslocamento e zoom) e
+//  diz que janela de células está visível: com milhões de células só essa
+//  janela é montada e desenhada.
+//
+
+#ifndef ColorGrid_h
+#define ColorGrid_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+
+using namespace std;
+
+struct ColorGrid {
+    int rows, cols;
+    vector<float> r, g, b;              // cor de cada célula, de 0 a 1
+    vector<unsigned char> eliminated;
+    vector<int> changed;                // células alteradas desde o último envio para a GPU
+
+    ColorGrid() : rows(0), cols(0) {}
+
+    void resize(int rows, int cols) {
+        this->rows = rows;
+        this->cols = cols;
+        size_t n = (size_t)rows * cols;
+        r.assign(n, 0.0f);
+        g.assign(n, 0.0f);
+        b.assign(n, 0.0f);
+        eliminated.assign(n, 0);
+        changed.clear();
+    }
+
+    size_t size() const {
+        return r.size();
+    }
+
+    int index(int row, int col) const {
+        return row * cols + col;
+    }
+
+    // cores sorteadas por um gerador próprio (xorshift32), r, g, b de cada
+    // célula, linha a linha: a mesma semente dá o mesmo tabuleiro em qualquer
+    // plataforma, sem depender de rand() nem do relógio
+    void randomize(uint32_t seed) {
+        uint32_t s = seed ? seed : 0x9E3779B9u;     // zero prenderia o xorshift
+        float *channel[3];
+        for (size_t k = 0; k < size(); k++) {
+            channel[0] = &r[k];
+            channel[1] = &g[k];
+            channel[2] = &b[k];
+            for (int c = 0; c < 3; c++) {
+                s ^= s << 13;
+                s ^= s >> 17;
+                s ^= s << 5;
+                *channel[c] = (s >> 24) / 255.0f;
+            }
+        }
+        eliminated.assign(size(), 0);
+        changed.clear();
+    }
+
+    bool eliminate(int k) {
+        if (eliminated[k]) return false;
+        eliminated[k] = 1;
+        changed.push_back(k);
+        return true;
+    }
+
+    // Elimina a célula k e todas as que ainda estão no tabuleiro com cor a
+    // até 'tolerance' dela (distância RGB dividida pela diagonal do cubo,
+    // comparada ao quadrado: d^2 <= 3 tolerance^2). Varre o tabuleiro todo;
+    // ColorIndex.h responde o mesmo visitando só as cores próximas.
+    // Retorna quantas foram eliminadas.
+    int eliminateSimilar(int k, float tolerance) {
+        float cr = r[k], cg = g[k], cb = b[k];
+        float r2 = 3.0f * tolerance * tolerance;
+        int count = eliminate(k) ? 1 : 0;
+        for (size_t i = 0; i < size(); i++) {
+            if (eliminated[i]) continue;
+            float dr = r[i] - cr, dg = g[i] - cg, db = b[i] - cb;
+            if (dr * dr + dg * dg + db * db <= r2) {
+                eliminated[i] = 1;
+                changed.push_back((int)i);
+                count++;
+            }
+        }
+        return count;
+    }
+};
+
+// Células [row0, row1) x [col0, col1)
+struct GridWindow {
+    int row0, row1, col0, col1;
+
+    GridWindow() : row0(0), row1(0), col0(0), col1(0) {}
+
+    int rows() const {
+        return row1 - row0;
+    }
+
+    int cols() const {
+        return col1 - col0;
+    }
+
+    size_t cells() const {
+        return (size_t)rows() * cols();
+    }
+
+    bool contains(int row, int col) const {
+        return row >= row0 && row < row1 && col >= col0 && col < col1;
+    }
+
+    bool operator==(const GridWindow &o) const {
+        return row0 == o.row0 && row1 == o.row1 && col0 == o.col0 && col1 == o.col1;
+    }
+
+    bool operator!=(const GridWindow &o) const {
+        return !(*this == o);
+    }
+};
+
+// Câmera 2D sobre o tabuleiro: (x, y) é o ponto do tabuleiro, em unidades de
+// célula, no canto superior esquerdo da tela, e zoom é quantos pixels tem uma
+// célula. O zoom mínimo limita o número de células visíveis, e com isso o
+// custo de um quadro, qualquer que seja o tamanho do tabuleiro.
+struct GridCamera {
+    float x, y, zoom;
+    float minZoom, maxZoom;
+    int width, height;                  // tela em pixels
+
+    GridCamera() : x(0), y(0), zoom(1), minZoom(2), maxZoom(400), width(1), height(1) {}
+
+    // Enquadra o tabuleiro a partir do canto superior esquerdo, com células
+    // de no máximo 'cell' pixels
+    void fit(const ColorGrid &grid, int width, int height, float cell = 100) {
+        this->width = width;
+        this->height = height;
+        float z = cell;
+        if (grid.cols > 0 && (float)width / grid.cols < z) z = (float)width / grid.cols;
+        if (grid.rows > 0 && (float)height / grid.rows < z) z = (float)height / grid.rows;
+        zoom = z < minZoom ? minZoom : (z > maxZoom ? maxZoom : z);
+        x = y = 0;
+    }
+
+    void toGrid(double sx, double sy, float &gx, float &gy) const {
+        gx = x + (float)(sx / zoom);
+        gy = y + (float)(sy / zoom);
+    }
+
+    // Célula sob o ponto (sx, sy) da tela; falso fora do tabuleiro
+    bool cellAt(const ColorGrid &grid, double sx, double sy, int &row, int &col) const {
+        float gx, gy;
+        toGrid(sx, sy, gx, gy);
+        if (gx < 0 || gy < 0) return false;
+        col = (int)gx;
+        row = (int)gy;
+        return col < grid.cols && row < grid.rows;
+    }
+
+    // Desloca a vista em pixels da tela, sem deixar o tabuleiro sair dela
+    void pan(const ColorGrid &grid, float dx, float dy) {
+        x += dx / zoom;
+        y += dy / zoom;
+        clamp(grid);
+    }
+
+    // Multiplica o zoom mantendo fixo o ponto (sx, sy) da tela
+    void zoomAt(const ColorGrid &grid, double sx, double sy, float factor) {
+        float gx, gy;
+        toGrid(sx, sy, gx, gy);
+        float z = zoom * factor;
+        zoom = z < minZoom ? minZoom : (z > maxZoom ? maxZoom : z);
+        x = gx - (float)(sx / zoom);
+        y = gy - (float)(sy / zoom);
+        clamp(grid);
+    }
+
+    // Põe o centro da célula (row, col) no meio da tela
+    void centerOn(const ColorGrid &grid, int row, int col) {
+        x = col + 0.5f - width / zoom / 2;
+        y = row + 0.5f - height / zoom / 2;
+        clamp(grid);
+    }
+
+    // pelo menos metade da tela continua sobre o tabuleiro
+    void clamp(const ColorGrid &grid) {
+        float halfW = width / zoom / 2, halfH = height / zoom / 2;
+        x = x < -halfW ? -halfW : (x > grid.cols - halfW ? grid.cols - halfW : x);
+        y = y < -halfH ? -halfH : (y > grid.rows - halfH ? grid.rows - halfH : y);
+    }
+
+    GridWindow visible(const ColorGrid &grid) const {
+        GridWindow w;
+        w.col0 = (int)floorf(x);
+        w.row0 = (int)floorf(y);
+        w.col1 = (int)ceilf(x + width / zoom);
+        w.row1 = (int)ceilf(y + height / zoom);
+        w.col0 = w.col0 < 0 ? 0 : w.col0;
+        w.row0 = w.row0 < 0 ? 0 : w.row0;
+        w.col1 = w.col1 > grid.cols ? grid.cols : w.col1;
+        w.row1 = w.row1 > grid.rows ? grid.rows : w.row1;
+        if (w.col1 < w.col0) w.col1 = w.col0;
+        if (w.row1 < w.row0) w.row1 = w.row0;
+        return w;
+    }
+};
+
+#endif /* ColorGrid_h */
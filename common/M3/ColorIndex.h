@@ -0,0 +1,339 @@
+//
+//  ColorIndex.h
+//
+//  Índice espacial das cores do tabuleiro do jogo das cores, para achar
+//  todas as células a até uma tolerância de uma cor sem varrer o tabuleiro.
+//
+//  As cores viram pontos 3D (RGB ou OKLab, que mede a diferença percebida)
+//  e vão para uma grade uniforme de baldes sobre a caixa que contém todos os
+//  pontos. Dentro de cada balde as entradas ficam contíguas (coordenadas em
+//  SoA e a célula), agrupadas por uma ordenação por contagem. Uma consulta
+//  só visita os baldes que tocam a esfera de busca:
+//  - balde todo dentro da esfera: todas as entradas entram, sem contas;
+//  - balde todo fora: ignorado;
+//  - os demais (a casca da esfera) são varridos com SIMD, 8 ou 4 entradas
+//    por vez, comparando a distância ao quadrado com o raio ao quadrado.
+//
+//  Células eliminadas saem do índice em O(1): a última entrada viva do
+//  balde ocupa o lugar da removida.
+//
+
+#ifndef ColorIndex_h
+#define ColorIndex_h
+
+#include <math.h>
+#include <vector>
+
+#include "ImageFilters.h"
+#include "ColorGrid.h"
+
+using namespace std;
+
+enum ColorMetric { COLOR_RGB, COLOR_OKLAB };
+
+inline const char *colorMetricName(ColorMetric m) {
+    return m == COLOR_OKLAB ? "OKLab" : "RGB";
+}
+
+inline float srgbToLinear(float c) {
+    return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+}
+
+// sRGB (0 a 1) para OKLab (L de 0 a 1; a e b em torno de +-0.3)
+inline void srgbToOklab(float r, float g, float b, float lab[3]) {
+    r = srgbToLinear(r);
+    g = srgbToLinear(g);
+    b = srgbToLinear(b);
+    float l = cbrtf(0.4122214708f * r + 0.5363325363f * g + 0.0514459929f * b);
+    float m = cbrtf(0.2119034982f * r + 0.6806995451f * g + 0.1073969566f * b);
+    float s = cbrtf(0.0883024619f * r + 0.2817188376f * g + 0.6299787005f * b);
+    lab[0] = 0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s;
+    lab[1] = 1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s;
+    lab[2] = 0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s;
+}
+
+// Ponto da célula k no espaço da métrica
+inline void colorPoint(const ColorGrid &grid, int k, ColorMetric metric, float p[3]) {
+    if (metric == COLOR_OKLAB) {
+        srgbToOklab(grid.r[k], grid.g[k], grid.b[k], p);
+    } else {
+        p[0] = grid.r[k];
+        p[1] = grid.g[k];
+        p[2] = grid.b[k];
+    }
+}
+
+// Raio ao quadrado de uma tolerância: em RGB a tolerância é uma fração da
+// diagonal do cubo (como em ColorGrid::eliminateSimilar), em OKLab é a
+// própria distância (0.02 mal se vê, 0.2 já é outra cor)
+inline float colorRadius2(ColorMetric metric, float tolerance) {
+    return metric == COLOR_OKLAB ? tolerance * tolerance : 3.0f * tolerance * tolerance;
+}
+
+// As posições (base + i) das entradas i em [0, n) a até sqrt(r2) de c vão
+// para out, em ordem crescente. A distância é sempre (dx*dx + dy*dy) + dz*dz,
+// nessa ordem, para as versões darem o mesmo resultado que a escalar.
+inline void colorBallScanScalar(const float *x, const float *y, const float *z, int base, int n,
+                                const float c[3], float r2, vector<int> &out) {
+    for (int i = 0; i < n; i++) {
+        float dx = x[i] - c[0], dy = y[i] - c[1], dz = z[i] - c[2];
+        if (dx * dx + dy * dy + dz * dz <= r2) out.push_back(base + i);
+    }
+}
+
+#ifdef IF_X86_SIMD
+
+__attribute__((target("sse2"))) inline void colorBallScanSSE(const float *x, const float *y, const float *z, int base, int n,
+                                                             const float c[3], float r2, vector<int> &out) {
+    __m128 cx = _mm_set1_ps(c[0]), cy = _mm_set1_ps(c[1]), cz = _mm_set1_ps(c[2]), r = _mm_set1_ps(r2);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(x + i), cx);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(y + i), cy);
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(z + i), cz);
+        __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        int mask = _mm_movemask_ps(_mm_cmple_ps(d2, r));
+        while (mask) {
+            out.push_back(base + i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    colorBallScanScalar(x + i, y + i, z + i, base + i, n - i, c, r2, out);
+}
+
+__attribute__((target("avx2"))) inline void colorBallScanAVX2(const float *x, const float *y, const float *z, int base, int n,
+                                                              const float c[3], float r2, vector<int> &out) {
+    __m256 cx = _mm256_set1_ps(c[0]), cy = _mm256_set1_ps(c[1]), cz = _mm256_set1_ps(c[2]), r = _mm256_set1_ps(r2);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + i), cx);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + i), cy);
+        __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(z + i), cz);
+        __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(d2, r, _CMP_LE_OQ));
+        while (mask) {
+            out.push_back(base + i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    colorBallScanSSE(x + i, y + i, z + i, base + i, n - i, c, r2, out);
+}
+
+#endif /* IF_X86_SIMD */
+
+inline void colorBallScan(const float *x, const float *y, const float *z, int base, int n,
+                          const float c[3], float r2, vector<int> &out) {
+#ifdef IF_X86_SIMD
+    if (g_simdLevel == SIMD_AVX2) return colorBallScanAVX2(x, y, z, base, n, c, r2, out);
+    if (g_simdLevel == SIMD_SSE) return colorBallScanSSE(x, y, z, base, n, c, r2, out);
+#endif
+    colorBallScanScalar(x, y, z, base, n, c, r2, out);
+}
+
+class ColorIndex {
+    ColorMetric metric;
+    int res;                        // baldes por eixo
+    float lo[3], size[3], inv[3];   // caixa de cada balde: lo + i * size
+    vector<int> start;              // primeira entrada de cada balde (res^3 + 1)
+    vector<int> live;               // entradas vivas de cada balde (as primeiras)
+    vector<float> x, y, z;          // entradas agrupadas por balde
+    vector<int> cell;
+    vector<int> slot;               // entrada de cada célula, -1 se fora do índice
+
+    int axisBucket(int a, float v) const {
+        int i = (int)((v - lo[a]) * inv[a]);
+        return i < 0 ? 0 : (i >= res ? res - 1 : i);
+    }
+
+    int bucketOf(const float p[3]) const {
+        return (axisBucket(2, p[2]) * res + axisBucket(1, p[1])) * res + axisBucket(0, p[0]);
+    }
+
+    // Distâncias ao quadrado de c ao ponto mais próximo e ao mais distante
+    // da caixa do balde (i, j, k). A caixa cresce um pouco para cobrir pontos
+    // que o arredondamento pôs no balde vizinho.
+    void boxDistances(int i, int j, int k, const float c[3], float &near2, float &far2) const {
+        const int index[3] = { i, j, k };
+        near2 = far2 = 0;
+        for (int a = 0; a < 3; a++) {
+            float eps = 1e-4f * size[a] + 1e-6f;
+            float b0 = lo[a] + index[a] * size[a] - eps, b1 = lo[a] + (index[a] + 1) * size[a] + eps;
+            float dn = c[a] < b0 ? b0 - c[a] : (c[a] > b1 ? c[a] - b1 : 0.0f);
+            float df = c[a] - b0 > b1 - c[a] ? c[a] - b0 : b1 - c[a];
+            near2 += dn * dn;
+            far2 += df * df;
+        }
+    }
+
+public:
+    ColorIndex() : metric(COLOR_RGB), res(0) {}
+
+    ColorMetric colorMetric() const {
+        return metric;
+    }
+
+    // Indexa as células ainda não eliminadas, ~32 por balde
+    void build(const ColorGrid &grid, ColorMetric metric) {
+        this->metric = metric;
+        size_t n = grid.size();
+        vector<float> px(n), py(n), pz(n);
+        float hi[3];
+        for (int a = 0; a < 3; a++) {
+            lo[a] = 1e30f;
+            hi[a] = -1e30f;
+        }
+        size_t count = 0;
+        for (size_t k = 0; k < n; k++) {
+            if (grid.eliminated[k]) continue;
+            float p[3];
+            colorPoint(grid, (int)k, metric, p);
+            px[k] = p[0];
+            py[k] = p[1];
+            pz[k] = p[2];
+            for (int a = 0; a < 3; a++) {
+                lo[a] = p[a] < lo[a] ? p[a] : lo[a];
+                hi[a] = p[a] > hi[a] ? p[a] : hi[a];
+            }
+            count++;
+        }
+        res = (int)cbrt(count / 32.0);
+        res = res < 1 ? 1 : (res > 128 ? 128 : res);
+        for (int a = 0; a < 3; a++) {
+            if (count == 0) lo[a] = hi[a] = 0;
+            size[a] = hi[a] > lo[a] ? (hi[a] - lo[a]) / res : 1.0f;
+            inv[a] = 1.0f / size[a];
+        }
+
+        // ordenação por contagem: cada balde recebe um trecho contíguo
+        size_t buckets = (size_t)res * res * res;
+        start.assign(buckets + 1, 0);
+        vector<int> bucket(n);
+        for (size_t k = 0; k < n; k++) {
+            if (grid.eliminated[k]) continue;
+            float p[3] = { px[k], py[k], pz[k] };
+            bucket[k] = bucketOf(p);
+            start[bucket[k] + 1]++;
+        }
+        for (size_t b = 0; b < buckets; b++) start[b + 1] += start[b];
+        live.assign(buckets, 0);
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+        cell.resize(count);
+        slot.assign(n, -1);
+        for (size_t k = 0; k < n; k++) {
+            if (grid.eliminated[k]) continue;
+            int b = bucket[k];
+            int e = start[b] + live[b]++;
+            x[e] = px[k];
+            y[e] = py[k];
+            z[e] = pz[k];
+            cell[e] = (int)k;
+            slot[k] = e;
+        }
+    }
+
+    bool contains(int k) const {
+        return k >= 0 && k < (int)slot.size() && slot[k] >= 0;
+    }
+
+    // Tira a célula k do índice (nada acontece se ela já não estava)
+    void remove(int k) {
+        if (!contains(k)) return;
+        int e = slot[k];
+        float p[3] = { x[e], y[e], z[e] };
+        removeEntry(bucketOf(p), e);
+    }
+
+    // Acrescenta a out as células do índice a até sqrt(r2) do ponto c (no
+    // espaço da métrica); retorna quantas
+    size_t query(const float c[3], float r2, vector<int> &out) {
+        return visitBall(c, r2, out, false);
+    }
+
+    // Como query, mas as células encontradas também saem do índice
+    size_t take(const float c[3], float r2, vector<int> &out) {
+        return visitBall(c, r2, out, true);
+    }
+
+private:
+    // a última entrada viva do balde b ocupa o lugar da entrada e
+    void removeEntry(int b, int e) {
+        int last = start[b] + --live[b];
+        slot[cell[e]] = -1;
+        if (e == last) return;
+        x[e] = x[last];
+        y[e] = y[last];
+        z[e] = z[last];
+        cell[e] = cell[last];
+        slot[cell[e]] = e;
+    }
+
+    size_t visitBall(const float c[3], float r2, vector<int> &out, bool removing) {
+        size_t before = out.size();
+        if (res == 0) return 0;
+        float r = sqrtf(r2);
+        int b0[3], b1[3];
+        for (int a = 0; a < 3; a++) {
+            b0[a] = axisBucket(a, c[a] - r);
+            b1[a] = axisBucket(a, c[a] + r);
+        }
+        for (int k = b0[2]; k <= b1[2]; k++) {
+            for (int j = b0[1]; j <= b1[1]; j++) {
+                for (int i = b0[0]; i <= b1[0]; i++) {
+                    int b = (k * res + j) * res + i;
+                    int n = live[b];
+                    if (n == 0) continue;
+                    float near2, far2;
+                    boxDistances(i, j, k, c, near2, far2);
+                    if (near2 > r2) continue;
+                    int e0 = start[b];
+                    if (far2 <= r2) {
+                        // balde todo dentro: sai inteiro
+                        out.insert(out.end(), &cell[e0], &cell[e0] + n);
+                        if (removing) {
+                            for (int e = e0; e < e0 + n; e++) slot[cell[e]] = -1;
+                            live[b] = 0;
+                        }
+                        continue;
+                    }
+                    hits.clear();
+                    colorBallScan(&x[e0], &y[e0], &z[e0], e0, n, c, r2, hits);
+                    for (size_t h = 0; h < hits.size(); h++) out.push_back(cell[hits[h]]);
+                    // da maior posição para a menor: a última entrada viva
+                    // nunca é um acerto ainda não removido
+                    if (removing) {
+                        for (size_t h = hits.size(); h-- > 0;) removeEntry(b, hits[h]);
+                    }
+                }
+            }
+        }
+        return out.size() - before;
+    }
+
+    vector<int> hits;               // posições encontradas em um balde
+};
+
+// Como ColorGrid::eliminateSimilar, mas pelo índice e na métrica dele: a
+// célula k e as do índice a até 'tolerance' da cor dela saem do tabuleiro e
+// do índice. 'found' é só rascunho: reaproveitado entre cliques, o clique não
+// aloca nada. Retorna quantas foram eliminadas.
+inline int eliminateSimilar(ColorGrid &grid, ColorIndex &index, int k, float tolerance, vector<int> &found) {
+    float c[3];
+    colorPoint(grid, k, index.colorMetric(), c);
+    int count = grid.eliminate(k) ? 1 : 0;
+    index.remove(k);
+    found.clear();
+    index.take(c, colorRadius2(index.colorMetric(), tolerance), found);
+    for (size_t i = 0; i < found.size(); i++) {
+        if (grid.eliminate(found[i])) count++;
+    }
+    return count;
+}
+
+inline int eliminateSimilar(ColorGrid &grid, ColorIndex &index, int k, float tolerance) {
+    vector<int> found;
+    return eliminateSimilar(grid, index, k, tolerance, found);
+}
+
+#endif /* ColorIndex_h */
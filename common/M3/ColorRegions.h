@@ -0,0 +1,196 @@
+//
+//  ColorRegions.h
+//
+//  Regiões conectadas de cores parecidas no tabuleiro do jogo das cores:
+//  duas células vizinhas (4-conexas) ainda no tabuleiro estão ligadas se a
+//  distância RGB entre elas não passa da tolerância (a mesma conta de
+//  ColorGrid::eliminateSimilar). Uma região é um componente conexo dessas
+//  ligações, então uma cor pode ir mudando aos poucos ao longo dela.
+//
+//  RegionFinder acha a região de um clique com preenchimento por linhas:
+//  cada trecho horizontal é estendido até onde a ligação continua e só
+//  então as linhas de cima e de baixo são examinadas. As marcas de visitado
+//  levam o número da busca, para não limpar um vetor do tamanho do
+//  tabuleiro a cada clique.
+//
+//  RegionLabels rotula o tabuleiro inteiro (dicas, pontuação) por
+//  união-busca em paralelo: cada faixa de linhas une suas células sem
+//  sair dela, as fronteiras entre faixas são unidas depois e cada célula
+//  recebe a raiz do seu componente. A raiz é sempre a menor célula do
+//  componente, então os rótulos não dependem do número de threads e batem
+//  com as regiões do RegionFinder.
+//
+
+#ifndef ColorRegions_h
+#define ColorRegions_h
+
+#include <stdint.h>
+#include <vector>
+
+#include "ColorGrid.h"
+#include "FilterExecutor.h"
+
+using namespace std;
+
+// a e b (vizinhas) estão ligadas: as duas no tabuleiro e com cores a até
+// sqrt(r2) uma da outra
+inline bool linkedCells(const ColorGrid &grid, int a, int b, float r2) {
+    if (grid.eliminated[a] || grid.eliminated[b]) return false;
+    float dr = grid.r[a] - grid.r[b], dg = grid.g[a] - grid.g[b], db = grid.b[a] - grid.b[b];
+    return dr * dr + dg * dg + db * db <= r2;
+}
+
+// raio ao quadrado da tolerância, na escala de ColorGrid::eliminateSimilar
+inline float regionRadius2(float tolerance) {
+    return 3.0f * tolerance * tolerance;
+}
+
+class RegionFinder {
+    vector<uint32_t> mark;          // == generation: já está na região atual
+    uint32_t generation;
+    vector<int> pending;            // células aceitas cujo trecho falta estender
+
+    bool visit(const ColorGrid &grid, int from, int to, float r2) {
+        if (mark[to] == generation || grid.eliminated[to]) return false;
+        float dr = grid.r[from] - grid.r[to], dg = grid.g[from] - grid.g[to], db = grid.b[from] - grid.b[to];
+        if (dr * dr + dg * dg + db * db > r2) return false;
+        mark[to] = generation;
+        return true;
+    }
+
+public:
+    RegionFinder() : generation(0) {}
+
+    // Células da região de k (k incluída mesmo se já foi eliminada, como
+    // acontece logo depois do clique) em out; retorna quantas
+    size_t region(const ColorGrid &grid, int k, float tolerance, vector<int> &out) {
+        out.clear();
+        if (mark.size() != grid.size()) {
+            mark.assign(grid.size(), 0);
+            generation = 0;
+        }
+        if (++generation == 0) {
+            mark.assign(grid.size(), 0);
+            generation = 1;
+        }
+        float r2 = regionRadius2(tolerance);
+        int cols = grid.cols;
+        mark[k] = generation;
+        pending.assign(1, k);
+        while (!pending.empty()) {
+            int seed = pending.back();
+            pending.pop_back();
+            int y = seed / cols, rowStart = y * cols;
+            int x0 = seed, x1 = seed;
+            while (x0 > rowStart && visit(grid, x0, x0 - 1, r2)) x0--;
+            while (x1 < rowStart + cols - 1 && visit(grid, x1, x1 + 1, r2)) x1++;
+            for (int c = x0; c <= x1; c++) {
+                out.push_back(c);
+                if (y > 0 && visit(grid, c, c - cols, r2)) pending.push_back(c - cols);
+                if (y < grid.rows - 1 && visit(grid, c, c + cols, r2)) pending.push_back(c + cols);
+            }
+        }
+        return out.size();
+    }
+};
+
+// Resumo de um rótulo do tabuleiro inteiro
+struct RegionSummary {
+    int regions;                    // componentes (células isoladas contam)
+    int largest, largestCell;       // maior componente e sua menor célula
+    int cells;                      // células ainda no tabuleiro
+    long long score;                // soma de tamanho^2: o que o tabuleiro ainda vale
+
+    RegionSummary() : regions(0), largest(0), largestCell(-1), cells(0), score(0) {}
+};
+
+class RegionLabels {
+    vector<int> parent;             // -1 fora do tabuleiro; parent[k] <= k
+
+    int find(int k) {
+        while (parent[k] != k) {
+            parent[k] = parent[parent[k]];
+            k = parent[k];
+        }
+        return k;
+    }
+
+    // só leitura: pode rodar em paralelo depois das uniões
+    int root(int k) const {
+        while (parent[k] != k) k = parent[k];
+        return k;
+    }
+
+    // a raiz maior vai para baixo da menor
+    void unite(int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a < b) parent[b] = a;
+        else if (b < a) parent[a] = b;
+    }
+
+public:
+    vector<int> label;              // raiz (menor célula) da região de cada célula, -1 se eliminada
+    vector<int> size;               // tamanho da região de cada raiz (0 nas demais)
+
+    RegionSummary run(FilterExecutor &exec, const ColorGrid &grid, float tolerance) {
+        float r2 = regionRadius2(tolerance);
+        int rows = grid.rows, cols = grid.cols;
+        size_t n = grid.size();
+        parent.resize(n);
+        label.resize(n);
+        size.assign(n, 0);
+        // faixas independentes do número de threads, mas várias por thread
+        // para o roubo de trabalho equilibrar
+        int bands = exec.threadCount() * 4;
+        bands = bands > rows ? rows : (bands < 1 ? 1 : bands);
+        vector<int> bandStart(bands + 1);
+        for (int i = 0; i <= bands; i++) bandStart[i] = (int)((long long)rows * i / bands);
+
+        // 1. uniões dentro de cada faixa: as raízes nunca saem dela
+        exec.threads().parallelFor(bands, [&](int i) {
+            int y0 = bandStart[i], y1 = bandStart[i + 1];
+            for (int y = y0; y < y1; y++) {
+                int row = y * cols;
+                for (int x = 0; x < cols; x++) {
+                    int k = row + x;
+                    parent[k] = grid.eliminated[k] ? -1 : k;
+                    if (parent[k] < 0) continue;
+                    if (x > 0 && linkedCells(grid, k - 1, k, r2)) unite(k - 1, k);
+                    if (y > y0 && linkedCells(grid, k - cols, k, r2)) unite(k - cols, k);
+                }
+            }
+        });
+        // 2. fronteiras entre faixas
+        for (int i = 1; i < bands; i++) {
+            int row = bandStart[i] * cols;
+            for (int x = 0; x < cols; x++) {
+                if (linkedCells(grid, row + x - cols, row + x, r2)) unite(row + x - cols, row + x);
+            }
+        }
+        // 3. rótulo final de cada célula
+        exec.threads().parallelFor(bands, [&](int i) {
+            for (int k = bandStart[i] * cols; k < bandStart[i + 1] * cols; k++) {
+                label[k] = parent[k] < 0 ? -1 : root(k);
+            }
+        });
+
+        RegionSummary s;
+        for (size_t k = 0; k < n; k++) {
+            if (label[k] >= 0) size[label[k]]++;
+        }
+        for (size_t k = 0; k < n; k++) {
+            if (size[k] == 0) continue;
+            s.regions++;
+            s.cells += size[k];
+            s.score += (long long)size[k] * size[k];
+            if (size[k] > s.largest) {
+                s.largest = size[k];
+                s.largestCell = (int)k;
+            }
+        }
+        return s;
+    }
+};
+
+#endif /* ColorRegions_h */
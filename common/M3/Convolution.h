@@ -0,0 +1,391 @@
+//
+//  Convolution.h
+//
+//  Filtros de vizinhança para o exemplo_03: desfoque gaussiano e de caixa,
+//  máscara de nitidez (unsharp mask) e bordas de Sobel, sobre RGB 8 bits
+//  intercalado.
+//
+//  O gaussiano é separável: uma passada horizontal e outra vertical em vez
+//  de um núcleo 2D, (2r+1)*2 multiplicações por amostra em vez de (2r+1)².
+//  As duas passadas rodam dentro do mesmo ladrilho do FilterExecutor: as
+//  linhas do ladrilho (mais o halo) passam pela convolução horizontal para
+//  um buffer de 16 bits do tamanho da cache, e a vertical lê dali. Nas duas
+//  direções a soma percorre amostras contíguas (o vizinho horizontal de uma
+//  amostra está 3 bytes adiante, o vertical na mesma posição da linha
+//  seguinte), então não é preciso transpor a imagem nem separar os canais
+//  para usar SIMD.
+//
+//  Aritmética em ponto fixo: pesos com 8 bits de fração (somam 256), a
+//  passada horizontal guarda a soma exata em 16 bits e a vertical acumula
+//  (h * peso) >> 8 com mulhi. As versões escalar, SSE2 e AVX2 fazem a mesma
+//  conta e dão o mesmo resultado.
+//
+//  O desfoque de caixa usa somas acumuladas: custo constante por pixel,
+//  qualquer que seja o raio.
+//
+
+#ifndef Convolution_h
+#define Convolution_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+
+#include "ImageFilters.h"
+#include "FilterExecutor.h"
+
+using namespace std;
+
+// Filtro de vizinhança pronto para runNeighborhood/streamNeighborhood.
+struct NeighborhoodFilter {
+    int halo;
+    NeighborhoodKernel fn;
+};
+
+// Pesos de 8 bits de fração de um gaussiano (2r+1 pesos, soma 256). Vazio
+// quando sigma é tão pequeno que o filtro seria a identidade.
+inline vector<uint16_t> gaussianWeights(double sigma) {
+    vector<uint16_t> w;
+    int radius = (int)ceil(3.0 * sigma);
+    if (sigma <= 0 || radius < 1) return w;
+    if (radius > 127) radius = 127;
+    vector<double> g(2 * radius + 1);
+    double total = 0;
+    for (int k = -radius; k <= radius; k++) {
+        g[k + radius] = exp(-(k * k) / (2.0 * sigma * sigma));
+        total += g[k + radius];
+    }
+    w.resize(g.size());
+    int sum = 0;
+    for (size_t k = 0; k < g.size(); k++) {
+        w[k] = (uint16_t)(g[k] / total * 256.0 + 0.5);
+        sum += w[k];
+    }
+    // o arredondamento vai para o peso central, para a soma ser exata
+    int center = w[radius] + 256 - sum;
+    if (center > 255) return vector<uint16_t>();
+    w[radius] = (uint16_t)center;
+    return w;
+}
+
+inline int clampColumn(int x, int width) {
+    return x < 0 ? 0 : (x >= width ? width - 1 : x);
+}
+
+/*----------------------------------ESCALAR-----------------------------------*/
+// out[s - s0] = soma de w[k] * row[s + 3 (k - r)] para as amostras s em
+// [s0, s1), com as colunas fora da imagem replicadas da borda.
+inline void convolveRowScalar(const unsigned char *row, int width, int s0, int s1, const uint16_t *w, int radius,
+                              uint16_t *out) {
+    for (int s = s0; s < s1; s++) {
+        int x = s / 3, c = s % 3;
+        unsigned sum = 0;
+        if (x >= radius && x + radius < width) {
+            const unsigned char *p = row + s - 3 * radius;
+            for (int k = 0; k <= 2 * radius; k++) sum += w[k] * p[3 * k];
+        } else {
+            for (int k = -radius; k <= radius; k++) {
+                sum += w[k + radius] * row[clampColumn(x + k, width) * 3 + c];
+            }
+        }
+        out[s - s0] = (uint16_t)sum;
+    }
+}
+
+// out[i] = soma de (rows[k][i] * w[k]) >> 8 para k em [0, 2r], arredondada
+inline void convolveColumnsScalar(const uint16_t *const *rows, const uint16_t *w, int radius, int samples,
+                                  unsigned char *out) {
+    // linha a linha, para ler cada linha do buffer em sequência
+    thread_local vector<uint32_t> sum;
+    sum.assign(samples, 0);
+    for (int k = 0; k <= 2 * radius; k++) {
+        const uint16_t *row = rows[k];
+        unsigned wk = w[k];
+        for (int i = 0; i < samples; i++) sum[i] += (row[i] * wk) >> 8;
+    }
+    for (int i = 0; i < samples; i++) {
+        unsigned v = (sum[i] + 128) >> 8;
+        out[i] = (unsigned char)(v > 255 ? 255 : v);
+    }
+}
+
+#ifdef IF_X86_SIMD
+/*-------------------------------------SSE------------------------------------*/
+__attribute__((target("sse2"))) inline void convolveRowSSE(const unsigned char *row, int width, int s0, int s1,
+                                                          const uint16_t *w, int radius, uint16_t *out) {
+    // só as amostras cujos vizinhos estão todos dentro da linha
+    int in0 = radius * 3 > s0 ? radius * 3 : s0;
+    int in1 = (width - radius) * 3 < s1 ? (width - radius) * 3 : s1;
+    if (in1 <= in0) return convolveRowScalar(row, width, s0, s1, w, radius, out);
+    convolveRowScalar(row, width, s0, in0, w, radius, out);
+    const __m128i zero = _mm_setzero_si128();
+    int s = in0;
+    for (; s + 16 <= in1; s += 16) {
+        __m128i lo = zero, hi = zero;
+        for (int k = -radius; k <= radius; k++) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(row + s + 3 * k));
+            __m128i wk = _mm_set1_epi16((short)w[k + radius]);
+            lo = _mm_add_epi16(lo, _mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), wk));
+            hi = _mm_add_epi16(hi, _mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), wk));
+        }
+        _mm_storeu_si128((__m128i *)(out + s - s0), lo);
+        _mm_storeu_si128((__m128i *)(out + s - s0 + 8), hi);
+    }
+    convolveRowScalar(row, width, s, s1, w, radius, out + s - s0);
+}
+
+__attribute__((target("sse2"))) inline void convolveColumnsSSE(const uint16_t *const *rows, const uint16_t *w, int radius,
+                                                              int samples, unsigned char *out) {
+    const __m128i half = _mm_set1_epi16(128);
+    int i = 0;
+    for (; i + 16 <= samples; i += 16) {
+        __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+        for (int k = 0; k <= 2 * radius; k++) {
+            __m128i wk = _mm_set1_epi16((short)(w[k] << 8));
+            lo = _mm_add_epi16(lo, _mm_mulhi_epu16(_mm_loadu_si128((const __m128i *)(rows[k] + i)), wk));
+            hi = _mm_add_epi16(hi, _mm_mulhi_epu16(_mm_loadu_si128((const __m128i *)(rows[k] + i + 8)), wk));
+        }
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, half), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, half), 8);
+        _mm_storeu_si128((__m128i *)(out + i), _mm_packus_epi16(lo, hi));
+    }
+    const uint16_t *rest[255];
+    for (int k = 0; k <= 2 * radius; k++) rest[k] = rows[k] + i;
+    convolveColumnsScalar(rest, w, radius, samples - i, out + i);
+}
+
+/*------------------------------------AVX2------------------------------------*/
+__attribute__((target("avx2"))) inline void convolveRowAVX2(const unsigned char *row, int width, int s0, int s1,
+                                                           const uint16_t *w, int radius, uint16_t *out) {
+    int in0 = radius * 3 > s0 ? radius * 3 : s0;
+    int in1 = (width - radius) * 3 < s1 ? (width - radius) * 3 : s1;
+    if (in1 <= in0) return convolveRowScalar(row, width, s0, s1, w, radius, out);
+    convolveRowScalar(row, width, s0, in0, w, radius, out);
+    int s = in0;
+    for (; s + 16 <= in1; s += 16) {
+        __m256i sum = _mm256_setzero_si256();
+        for (int k = -radius; k <= radius; k++) {
+            __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(row + s + 3 * k)));
+            sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(v, _mm256_set1_epi16((short)w[k + radius])));
+        }
+        _mm256_storeu_si256((__m256i *)(out + s - s0), sum);
+    }
+    convolveRowSSE(row, width, s, s1, w, radius, out + s - s0);
+}
+
+__attribute__((target("avx2"))) inline void convolveColumnsAVX2(const uint16_t *const *rows, const uint16_t *w, int radius,
+                                                               int samples, unsigned char *out) {
+    const __m256i half = _mm256_set1_epi16(128);
+    int i = 0;
+    for (; i + 32 <= samples; i += 32) {
+        __m256i lo = _mm256_setzero_si256(), hi = _mm256_setzero_si256();
+        for (int k = 0; k <= 2 * radius; k++) {
+            __m256i wk = _mm256_set1_epi16((short)(w[k] << 8));
+            lo = _mm256_add_epi16(lo, _mm256_mulhi_epu16(_mm256_loadu_si256((const __m256i *)(rows[k] + i)), wk));
+            hi = _mm256_add_epi16(hi, _mm256_mulhi_epu16(_mm256_loadu_si256((const __m256i *)(rows[k] + i + 16)), wk));
+        }
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, half), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, half), 8);
+        // packus intercala as metades de 128 bits; permute volta à ordem
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+        _mm256_storeu_si256((__m256i *)(out + i), packed);
+    }
+    const uint16_t *rest[255];
+    for (int k = 0; k <= 2 * radius; k++) rest[k] = rows[k] + i;
+    convolveColumnsSSE(rest, w, radius, samples - i, out + i);
+}
+#endif /* IF_X86_SIMD */
+
+/*-------------------------------ENTRADAS PÚBLICAS----------------------------*/
+inline void convolveRow(const unsigned char *row, int width, int s0, int s1, const uint16_t *w, int radius, uint16_t *out) {
+#ifdef IF_X86_SIMD
+    if (g_simdLevel == SIMD_AVX2) return convolveRowAVX2(row, width, s0, s1, w, radius, out);
+    if (g_simdLevel == SIMD_SSE) return convolveRowSSE(row, width, s0, s1, w, radius, out);
+#endif
+    convolveRowScalar(row, width, s0, s1, w, radius, out);
+}
+
+inline void convolveColumns(const uint16_t *const *rows, const uint16_t *w, int radius, int samples, unsigned char *out) {
+#ifdef IF_X86_SIMD
+    if (g_simdLevel == SIMD_AVX2) return convolveColumnsAVX2(rows, w, radius, samples, out);
+    if (g_simdLevel == SIMD_SSE) return convolveColumnsSSE(rows, w, radius, samples, out);
+#endif
+    convolveColumnsScalar(rows, w, radius, samples, out);
+}
+
+// Convolução separável de um ladrilho: as linhas do ladrilho e do halo
+// passam pela horizontal para um buffer da thread, e a vertical lê dali.
+inline void separableTile(const FilterTile &t, const unsigned char *const *src, unsigned char *const *dst, int width,
+                          const vector<uint16_t> &w) {
+    int radius = (int)w.size() / 2;
+    int rows = t.y1 - t.y0;
+    int samples = (t.x1 - t.x0) * 3;
+    thread_local vector<uint16_t> buffer;
+    thread_local vector<const uint16_t *> lines;
+    buffer.resize((size_t)(rows + 2 * radius) * samples);
+    lines.resize(rows + 2 * radius);
+    for (int r = -radius; r < rows + radius; r++) {
+        uint16_t *line = &buffer[(size_t)(r + radius) * samples];
+        convolveRow(src[r], width, t.x0 * 3, t.x1 * 3, w.data(), radius, line);
+        lines[r + radius] = line;
+    }
+    for (int r = 0; r < rows; r++) {
+        convolveColumns(&lines[r], w.data(), radius, samples, dst[r] + t.x0 * 3);
+    }
+}
+
+inline void copyTile(const FilterTile &t, const unsigned char *const *src, unsigned char *const *dst) {
+    for (int r = 0; r < t.y1 - t.y0; r++) {
+        memcpy(dst[r] + t.x0 * 3, src[r] + t.x0 * 3, (size_t)(t.x1 - t.x0) * 3);
+    }
+}
+
+// Caixa (2r+1)x(2r+1) com somas acumuladas: cada linha é somada
+// deslizando a janela na horizontal e as colunas do ladrilho deslizando na
+// vertical; a divisão pela área é feita com um recíproco exato para r < 128.
+inline void boxTile(const FilterTile &t, const unsigned char *const *src, unsigned char *const *dst, int width,
+                    int radius) {
+    int rows = t.y1 - t.y0;
+    int samples = (t.x1 - t.x0) * 3;
+    thread_local vector<uint16_t> buffer;
+    thread_local vector<uint32_t> columns;
+    buffer.resize((size_t)(rows + 2 * radius) * samples);
+    columns.assign(samples, 0);
+
+    for (int r = -radius; r < rows + radius; r++) {
+        const unsigned char *row = src[r];
+        uint16_t *line = &buffer[(size_t)(r + radius) * samples];
+        for (int c = 0; c < 3; c++) {
+            unsigned sum = 0;
+            for (int k = -radius; k <= radius; k++) sum += row[clampColumn(t.x0 + k, width) * 3 + c];
+            line[c] = (uint16_t)sum;
+            for (int x = t.x0 + 1; x < t.x1; x++) {
+                sum += row[clampColumn(x + radius, width) * 3 + c];
+                sum -= row[clampColumn(x - radius - 1, width) * 3 + c];
+                line[(x - t.x0) * 3 + c] = (uint16_t)sum;
+            }
+        }
+    }
+
+    uint64_t area = (uint64_t)(2 * radius + 1) * (2 * radius + 1);
+    uint64_t recip = ((1ULL << 40) + area - 1) / area;
+    for (int k = 0; k <= 2 * radius; k++) {
+        const uint16_t *line = &buffer[(size_t)k * samples];
+        for (int i = 0; i < samples; i++) columns[i] += line[i];
+    }
+    for (int r = 0; r < rows; r++) {
+        unsigned char *out = dst[r] + t.x0 * 3;
+        for (int i = 0; i < samples; i++) {
+            out[i] = (unsigned char)(((columns[i] + area / 2) * recip) >> 40);
+        }
+        if (r + 1 == rows) break;
+        const uint16_t *enter = &buffer[(size_t)(r + 2 * radius + 1) * samples];
+        const uint16_t *leave = &buffer[(size_t)r * samples];
+        for (int i = 0; i < samples; i++) columns[i] += enter[i] - leave[i];
+    }
+}
+
+// Sobel sobre a luminância: |G| = sqrt(gx² + gy²), limitado a 255, em cinza.
+inline void sobelTile(const FilterTile &t, const unsigned char *const *src, unsigned char *const *dst, int width) {
+    int rows = t.y1 - t.y0;
+    int cols = t.x1 - t.x0 + 2;
+    GrayWeights gw = grayWeights(true);
+    thread_local vector<int16_t> gray;
+    gray.resize((size_t)(rows + 2) * cols);
+    for (int r = -1; r <= rows; r++) {
+        int16_t *line = &gray[(size_t)(r + 1) * cols];
+        for (int x = t.x0 - 1; x <= t.x1; x++) {
+            const unsigned char *p = src[r] + clampColumn(x, width) * 3;
+            line[x - t.x0 + 1] = grayPixel(p[0], p[1], p[2], gw);
+        }
+    }
+    for (int r = 0; r < rows; r++) {
+        const int16_t *a = &gray[(size_t)r * cols];
+        const int16_t *b = a + cols;
+        const int16_t *c = b + cols;
+        unsigned char *out = dst[r] + t.x0 * 3;
+        for (int i = 1; i < cols - 1; i++) {
+            int gx = (a[i + 1] + 2 * b[i + 1] + c[i + 1]) - (a[i - 1] + 2 * b[i - 1] + c[i - 1]);
+            int gy = (c[i - 1] + 2 * c[i] + c[i + 1]) - (a[i - 1] + 2 * a[i] + a[i + 1]);
+            float m = sqrtf((float)(gx * gx + gy * gy));
+            unsigned char v = m >= 255.0f ? 255 : (unsigned char)(m + 0.5f);
+            out[0] = out[1] = out[2] = v;
+            out += 3;
+        }
+    }
+}
+
+/*--------------------------------FILTROS PRONTOS-----------------------------*/
+inline NeighborhoodFilter gaussianBlurFilter(int width, double sigma) {
+    NeighborhoodFilter f;
+    vector<uint16_t> w = gaussianWeights(sigma);
+    f.halo = (int)w.size() / 2;
+    if (w.empty()) {
+        f.fn = copyTile;
+    } else {
+        f.fn = [width, w](const FilterTile &t, const unsigned char *const *src, unsigned char *const *dst) {
+            separableTile(t, src, dst, width, w);
+        };
+    }
+    return f;
+}
+
+// raio de 0 a 127
+inline NeighborhoodFilter boxBlurFilter(int width, int radius) {
+    NeighborhoodFilter f;
+    radius = radius < 0 ? 0 : (radius > 127 ? 127 : radius);
+    f.halo = radius;
+    if (radius == 0) {
+        f.fn = copyTile;
+    } else {
+        f.fn = [width, radius](const FilterTile &t, const unsigned char *const *src, unsigned char *const *dst) {
+            boxTile(t, src, dst, width, radius);
+        };
+    }
+    return f;
+}
+
+// Nitidez: saída = original + amount * (original - desfocada), só onde a
+// diferença passa de 'threshold' (evita realçar ruído em áreas lisas).
+inline NeighborhoodFilter unsharpMaskFilter(int width, double sigma, double amount, int threshold = 0) {
+    NeighborhoodFilter f;
+    vector<uint16_t> w = gaussianWeights(sigma);
+    f.halo = (int)w.size() / 2;
+    if (w.empty()) {
+        f.fn = copyTile;
+        return f;
+    }
+    int gain = (int)(amount * 256.0 + 0.5);
+    f.fn = [width, w, gain, threshold](const FilterTile &t, const unsigned char *const *src, unsigned char *const *dst) {
+        separableTile(t, src, dst, width, w);
+        for (int r = 0; r < t.y1 - t.y0; r++) {
+            const unsigned char *in = src[r] + t.x0 * 3;
+            unsigned char *out = dst[r] + t.x0 * 3;
+            for (int i = 0; i < (t.x1 - t.x0) * 3; i++) {
+                int diff = in[i] - out[i];
+                int v = in[i];
+                if (diff > threshold || diff < -threshold) v += (diff * gain + (diff < 0 ? -128 : 128)) / 256;
+                out[i] = (unsigned char)(v < 0 ? 0 : (v > 255 ? 255 : v));
+            }
+        }
+    };
+    return f;
+}
+
+inline NeighborhoodFilter sobelFilter(int width) {
+    NeighborhoodFilter f;
+    f.halo = 1;
+    f.fn = [width](const FilterTile &t, const unsigned char *const *src, unsigned char *const *dst) {
+        sobelTile(t, src, dst, width);
+    };
+    return f;
+}
+
+// Imagem RGB8 compacta de 'src' para 'dst' (buffers diferentes).
+inline void applyNeighborhood(FilterExecutor &exec, const NeighborhoodFilter &f, const unsigned char *src,
+                              unsigned char *dst, int width, int height) {
+    exec.runNeighborhood(src, (size_t)width * 3, dst, (size_t)width * 3, width, height, 3, f.halo, f.fn);
+}
+
+#endif /* Convolution_h */
@@ -0,0 +1,245 @@
+//
+//  FilterChain.h
+//
+//  Sequência de filtros do exemplo_03, pontuais e de vizinhança, na ordem
+//  em que foram pedidos.
+//
+//  Filtros pontuais seguidos ficam em um mesmo FilterPipeline (uma passada
+//  só pela imagem); cada filtro de vizinhança é uma passada própria, de um
+//  buffer para outro, e os dois buffers se alternam ao longo da cadeia.
+//  Os ajustes automáticos (Histogram.h) medem a imagem como ela está
+//  naquele ponto da cadeia e a corrigem no lugar.
+//
+
+#ifndef FilterChain_h
+#define FilterChain_h
+
+#include <string.h>
+#include <vector>
+
+#include "FilterExecutor.h"
+#include "FilterPipeline.h"
+#include "Convolution.h"
+#include "Histogram.h"
+
+using namespace std;
+
+class FilterChain {
+    enum StepType { STEP_POINT, STEP_GAUSSIAN, STEP_BOX, STEP_UNSHARP, STEP_SOBEL,
+                    STEP_EQUALIZE, STEP_AUTO_LEVELS, STEP_CLAHE };
+
+    struct Step {
+        StepType type;
+        FilterPipeline point;
+        double sigma, amount;       // desfoque e nitidez
+        int radius, threshold;
+        bool perChannel;            // equalização canal a canal
+        int tiles;                  // regiões por eixo do CLAHE
+        double clip;                // fração cortada nos níveis automáticos
+        double clipLimit;           // limite de contraste do CLAHE
+    };
+
+    vector<Step> steps;
+    vector<unsigned char> scratch;
+
+    FilterPipeline &point() {
+        if (steps.empty() || steps.back().type != STEP_POINT) add(STEP_POINT);
+        return steps.back().point;
+    }
+
+    Step &add(StepType type) {
+        Step s;
+        s.type = type;
+        s.sigma = s.amount = 0;
+        s.radius = s.threshold = 0;
+        s.perChannel = false;
+        s.tiles = 0;
+        s.clip = s.clipLimit = 0;
+        steps.push_back(s);
+        return steps.back();
+    }
+
+    static NeighborhoodFilter makeFilter(const Step &s, int width) {
+        switch (s.type) {
+            case STEP_BOX:     return boxBlurFilter(width, s.radius);
+            case STEP_UNSHARP: return unsharpMaskFilter(width, s.sigma, s.amount, s.threshold);
+            case STEP_SOBEL:   return sobelFilter(width);
+            default:           return gaussianBlurFilter(width, s.sigma);
+        }
+    }
+
+    static int haloOf(const Step &s) {
+        switch (s.type) {
+            case STEP_BOX:      return s.radius < 0 ? 0 : (s.radius > 127 ? 127 : s.radius);
+            case STEP_SOBEL:    return 1;
+            case STEP_GAUSSIAN:
+            case STEP_UNSHARP:  return (int)gaussianWeights(s.sigma).size() / 2;
+            default:            return 0;
+        }
+    }
+
+    // passos que medem a imagem inteira antes de alterá-la
+    static bool isGlobal(StepType t) {
+        return t == STEP_EQUALIZE || t == STEP_AUTO_LEVELS || t == STEP_CLAHE;
+    }
+
+    static void applyGlobal(FilterExecutor &exec, const Step &s, unsigned char *data, int width, int height) {
+        size_t pixels = (size_t)width * height;
+        if (s.type == STEP_CLAHE) {
+            claheRGB8(exec, data, width, height, s.tiles, s.clipLimit);
+            return;
+        }
+        Histogram h;
+        histogramRGB8(exec, data, pixels, h);
+        unsigned char lut[3][256];
+        if (s.type == STEP_EQUALIZE) {
+            equalizationTables(h, s.perChannel, lut);
+        } else {
+            autoLevelsTables(h, s.clip, lut);
+        }
+        FilterPipeline p;
+        p.table(lut).apply(exec, data, pixels);
+    }
+
+public:
+    FilterChain &chromaKey(int r, int g, int b, double tolerance) {
+        point().chromaKey(r, g, b, tolerance);
+        return *this;
+    }
+
+    FilterChain &softChromaKey(int r, int g, int b, double tolerance, double softness, double spill) {
+        point().softChromaKey(r, g, b, tolerance, softness, spill);
+        return *this;
+    }
+
+    FilterChain &grayScale(bool weighted = true) {
+        point().grayScale(weighted);
+        return *this;
+    }
+
+    FilterChain &colorize(int r, int g, int b) {
+        point().colorize(r, g, b);
+        return *this;
+    }
+
+    FilterChain &negative() {
+        point().negative();
+        return *this;
+    }
+
+    FilterChain &brightness(int delta) {
+        point().brightness(delta);
+        return *this;
+    }
+
+    FilterChain &contrast(double factor) {
+        point().contrast(factor);
+        return *this;
+    }
+
+    FilterChain &gamma(double g) {
+        point().gamma(g);
+        return *this;
+    }
+
+    FilterChain &gaussianBlur(double sigma) {
+        add(STEP_GAUSSIAN).sigma = sigma;
+        return *this;
+    }
+
+    FilterChain &boxBlur(int radius) {
+        add(STEP_BOX).radius = radius;
+        return *this;
+    }
+
+    FilterChain &unsharpMask(double sigma, double amount, int threshold = 0) {
+        Step &s = add(STEP_UNSHARP);
+        s.sigma = sigma;
+        s.amount = amount;
+        s.threshold = threshold;
+        return *this;
+    }
+
+    FilterChain &sobel() {
+        add(STEP_SOBEL);
+        return *this;
+    }
+
+    // equalização pela luminância ou, com perChannel, canal a canal
+    FilterChain &equalize(bool perChannel = false) {
+        add(STEP_EQUALIZE).perChannel = perChannel;
+        return *this;
+    }
+
+    // descarta a fração 'clip' mais escura e mais clara de cada canal
+    FilterChain &autoLevels(double clip = 0.005) {
+        add(STEP_AUTO_LEVELS).clip = clip;
+        return *this;
+    }
+
+    FilterChain &clahe(int tiles = 8, double clipLimit = 2.0) {
+        Step &s = add(STEP_CLAHE);
+        s.tiles = tiles;
+        s.clipLimit = clipLimit;
+        return *this;
+    }
+
+    bool empty() const {
+        return steps.empty();
+    }
+
+    void clear() {
+        steps.clear();
+    }
+
+    // sem filtros de vizinhança: a cadeia roda no lugar, sem segundo buffer
+    bool inPlace() const {
+        for (size_t i = 0; i < steps.size(); i++) {
+            if (steps[i].type != STEP_POINT && !isGlobal(steps[i].type)) return false;
+        }
+        return true;
+    }
+
+    // algum passo depende de estatísticas da imagem inteira
+    bool wholeImage() const {
+        for (size_t i = 0; i < steps.size(); i++) {
+            if (isGlobal(steps[i].type)) return true;
+        }
+        return false;
+    }
+
+    // soma dos halos: linhas de vizinhança que a cadeia inteira precisa
+    int halo() const {
+        int h = 0;
+        for (size_t i = 0; i < steps.size(); i++) h += haloOf(steps[i]);
+        return h;
+    }
+
+    // Aplica a cadeia em 'a', usando 'b' (do mesmo tamanho) como segundo
+    // buffer, e retorna o buffer que ficou com o resultado. Se inPlace(),
+    // 'b' não é usado e pode ser o próprio 'a'.
+    unsigned char *apply(FilterExecutor &exec, unsigned char *a, unsigned char *b, int width, int height) const {
+        for (size_t i = 0; i < steps.size(); i++) {
+            if (steps[i].type == STEP_POINT) {
+                steps[i].point.apply(exec, a, (size_t)width * height);
+            } else if (isGlobal(steps[i].type)) {
+                applyGlobal(exec, steps[i], a, width, height);
+            } else {
+                applyNeighborhood(exec, makeFilter(steps[i], width), a, b, width, height);
+                unsigned char *t = a;
+                a = b;
+                b = t;
+            }
+        }
+        return a;
+    }
+
+    // no lugar, com um buffer interno para os filtros de vizinhança
+    void apply(FilterExecutor &exec, unsigned char *data, int width, int height) {
+        if (!inPlace()) scratch.resize((size_t)width * height * 3);
+        unsigned char *result = apply(exec, data, scratch.data(), width, height);
+        if (result != data) memcpy(data, result, (size_t)width * height * 3);
+    }
+};
+
+#endif /* FilterChain_h */
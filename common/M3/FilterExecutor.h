@@ -0,0 +1,275 @@
+//
+//  FilterExecutor.h
+//
+//  Execução paralela dos filtros de imagem em ladrilhos do tamanho da cache.
+//
+//  ThreadPool é um pool fixo de threads com roubo de trabalho: cada
+//  parallelFor reparte o intervalo de índices entre as threads (a que chamou
+//  também trabalha) e uma thread que esvazia sua parte rouba a metade final
+//  da parte de outra. Assim imagens com custo irregular continuam
+//  balanceadas sem uma fila central disputada.
+//
+//  FilterExecutor corta a imagem em ladrilhos cuja divisão depende só da
+//  geometria da imagem e do orçamento de bytes, nunca do número de threads;
+//  como cada ladrilho escreve em uma região própria, o resultado é o mesmo
+//  com 1 ou 32 threads.
+//
+
+#ifndef FilterExecutor_h
+#define FilterExecutor_h
+
+#include <stddef.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+
+using namespace std;
+
+class ThreadPool {
+    struct Range {
+        mutex m;
+        int begin, end;
+    };
+
+    vector<thread> workers;
+    vector<unique_ptr<Range> > ranges;     // uma por thread; a última é de quem chama
+
+    mutex jobMutex;
+    condition_variable jobCv, doneCv;
+    const function<void(int)> *job;
+    unsigned generation;
+    int running;
+    bool stopping;
+
+    bool popOwn(int self, int &index) {
+        Range &r = *ranges[self];
+        lock_guard<mutex> lock(r.m);
+        if (r.begin >= r.end) return false;
+        index = r.begin++;
+        return true;
+    }
+
+    bool steal(int self, int &index) {
+        int n = (int)ranges.size();
+        for (int k = 1; k < n; k++) {
+            Range &victim = *ranges[(self + k) % n];
+            int begin, end;
+            {
+                lock_guard<mutex> lock(victim.m);
+                int left = victim.end - victim.begin;
+                if (left <= 0) continue;
+                begin = victim.begin + left / 2;
+                end = victim.end;
+                victim.end = begin;
+            }
+            Range &own = *ranges[self];
+            lock_guard<mutex> lock(own.m);
+            own.begin = begin + 1;
+            own.end = end;
+            index = begin;
+            return true;
+        }
+        return false;
+    }
+
+    static int &currentSlot() {
+        static thread_local int slot = 0;
+        return slot;
+    }
+
+    void participate(int self, const function<void(int)> &fn) {
+        currentSlot() = self;
+        int index;
+        while (popOwn(self, index) || steal(self, index)) {
+            fn(index);
+        }
+    }
+
+    void workerLoop(int self) {
+        unsigned seen = 0;
+        for (;;) {
+            const function<void(int)> *fn;
+            {
+                unique_lock<mutex> lock(jobMutex);
+                jobCv.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                fn = job;
+            }
+            participate(self, *fn);
+            lock_guard<mutex> lock(jobMutex);
+            if (--running == 0) doneCv.notify_one();
+        }
+    }
+
+public:
+    // threads <= 0 usa todos os núcleos
+    explicit ThreadPool(int threads = 0) : job(NULL), generation(0), running(0), stopping(false) {
+        if (threads <= 0) threads = (int)thread::hardware_concurrency();
+        if (threads <= 0) threads = 1;
+        for (int i = 0; i < threads; i++) {
+            ranges.push_back(unique_ptr<Range>(new Range()));
+            ranges.back()->begin = ranges.back()->end = 0;
+        }
+        for (int i = 0; i < threads - 1; i++) {
+            workers.push_back(thread(&ThreadPool::workerLoop, this, i));
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> lock(jobMutex);
+            stopping = true;
+        }
+        jobCv.notify_all();
+        for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+    }
+
+    int size() const {
+        return (int)ranges.size();
+    }
+
+    // Dentro de fn, o índice (0 .. size()-1) da thread que a executa, para
+    // acumular em dados privados de cada thread sem travas.
+    int threadIndex() const {
+        return currentSlot();
+    }
+
+    // Executa fn(0) .. fn(count-1) em paralelo e só retorna quando todos
+    // terminarem. Não pode ser chamado de dentro de fn.
+    void parallelFor(int count, const function<void(int)> &fn) {
+        if (count <= 0) return;
+        int n = (int)ranges.size();
+        if (n == 1 || count == 1) {
+            currentSlot() = n - 1;
+            for (int i = 0; i < count; i++) fn(i);
+            return;
+        }
+        for (int t = 0; t < n; t++) {
+            lock_guard<mutex> lock(ranges[t]->m);
+            ranges[t]->begin = (int)((long long)count * t / n);
+            ranges[t]->end = (int)((long long)count * (t + 1) / n);
+        }
+        {
+            lock_guard<mutex> lock(jobMutex);
+            job = &fn;
+            running = (int)workers.size();
+            generation++;
+        }
+        jobCv.notify_all();
+        participate(n - 1, fn);
+        unique_lock<mutex> lock(jobMutex);
+        doneCv.wait(lock, [this] { return running == 0; });
+        job = NULL;
+    }
+};
+
+// Região de um ladrilho: colunas [x0, x1) e linhas [y0, y1).
+struct FilterTile {
+    int x0, x1, y0, y1;
+};
+
+// Filtro de vizinhança: src[r] é a linha y0 + r da entrada e vale para
+// r em [-halo, (y1 - y0) + halo), com as bordas da imagem replicadas; as
+// linhas são completas, então as colunas vizinhas estão em src[r][x ± k]
+// (cabe ao filtro limitar x a [0, largura)). dst[r] é a linha y0 + r da
+// saída; o filtro escreve só as colunas [x0, x1).
+typedef function<void(const FilterTile &tile, const unsigned char *const *src, unsigned char *const *dst)> NeighborhoodKernel;
+
+class FilterExecutor {
+    ThreadPool pool;
+    size_t tileBytes;
+
+public:
+    explicit FilterExecutor(int threads = 0, size_t tileBytes = 256 * 1024) : pool(threads), tileBytes(tileBytes) {}
+
+    ThreadPool &threads() {
+        return pool;
+    }
+
+    int threadCount() const {
+        return pool.size();
+    }
+
+    int threadIndex() const {
+        return pool.threadIndex();
+    }
+
+    // Filtro pontual sobre imagem compacta: fn(início, pixels) recebe
+    // pedaços contíguos de ~tileBytes (múltiplos de 64 pixels, bom para SIMD).
+    void run(unsigned char *data, size_t pixels, int channels, const function<void(unsigned char *, size_t)> &fn) {
+        size_t chunk = tileBytes / channels;
+        chunk = chunk < 64 ? 64 : chunk - chunk % 64;
+        int count = (int)((pixels + chunk - 1) / chunk);
+        pool.parallelFor(count, [&](int i) {
+            size_t first = (size_t)i * chunk;
+            size_t n = pixels - first < chunk ? pixels - first : chunk;
+            fn(data + first * channels, n);
+        });
+    }
+
+    // Faixas de linhas da saída, com ~tileBytes cada (rowBytes por linha) e
+    // pelo menos minRows linhas: fn(y0, y1) para filtros que mudam o tamanho
+    // da imagem e por isso não cabem em runNeighborhood.
+    void runBands(int height, size_t rowBytes, int minRows, const function<void(int, int)> &fn) {
+        int bandRows = (int)(tileBytes / (rowBytes ? rowBytes : 1));
+        bandRows = bandRows < minRows ? minRows : bandRows;
+        bandRows = bandRows < 1 ? 1 : bandRows;
+        int bands = (height + bandRows - 1) / bandRows;
+        pool.parallelFor(bands, [&](int i) {
+            int y0 = i * bandRows;
+            fn(y0, y0 + bandRows < height ? y0 + bandRows : height);
+        });
+    }
+
+    // Filtro de vizinhança de 'src' para 'dst' (que não podem ser o mesmo
+    // buffer): ladrilhos de linhas inteiras, divididos também em colunas
+    // quando uma faixa com poucas linhas já passa do orçamento.
+    //
+    // Com firstRow/lastRow só as linhas [firstRow, lastRow) são calculadas
+    // (as demais servem de vizinhança) e dst aponta para a linha firstRow.
+    void runNeighborhood(const unsigned char *src, size_t srcStride, unsigned char *dst, size_t dstStride,
+                         int width, int height, int channels, int halo, const NeighborhoodKernel &fn,
+                         int firstRow = 0, int lastRow = -1) {
+        if (lastRow < 0) lastRow = height;
+        size_t rowBytes = (size_t)width * channels;
+        int bandRows = (int)(tileBytes / (rowBytes ? rowBytes : 1));
+        int tileWidth = width;
+        // cada ladrilho relê 2 * halo linhas de vizinhança: com faixas de
+        // pelo menos 4 * halo linhas isso custa no máximo metade a mais
+        int minRows = 4 * halo > 8 ? 4 * halo : 8;
+        if (bandRows < minRows) {
+            bandRows = minRows;
+            tileWidth = (int)(tileBytes / (minRows * (size_t)channels));
+            tileWidth = tileWidth < 64 ? 64 : tileWidth;
+        }
+        int bandsY = (lastRow - firstRow + bandRows - 1) / bandRows;
+        int tilesX = (width + tileWidth - 1) / tileWidth;
+
+        pool.parallelFor(bandsY * tilesX, [&](int i) {
+            FilterTile t;
+            t.y0 = firstRow + (i / tilesX) * bandRows;
+            t.y1 = t.y0 + bandRows < lastRow ? t.y0 + bandRows : lastRow;
+            t.x0 = (i % tilesX) * tileWidth;
+            t.x1 = t.x0 + tileWidth < width ? t.x0 + tileWidth : width;
+
+            int rows = t.y1 - t.y0;
+            vector<const unsigned char *> in(rows + 2 * halo);
+            vector<unsigned char *> out(rows);
+            for (int r = -halo; r < rows + halo; r++) {
+                int y = t.y0 + r;
+                y = y < 0 ? 0 : (y >= height ? height - 1 : y);
+                in[r + halo] = src + (size_t)y * srcStride;
+            }
+            for (int r = 0; r < rows; r++) {
+                out[r] = dst + (size_t)(t.y0 - firstRow + r) * dstStride;
+            }
+            fn(t, in.data() + halo, out.data());
+        });
+    }
+};
+
+#endif /* FilterExecutor_h */
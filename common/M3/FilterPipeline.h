@@ -0,0 +1,248 @@
+//
+//  FilterPipeline.h
+//
+//  Cadeia de filtros pontuais aplicada em uma única passada pela memória.
+//
+//  Em vez de cada filtro percorrer a imagem inteira, a imagem é dividida em
+//  blocos que cabem na cache e todos os filtros da cadeia são aplicados a um
+//  bloco antes de passar ao próximo; a memória principal é lida e escrita
+//  uma vez só, não importa o tamanho da cadeia.
+//
+//  Operações que tratam cada canal isoladamente (negativo, colorização,
+//  brilho, contraste, gama) viram tabelas de 256 entradas por canal, e
+//  tabelas consecutivas são compostas em uma só. Tons de cinza e chroma-key
+//  misturam canais e continuam como etapas próprias (com SIMD); o
+//  chroma-key suave usa a tabela 3D de ChromaKey.h, montada uma vez só.
+//
+
+#ifndef FilterPipeline_h
+#define FilterPipeline_h
+
+#include <math.h>
+#include <vector>
+#include <memory>
+
+#include "ImageFilters.h"
+#include "FilterExecutor.h"
+#include "ChromaKey.h"
+
+using namespace std;
+
+class FilterPipeline {
+    enum OpType { OP_CHROMA_KEY, OP_SOFT_KEY, OP_GRAY_SCALE, OP_COLORIZE, OP_NEGATIVE, OP_BRIGHTNESS, OP_CONTRAST, OP_GAMMA, OP_TABLE };
+
+    struct Op {
+        OpType type;
+        int r, g, b;
+        double value;
+        shared_ptr<const ChromaKeyLUT> key;
+        shared_ptr<const vector<unsigned char> > table;     // 3 x 256, OP_TABLE
+    };
+
+public:
+    // etapa já compilada: uma tabela composta ou um filtro entre canais
+    enum StageType { STAGE_LUT, STAGE_GRAY, STAGE_CHROMA, STAGE_SOFT_KEY, STAGE_NEGATIVE, STAGE_COLORIZE };
+
+    struct Stage {
+        StageType type;
+        unsigned char lut[3][256];
+        int r, g, b;
+        bool weighted;
+        double tolerance;
+        shared_ptr<const ChromaKeyLUT> key;
+    };
+
+private:
+    vector<Op> ops;
+    vector<Stage> stages;
+
+    static unsigned char clampByte(double v) {
+        return v < 0 ? 0 : (v > 255 ? 255 : (unsigned char)(v + 0.5));
+    }
+
+    static bool isPerChannel(OpType t) {
+        return t != OP_CHROMA_KEY && t != OP_SOFT_KEY && t != OP_GRAY_SCALE;
+    }
+
+    static unsigned char applyOp(const Op &op, int c, unsigned char v) {
+        switch (op.type) {
+            case OP_NEGATIVE:   return v ^ 255;
+            case OP_COLORIZE:   return v | (c == 0 ? op.r : (c == 1 ? op.g : op.b));
+            case OP_BRIGHTNESS: return clampByte(v + op.value);
+            case OP_CONTRAST:   return clampByte((v - 128.0) * op.value + 128.0);
+            case OP_GAMMA:      return clampByte(255.0 * pow(v / 255.0, 1.0 / op.value));
+            case OP_TABLE:      return (*op.table)[c * 256 + v];
+            default:            return v;
+        }
+    }
+
+    FilterPipeline &add(OpType type, int r, int g, int b, double value,
+                        shared_ptr<const ChromaKeyLUT> key = shared_ptr<const ChromaKeyLUT>()) {
+        Op op;
+        op.type = type;
+        op.r = r;
+        op.g = g;
+        op.b = b;
+        op.value = value;
+        op.key = key;
+        ops.push_back(op);
+        compile();
+        return *this;
+    }
+
+    void compile() {
+        stages.clear();
+        size_t i = 0;
+        while (i < ops.size()) {
+            Stage s = Stage();
+            if (!isPerChannel(ops[i].type)) {
+                s.type = ops[i].type == OP_GRAY_SCALE ? STAGE_GRAY : (ops[i].type == OP_SOFT_KEY ? STAGE_SOFT_KEY : STAGE_CHROMA);
+                s.r = ops[i].r;
+                s.g = ops[i].g;
+                s.b = ops[i].b;
+                s.weighted = ops[i].value != 0;
+                s.tolerance = ops[i].value;
+                s.key = ops[i].key;
+                stages.push_back(s);
+                i++;
+                continue;
+            }
+            // junta todas as operações por canal seguidas em uma tabela
+            size_t j = i;
+            while (j < ops.size() && isPerChannel(ops[j].type)) j++;
+            if (j - i == 1 && (ops[i].type == OP_NEGATIVE || ops[i].type == OP_COLORIZE)) {
+                // sozinhas, estas duas são mais rápidas direto em SIMD
+                s.type = ops[i].type == OP_NEGATIVE ? STAGE_NEGATIVE : STAGE_COLORIZE;
+                s.r = ops[i].r;
+                s.g = ops[i].g;
+                s.b = ops[i].b;
+            } else {
+                s.type = STAGE_LUT;
+                for (int c = 0; c < 3; c++) {
+                    for (int v = 0; v < 256; v++) {
+                        unsigned char x = (unsigned char)v;
+                        for (size_t k = i; k < j; k++) x = applyOp(ops[k], c, x);
+                        s.lut[c][v] = x;
+                    }
+                }
+            }
+            stages.push_back(s);
+            i = j;
+        }
+    }
+
+    static void applyStage(const Stage &s, unsigned char *data, size_t pixels) {
+        switch (s.type) {
+            case STAGE_GRAY:     grayScaleRGB8(data, pixels, s.weighted); break;
+            case STAGE_CHROMA:   chromaKeyRGB8(data, pixels, s.r, s.g, s.b, s.tolerance); break;
+            case STAGE_SOFT_KEY: s.key->keyRGB(data, pixels); break;
+            case STAGE_NEGATIVE: negativeRGB8(data, pixels); break;
+            case STAGE_COLORIZE: colorizeRGB8(data, pixels, s.r, s.g, s.b); break;
+            case STAGE_LUT:
+                for (size_t i = 0; i < pixels * 3; i += 3) {
+                    data[i] = s.lut[0][data[i]];
+                    data[i + 1] = s.lut[1][data[i + 1]];
+                    data[i + 2] = s.lut[2][data[i + 2]];
+                }
+                break;
+        }
+    }
+
+public:
+    // pixels processados por vez dentro de um bloco: 12 KB, cabe na L1
+    static const size_t SUB_BLOCK_PIXELS = 4096;
+
+    FilterPipeline &chromaKey(int r, int g, int b, double tolerance) {
+        return add(OP_CHROMA_KEY, r, g, b, tolerance);
+    }
+
+    // chroma-key com borda suave e remoção de reflexo, compondo sobre preto
+    // (ver ChromaKeyLUT::build)
+    FilterPipeline &softChromaKey(int r, int g, int b, double tolerance, double softness, double spill) {
+        shared_ptr<ChromaKeyLUT> key(new ChromaKeyLUT());
+        key->build(r, g, b, tolerance, softness, spill);
+        return add(OP_SOFT_KEY, r, g, b, tolerance, key);
+    }
+
+    FilterPipeline &grayScale(bool weighted = true) {
+        return add(OP_GRAY_SCALE, 0, 0, 0, weighted ? 1 : 0);
+    }
+
+    FilterPipeline &colorize(int r, int g, int b) {
+        return add(OP_COLORIZE, r, g, b, 0);
+    }
+
+    FilterPipeline &negative() {
+        return add(OP_NEGATIVE, 0, 0, 0, 0);
+    }
+
+    // soma 'delta' a cada canal
+    FilterPipeline &brightness(int delta) {
+        return add(OP_BRIGHTNESS, 0, 0, 0, delta);
+    }
+
+    // multiplica a distância de cada canal ao cinza médio (128)
+    FilterPipeline &contrast(double factor) {
+        return add(OP_CONTRAST, 0, 0, 0, factor);
+    }
+
+    // correção de gama: saída = 255 * (v/255)^(1/gamma)
+    FilterPipeline &gamma(double g) {
+        return add(OP_GAMMA, 0, 0, 0, g > 0 ? g : 1.0);
+    }
+
+    // tabela qualquer por canal, lut[c][v] (equalização, níveis automáticos)
+    FilterPipeline &table(const unsigned char lut[3][256]) {
+        Op op;
+        op.type = OP_TABLE;
+        op.r = op.g = op.b = 0;
+        op.value = 0;
+        op.table = make_shared<const vector<unsigned char> >(&lut[0][0], &lut[0][0] + 3 * 256);
+        ops.push_back(op);
+        compile();
+        return *this;
+    }
+
+    size_t size() const {
+        return ops.size();
+    }
+
+    // etapas depois da composição das tabelas
+    size_t stageCount() const {
+        return stages.size();
+    }
+
+    // as etapas em si, para outros backends (GLFilters.h)
+    const vector<Stage> &compiledStages() const {
+        return stages;
+    }
+
+    bool empty() const {
+        return ops.empty();
+    }
+
+    void clear() {
+        ops.clear();
+        stages.clear();
+    }
+
+    // Aplica toda a cadeia em um trecho contíguo de pixels RGB8, em
+    // sub-blocos que ficam na L1 enquanto passam por todas as etapas.
+    void applyBlock(unsigned char *data, size_t pixels) const {
+        for (size_t first = 0; first < pixels; first += SUB_BLOCK_PIXELS) {
+            size_t n = pixels - first < SUB_BLOCK_PIXELS ? pixels - first : SUB_BLOCK_PIXELS;
+            for (size_t s = 0; s < stages.size(); s++) {
+                applyStage(stages[s], data + first * 3, n);
+            }
+        }
+    }
+
+    void apply(FilterExecutor &exec, unsigned char *data, size_t pixels) const {
+        if (stages.empty()) return;
+        exec.run(data, pixels, 3, [this](unsigned char *p, size_t n) {
+            applyBlock(p, n);
+        });
+    }
+};
+
+#endif /* FilterPipeline_h */
@@ -0,0 +1,416 @@
+//
+//  GLFilters.h
+//
+//  Backend OpenGL para os filtros pontuais do exemplo_03.
+//
+//  Uma FilterPipeline (já com as tabelas compostas) vira um único fragment
+//  shader: cada etapa é um trecho de GLSL com a mesma conta inteira da
+//  versão da CPU, então o resultado sai igual byte a byte. Os pixels sobem
+//  como textura inteira (RGB8UI), o shader desenha em um FBO RGBA8UI e a
+//  volta é por pixel buffer objects: glReadPixels em um PBO retorna na
+//  hora, e o PBO só é mapeado depois que o pedaço seguinte foi enviado,
+//  então a cópia de volta de um pedaço sobrepõe o cálculo do próximo.
+//
+//  Como os filtros são pontuais, a forma da imagem não importa: os pixels
+//  são vistos como um vetor e passam em pedaços de CHUNK_WIDTH x CHUNK_ROWS,
+//  seja qual for o tamanho máximo de textura da placa.
+//
+//  Precisa de um contexto OpenGL 3.3 corrente com a GLAD carregada;
+//  glCreateHiddenContext (GLContext.h) cria um, inclusive sem display.
+//
+
+#ifndef GLFilters_h
+#define GLFilters_h
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "GLContext.h"
+#include "FilterPipeline.h"
+
+using namespace std;
+
+class GLFilterPipeline {
+public:
+    static const int CHUNK_WIDTH = 2048;
+    static const int CHUNK_ROWS = 1024;     // 2 M pixels por pedaço
+    static const int SLOTS = 3;             // leituras em andamento
+    static const int RAMP_WIDTH = 1024;     // linha da textura da rampa do chroma-key
+
+private:
+    struct Slot {
+        GLuint pbo;
+        GLsync fence;
+        unsigned char *dst;
+        size_t pixels;
+    };
+
+    GLuint program, vao, fbo, colorTex, srcTex, lutTex;
+    vector<GLuint> keyTex;
+    Slot slots[SLOTS];
+    int oldest, pending;
+    bool ready;
+
+    static string num(long v) {
+        return to_string(v) + "u";
+    }
+
+    static GLuint compileShader(GLenum type, const string &source) {
+        GLuint s = glCreateShader(type);
+        const char *src = source.c_str();
+        glShaderSource(s, 1, &src, NULL);
+        glCompileShader(s);
+        GLint ok;
+        glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
+        if (!ok) {
+            char log[1024];
+            glGetShaderInfoLog(s, sizeof(log), NULL, log);
+            cerr << "Erro ao compilar o shader: " << log << endl;
+            glDeleteShader(s);
+            return 0;
+        }
+        return s;
+    }
+
+    static GLuint integerTexture(GLenum target) {
+        GLuint t;
+        glGenTextures(1, &t);
+        glBindTexture(target, t);
+        // texturas inteiras só são completas sem filtragem
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        return t;
+    }
+
+    // Trecho de GLSL de uma etapa, sobre 'c' (uvec3). Mesmas contas das
+    // versões escalares de ImageFilters.h e ChromaKey.h.
+    static string stageCode(const FilterPipeline::Stage &s, int lutRow, int key) {
+        string code;
+        switch (s.type) {
+            case FilterPipeline::STAGE_LUT:
+                code = "    c = uvec3(texelFetch(luts, ivec2(c.r, " + to_string(lutRow) + "), 0).r,\n"
+                       "              texelFetch(luts, ivec2(c.g, " + to_string(lutRow + 1) + "), 0).r,\n"
+                       "              texelFetch(luts, ivec2(c.b, " + to_string(lutRow + 2) + "), 0).r);\n";
+                break;
+            case FilterPipeline::STAGE_NEGATIVE:
+                code = "    c ^= uvec3(255u);\n";
+                break;
+            case FilterPipeline::STAGE_COLORIZE:
+                code = "    c |= uvec3(" + num(s.r) + ", " + num(s.g) + ", " + num(s.b) + ");\n";
+                break;
+            case FilterPipeline::STAGE_GRAY: {
+                GrayWeights w = grayWeights(s.weighted);
+                code = "    c = uvec3(gray(c, uvec3(" + num(w.r) + ", " + num(w.g) + ", " + num(w.b) + ")));\n";
+                break;
+            }
+            case FilterPipeline::STAGE_CHROMA: {
+                code = "    if (dist2(c, ivec3(" + to_string(s.r) + ", " + to_string(s.g) + ", " + to_string(s.b) + ")) < " +
+                       to_string((long)chromaThreshold2(s.tolerance)) + ") c = uvec3(0u);\n";
+                break;
+            }
+            case FilterPipeline::STAGE_SOFT_KEY: {
+                const ChromaKeyLUT &k = *s.key;
+                string a = "a" + to_string(key);
+                code = "    uint " + a + " = keyAlpha(key" + to_string(key) + ", dist2(c, ivec3(" + to_string(k.keyChannel(0)) + ", " +
+                       to_string(k.keyChannel(1)) + ", " + to_string(k.keyChannel(2)) + ")), " + to_string(k.rampSize() - 1) + ");\n";
+                int ch = k.spillChannelIndex();
+                if (ch >= 0) {
+                    const char *names = "rgb";
+                    string own = string("c.") + names[ch];
+                    string o1 = string("c.") + names[ch == 0 ? 1 : 0];
+                    string o2 = string("c.") + names[ch == 2 ? 1 : 2];
+                    code += "    if (" + a + " != 0u) " + own + " = spill(" + own + ", max(" + o1 + ", " + o2 + "), " +
+                            num(k.spillStrength()) + ");\n";
+                }
+                code += "    c = (c * " + a + " + 127u) / 255u;\n";
+                break;
+            }
+        }
+        return code;
+    }
+
+    void releaseProgram() {
+        if (program) glDeleteProgram(program);
+        if (lutTex) glDeleteTextures(1, &lutTex);
+        if (!keyTex.empty()) glDeleteTextures((GLsizei)keyTex.size(), keyTex.data());
+        program = lutTex = 0;
+        keyTex.clear();
+    }
+
+    // espera a leitura mais antiga e copia para o destino
+    bool finishOldest() {
+        Slot &s = slots[oldest];
+        GLenum r;
+        do {
+            r = glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000);
+        } while (r == GL_TIMEOUT_EXPIRED);
+        glDeleteSync(s.fence);
+        s.fence = 0;
+        oldest = (oldest + 1) % SLOTS;
+        pending--;
+        if (r == GL_WAIT_FAILED) {
+            cerr << "Falha ao esperar a GPU" << endl;
+            return false;
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+        void *p = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, s.pixels * 3, GL_MAP_READ_BIT);
+        bool ok = p != NULL;
+        if (ok) {
+            memcpy(s.dst, p, s.pixels * 3);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        } else {
+            cerr << "Falha ao mapear o PBO" << endl;
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        return ok;
+    }
+
+    // envia até CHUNK_WIDTH * CHUNK_ROWS pixels e começa a leitura em um PBO
+    bool submit(const unsigned char *src, unsigned char *dst, size_t pixels) {
+        if (pending == SLOTS && !finishOldest()) return false;
+        int full = (int)(pixels / CHUNK_WIDTH);
+        int rest = (int)(pixels % CHUNK_WIDTH);
+        int rows = full + (rest ? 1 : 0);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, srcTex);
+        if (full) glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, CHUNK_WIDTH, full, GL_RGB_INTEGER, GL_UNSIGNED_BYTE, src);
+        if (rest) glTexSubImage2D(GL_TEXTURE_2D, 0, 0, full, rest, 1, GL_RGB_INTEGER, GL_UNSIGNED_BYTE,
+                                  src + (size_t)full * CHUNK_WIDTH * 3);
+
+        glViewport(0, 0, CHUNK_WIDTH, rows);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        Slot &s = slots[(oldest + pending) % SLOTS];
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+        if (full) glReadPixels(0, 0, CHUNK_WIDTH, full, GL_RGB_INTEGER, GL_UNSIGNED_BYTE, (void *)0);
+        if (rest) glReadPixels(0, full, rest, 1, GL_RGB_INTEGER, GL_UNSIGNED_BYTE,
+                               (void *)((size_t)full * CHUNK_WIDTH * 3));
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        s.dst = dst;
+        s.pixels = pixels;
+        pending++;
+        return true;
+    }
+
+public:
+    GLFilterPipeline() : program(0), vao(0), fbo(0), colorTex(0), srcTex(0), lutTex(0), oldest(0), pending(0), ready(false) {
+        for (int i = 0; i < SLOTS; i++) {
+            slots[i].pbo = 0;
+            slots[i].fence = 0;
+        }
+    }
+
+    // precisa do contexto ainda corrente
+    ~GLFilterPipeline() {
+        release();
+    }
+
+    GLFilterPipeline(const GLFilterPipeline &) = delete;
+    GLFilterPipeline &operator=(const GLFilterPipeline &) = delete;
+
+    // Cria texturas, FBO e PBOs no contexto corrente.
+    bool init() {
+        release();
+        srcTex = integerTexture(GL_TEXTURE_2D);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8UI, CHUNK_WIDTH, CHUNK_ROWS, 0, GL_RGB_INTEGER, GL_UNSIGNED_BYTE, NULL);
+        colorTex = integerTexture(GL_TEXTURE_2D);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8UI, CHUNK_WIDTH, CHUNK_ROWS, 0, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, NULL);
+
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTex, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            cerr << "FBO RGBA8UI incompleto" << endl;
+            release();
+            return false;
+        }
+
+        for (int i = 0; i < SLOTS; i++) {
+            glGenBuffers(1, &slots[i].pbo);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slots[i].pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)CHUNK_WIDTH * CHUNK_ROWS * 3, NULL, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        // o triângulo que cobre a tela sai de gl_VertexID, mas o perfil core exige um VAO
+        glGenVertexArrays(1, &vao);
+        glBindVertexArray(vao);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        ready = glGetError() == GL_NO_ERROR;
+        if (!ready) {
+            cerr << "Erro OpenGL ao preparar os filtros" << endl;
+            release();
+        }
+        return ready;
+    }
+
+    void release() {
+        while (pending > 0) finishOldest();
+        releaseProgram();
+        for (int i = 0; i < SLOTS; i++) {
+            if (slots[i].pbo) glDeleteBuffers(1, &slots[i].pbo);
+            slots[i].pbo = 0;
+        }
+        if (fbo) glDeleteFramebuffers(1, &fbo);
+        if (colorTex) glDeleteTextures(1, &colorTex);
+        if (srcTex) glDeleteTextures(1, &srcTex);
+        if (vao) glDeleteVertexArrays(1, &vao);
+        fbo = colorTex = srcTex = vao = 0;
+        ready = false;
+    }
+
+    // Gera e compila o shader das etapas de 'pipeline' (tabelas por canal
+    // viram uma textura 256 x 3n; cada chroma-key suave, a sua rampa de
+    // alfa em uma textura RAMP_WIDTH x m).
+    bool setPipeline(const FilterPipeline &pipeline) {
+        if (!ready) {
+            cerr << "GLFilterPipeline::init não foi chamado" << endl;
+            return false;
+        }
+        releaseProgram();
+        const vector<FilterPipeline::Stage> &stages = pipeline.compiledStages();
+
+        string body;
+        vector<unsigned char> lutRows;
+        vector<const ChromaKeyLUT *> keys;
+        for (size_t i = 0; i < stages.size(); i++) {
+            body += stageCode(stages[i], (int)(lutRows.size() / 256), (int)keys.size());
+            if (stages[i].type == FilterPipeline::STAGE_LUT) {
+                lutRows.insert(lutRows.end(), &stages[i].lut[0][0], &stages[i].lut[0][0] + 3 * 256);
+            } else if (stages[i].type == FilterPipeline::STAGE_SOFT_KEY) {
+                keys.push_back(stages[i].key.get());
+            }
+        }
+
+        string fs =
+            "#version 330 core\n"
+            "uniform usampler2D src;\n"
+            "uniform usampler2D luts;\n";
+        for (size_t k = 0; k < keys.size(); k++) fs += "uniform usampler2D key" + to_string(k) + ";\n";
+        fs +=
+            "out uvec4 color;\n"
+            "\n"
+            "uint gray(uvec3 c, uvec3 w) {\n"
+            "    uvec3 t = ((c << 8u) * w) >> 16u;\n"
+            "    return (t.r + t.g + t.b + 128u) >> 8u;\n"
+            "}\n"
+            "\n"
+            "int dist2(uvec3 c, ivec3 key) {\n"
+            "    ivec3 d = ivec3(c) - key;\n"
+            "    return d.r * d.r + d.g * d.g + d.b * d.b;\n"
+            "}\n"
+            "\n"
+            "uint spill(uint v, uint limit, uint amount) {\n"
+            "    return v > limit ? v - (((v - limit) * amount + 128u) >> 8u) : v;\n"
+            "}\n"
+            "\n"
+            // a GPU não ganha nada com as células prontas: vai direto à rampa
+            "uint keyAlpha(usampler2D ramp, int d2, int last) {\n"
+            "    d2 = min(d2, last);\n"
+            "    return texelFetch(ramp, ivec2(d2 % " + to_string(RAMP_WIDTH) + ", d2 / " + to_string(RAMP_WIDTH) + "), 0).r;\n"
+            "}\n"
+            "\n"
+            "void main() {\n"
+            "    uvec3 c = texelFetch(src, ivec2(gl_FragCoord.xy), 0).rgb;\n" +
+            body +
+            "    color = uvec4(c, 255u);\n"
+            "}\n";
+        const char *vs =
+            "#version 330 core\n"
+            "void main() {\n"
+            "    vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+            "    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);\n"
+            "}\n";
+
+        GLuint v = compileShader(GL_VERTEX_SHADER, vs);
+        GLuint f = compileShader(GL_FRAGMENT_SHADER, fs);
+        if (!v || !f) {
+            if (v) glDeleteShader(v);
+            if (f) glDeleteShader(f);
+            return false;
+        }
+        program = glCreateProgram();
+        glAttachShader(program, v);
+        glAttachShader(program, f);
+        glLinkProgram(program);
+        glDeleteShader(v);
+        glDeleteShader(f);
+        GLint ok;
+        glGetProgramiv(program, GL_LINK_STATUS, &ok);
+        if (!ok) {
+            char log[1024];
+            glGetProgramInfoLog(program, sizeof(log), NULL, log);
+            cerr << "Erro ao ligar o shader: " << log << endl;
+            releaseProgram();
+            return false;
+        }
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "src"), 0);
+
+        glActiveTexture(GL_TEXTURE1);
+        lutTex = integerTexture(GL_TEXTURE_2D);
+        if (!lutRows.empty()) {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, 256, (GLsizei)(lutRows.size() / 256), 0, GL_RED_INTEGER,
+                         GL_UNSIGNED_BYTE, lutRows.data());
+        }
+        glUniform1i(glGetUniformLocation(program, "luts"), 1);
+
+        for (size_t k = 0; k < keys.size(); k++) {
+            glActiveTexture(GL_TEXTURE2 + (GLenum)k);
+            keyTex.push_back(integerTexture(GL_TEXTURE_2D));
+            int n = keys[k]->rampSize();
+            vector<unsigned char> ramp(keys[k]->rampData(), keys[k]->rampData() + n);
+            ramp.resize((n + RAMP_WIDTH - 1) / RAMP_WIDTH * RAMP_WIDTH, 255);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, RAMP_WIDTH, (GLsizei)(ramp.size() / RAMP_WIDTH), 0, GL_RED_INTEGER,
+                         GL_UNSIGNED_BYTE, ramp.data());
+            glUniform1i(glGetUniformLocation(program, ("key" + to_string(k)).c_str()), 2 + (GLint)k);
+        }
+        glActiveTexture(GL_TEXTURE0);
+        if (glGetError() != GL_NO_ERROR) {
+            cerr << "Erro OpenGL ao montar as tabelas do shader" << endl;
+            releaseProgram();
+            return false;
+        }
+        return true;
+    }
+
+    // Filtra 'pixels' pixels RGB8 de 'src' para 'dst' (podem ser o mesmo
+    // buffer). Volta só quando todo o resultado estiver em 'dst'.
+    bool apply(const unsigned char *src, unsigned char *dst, size_t pixels) {
+        if (!program) {
+            cerr << "GLFilterPipeline: nenhuma cadeia definida" << endl;
+            return false;
+        }
+        const size_t chunk = (size_t)CHUNK_WIDTH * CHUNK_ROWS;
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glBindVertexArray(vao);
+        glUseProgram(program);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, lutTex);
+        for (size_t k = 0; k < keyTex.size(); k++) {
+            glActiveTexture(GL_TEXTURE2 + (GLenum)k);
+            glBindTexture(GL_TEXTURE_2D, keyTex[k]);
+        }
+        bool ok = true;
+        for (size_t first = 0; first < pixels && ok; first += chunk) {
+            size_t n = pixels - first < chunk ? pixels - first : chunk;
+            ok = submit(src + first * 3, dst + first * 3, n);
+        }
+        while (pending > 0) ok = finishOldest() && ok;
+        return ok;
+    }
+
+    bool apply(unsigned char *data, size_t pixels) {
+        return apply(data, data, pixels);
+    }
+};
+
+#endif /* GLFilters_h */
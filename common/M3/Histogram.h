@@ -0,0 +1,252 @@
+//
+//  Histogram.h
+//
+//  Histogramas de imagens RGB8 (um por canal e um da luminância) e os
+//  ajustes automáticos feitos a partir deles: equalização, níveis
+//  automáticos e CLAHE (equalização por regiões com limite de contraste).
+//
+//  A contagem roda no FilterExecutor como os filtros: cada pedaço conta em
+//  uma tabela de 32 bits na pilha e soma na tabela privada da thread que o
+//  executou; as tabelas das threads só são somadas no fim, sem travas nem
+//  atômicos durante a varredura.
+//
+
+#ifndef Histogram_h
+#define Histogram_h
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+#include "ImageFilters.h"
+#include "FilterExecutor.h"
+
+using namespace std;
+
+// alinhada à linha de cache: as tabelas privadas ficam lado a lado num vetor
+struct alignas(64) Histogram {
+    enum Channel { RED, GREEN, BLUE, LUMA };
+
+    uint64_t bins[4][256];
+    uint64_t pixels;
+
+    Histogram() {
+        clear();
+    }
+
+    void clear() {
+        memset(bins, 0, sizeof(bins));
+        pixels = 0;
+    }
+
+    void merge(const Histogram &other) {
+        for (int c = 0; c < 4; c++) {
+            for (int v = 0; v < 256; v++) bins[c][v] += other.bins[c][v];
+        }
+        pixels += other.pixels;
+    }
+
+    // menor valor v com pelo menos a fração 'fraction' dos pixels <= v
+    int percentile(int channel, double fraction) const {
+        double target = fraction * (double)pixels;
+        uint64_t sum = 0;
+        for (int v = 0; v < 256; v++) {
+            sum += bins[channel][v];
+            if (sum > 0 && (double)sum >= target) return v;
+        }
+        return 255;
+    }
+
+    double mean(int channel) const {
+        double sum = 0;
+        for (int v = 0; v < 256; v++) sum += (double)v * bins[channel][v];
+        return pixels ? sum / pixels : 0.0;
+    }
+};
+
+// conta um trecho; a luminância é a mesma do filtro de tons de cinza
+inline void histogramCount(const unsigned char *data, size_t pixels, uint32_t counts[4][256], GrayWeights w) {
+    for (size_t i = 0; i < pixels * 3; i += 3) {
+        unsigned r = data[i], g = data[i + 1], b = data[i + 2];
+        counts[0][r]++;
+        counts[1][g]++;
+        counts[2][b]++;
+        counts[3][grayPixel(r, g, b, w)]++;
+    }
+}
+
+inline void histogramRGB8(FilterExecutor &exec, const unsigned char *data, size_t pixels, Histogram &out) {
+    GrayWeights w = grayWeights(true);
+    vector<Histogram> partial(exec.threadCount());
+    // run não escreve nos pixels: só divide o intervalo
+    exec.run((unsigned char *)data, pixels, 3, [&](unsigned char *p, size_t n) {
+        uint32_t counts[4][256];
+        memset(counts, 0, sizeof(counts));
+        histogramCount(p, n, counts, w);
+        Histogram &h = partial[exec.threadIndex()];
+        for (int c = 0; c < 4; c++) {
+            for (int v = 0; v < 256; v++) h.bins[c][v] += counts[c][v];
+        }
+        h.pixels += n;
+    });
+    out.clear();
+    for (size_t t = 0; t < partial.size(); t++) out.merge(partial[t]);
+}
+
+// Curva de equalização de um histograma: a distribuição acumulada,
+// esticada para que o primeiro valor presente vá a 0 e o último a 255.
+inline void equalizationCurve(const uint64_t *bins, unsigned char *lut) {
+    uint64_t total = 0, first = 0;
+    for (int v = 0; v < 256; v++) {
+        if (total == 0) first = bins[v];
+        total += bins[v];
+    }
+    if (total == first) {
+        // imagem de uma cor só (ou vazia): nada a equalizar
+        for (int v = 0; v < 256; v++) lut[v] = (unsigned char)v;
+        return;
+    }
+    uint64_t cdf = 0, range = total - first;
+    for (int v = 0; v < 256; v++) {
+        cdf += bins[v];
+        lut[v] = cdf < first ? 0 : (unsigned char)(((cdf - first) * 255 + range / 2) / range);
+    }
+}
+
+// Com perChannel, cada canal pela sua própria curva (corrige dominantes de
+// cor, mas muda os tons); senão a curva da luminância nos três canais.
+inline void equalizationTables(const Histogram &h, bool perChannel, unsigned char lut[3][256]) {
+    if (perChannel) {
+        for (int c = 0; c < 3; c++) equalizationCurve(h.bins[c], lut[c]);
+    } else {
+        equalizationCurve(h.bins[Histogram::LUMA], lut[0]);
+        memcpy(lut[1], lut[0], 256);
+        memcpy(lut[2], lut[0], 256);
+    }
+}
+
+// Níveis automáticos: em cada canal, os valores abaixo do percentil 'clip'
+// vão a 0, os acima de 1 - clip a 255 e o meio é esticado linearmente.
+inline void autoLevelsTables(const Histogram &h, double clip, unsigned char lut[3][256]) {
+    clip = clip < 0 ? 0 : (clip > 0.49 ? 0.49 : clip);
+    for (int c = 0; c < 3; c++) {
+        int lo = h.percentile(c, clip);
+        int hi = h.percentile(c, 1.0 - clip);
+        for (int v = 0; v < 256; v++) {
+            if (hi <= lo) {
+                lut[c][v] = (unsigned char)v;
+            } else {
+                int x = ((v - lo) * 255 * 2 + (hi - lo)) / (2 * (hi - lo));
+                lut[c][v] = v <= lo ? 0 : (x > 255 ? 255 : (unsigned char)x);
+            }
+        }
+    }
+}
+
+// Curva de uma região do CLAHE: as barras acima de clipLimit vezes a
+// altura média são cortadas e o excesso espalhado por todos os valores,
+// o que limita a inclinação da curva (e o ruído realçado em áreas lisas).
+inline void claheCurve(uint32_t *bins, uint32_t area, double clipLimit, unsigned char *lut) {
+    uint32_t limit = (uint32_t)(clipLimit * area / 256.0);
+    limit = limit < 1 ? 1 : limit;
+    uint32_t excess = 0;
+    for (int v = 0; v < 256; v++) {
+        if (bins[v] > limit) {
+            excess += bins[v] - limit;
+            bins[v] = limit;
+        }
+    }
+    uint32_t each = excess / 256, rest = excess % 256;
+    for (int v = 0; v < 256; v++) bins[v] += each;
+    for (uint32_t k = 0; k < rest; k++) bins[k * 256 / rest]++;
+
+    uint64_t cdf = 0;
+    for (int v = 0; v < 256; v++) {
+        cdf += bins[v];
+        lut[v] = (unsigned char)((cdf * 255 + area / 2) / area);
+    }
+}
+
+// posição de cada coluna (ou linha) entre os centros das duas regiões mais
+// próximas, com peso em 8.8
+struct ClaheAxis {
+    vector<int> t0, t1, weight;
+
+    void build(int size, int tiles) {
+        t0.resize(size);
+        t1.resize(size);
+        weight.resize(size);
+        for (int x = 0; x < size; x++) {
+            double g = (x + 0.5) * tiles / size - 0.5;
+            int i = g < 0 ? 0 : (int)g;
+            i = i > tiles - 1 ? tiles - 1 : i;
+            double f = g - i;
+            f = f < 0 ? 0 : (f > 1 ? 1 : f);
+            t0[x] = i;
+            t1[x] = i + 1 < tiles ? i + 1 : i;
+            weight[x] = (int)(f * 256 + 0.5);
+        }
+    }
+};
+
+// CLAHE na luminância, em tiles x tiles regiões; clipLimit em múltiplos da
+// altura média do histograma (1 = quase nenhum realce, 2 a 4 é o usual).
+// A luminância de cada pixel vai pela interpolação bilinear das curvas das
+// quatro regiões vizinhas e os três canais são escalados na mesma razão.
+inline void claheRGB8(FilterExecutor &exec, unsigned char *data, int width, int height, int tiles = 8,
+                      double clipLimit = 2.0) {
+    int tilesX = tiles < 1 ? 1 : (tiles > width ? width : tiles);
+    int tilesY = tiles < 1 ? 1 : (tiles > height ? height : tiles);
+    if (tilesX < 1 || tilesY < 1) return;
+    GrayWeights w = grayWeights(true);
+    vector<unsigned char> curves((size_t)tilesX * tilesY * 256);
+
+    // uma região por tarefa: o histograma de cada uma já é privado
+    exec.threads().parallelFor(tilesX * tilesY, [&](int t) {
+        int tx = t % tilesX, ty = t / tilesX;
+        int x0 = (int)((long long)tx * width / tilesX), x1 = (int)((long long)(tx + 1) * width / tilesX);
+        int y0 = (int)((long long)ty * height / tilesY), y1 = (int)((long long)(ty + 1) * height / tilesY);
+        uint32_t bins[256];
+        memset(bins, 0, sizeof(bins));
+        for (int y = y0; y < y1; y++) {
+            const unsigned char *p = data + ((size_t)y * width + x0) * 3;
+            for (int x = x0; x < x1; x++, p += 3) bins[grayPixel(p[0], p[1], p[2], w)]++;
+        }
+        claheCurve(bins, (uint32_t)(x1 - x0) * (y1 - y0), clipLimit, &curves[(size_t)t * 256]);
+    });
+
+    ClaheAxis ax, ay;
+    ax.build(width, tilesX);
+    ay.build(height, tilesY);
+    exec.run(data, (size_t)width * height, 3, [&](unsigned char *p, size_t n) {
+        size_t index = (size_t)(p - data) / 3;
+        int y = (int)(index / width), x = (int)(index % width);
+        for (size_t i = 0; i < n; i++, p += 3) {
+            const unsigned char *top = &curves[(size_t)ay.t0[y] * tilesX * 256];
+            const unsigned char *bottom = &curves[(size_t)ay.t1[y] * tilesX * 256];
+            int l = grayPixel(p[0], p[1], p[2], w);
+            int c0 = ax.t0[x] * 256 + l, c1 = ax.t1[x] * 256 + l;
+            int wx = ax.weight[x], wy = ay.weight[y];
+            int upper = top[c0] * (256 - wx) + top[c1] * wx;
+            int lower = bottom[c0] * (256 - wx) + bottom[c1] * wx;
+            int v = (upper * (256 - wy) + lower * wy + 32768) >> 16;
+            if (l == 0) {
+                p[0] = p[1] = p[2] = (unsigned char)v;
+            } else {
+                // razão v / l em 16.16: uma divisão por pixel, não três
+                unsigned gain = ((unsigned)v << 16) / l;
+                for (int c = 0; c < 3; c++) {
+                    unsigned s = (p[c] * gain + 32768) >> 16;
+                    p[c] = (unsigned char)(s > 255 ? 255 : s);
+                }
+            }
+            if (++x == width) {
+                x = 0;
+                y++;
+            }
+        }
+    });
+}
+
+#endif /* Histogram_h */
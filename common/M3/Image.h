@@ -0,0 +1,708 @@
+//
+//  Image.h
+//
+//  Imagem com o formato do pixel no tipo: Image<RGB8>, Image<RGB16>,
+//  Image<RGBA8>, Image<RGBF, Planar>... O formato diz o tipo da amostra
+//  (8 ou 16 bits, float) e quantos canais há; o layout diz se os canais
+//  ficam intercalados (RGBRGB...) ou em planos separados (RRR... GGG...
+//  BBB...), que é o que o SIMD prefere.
+//
+//  As vistas (ImageView) não são donas dos pixels e têm stride, então um
+//  recorte ou um buffer com preenchimento no fim das linhas é só outra vista.
+//  As conversões entre formatos e layouts têm versões SIMD para os pares
+//  comuns e uma versão genérica para o resto; como tudo é decidido pelos
+//  tipos, nenhum laço testa o formato a cada pixel.
+//
+
+#ifndef Image_h
+#define Image_h
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+#include "ImageFilters.h"
+#include "PPM.h"
+
+using namespace std;
+
+template <typename S>
+struct SampleTraits;
+
+template <>
+struct SampleTraits<uint8_t> {
+    static uint8_t maxValue() { return 255; }
+};
+
+template <>
+struct SampleTraits<uint16_t> {
+    static uint16_t maxValue() { return 65535; }
+};
+
+// float vai de 0 a 1
+template <>
+struct SampleTraits<float> {
+    static float maxValue() { return 1.0f; }
+};
+
+template <typename S, int C>
+struct PixelFormat {
+    typedef S Sample;
+    static constexpr int channels = C;
+
+    static S maxValue() {
+        return SampleTraits<S>::maxValue();
+    }
+};
+
+typedef PixelFormat<uint8_t, 1> Gray8;
+typedef PixelFormat<uint8_t, 3> RGB8;
+typedef PixelFormat<uint8_t, 4> RGBA8;
+typedef PixelFormat<uint16_t, 1> Gray16;
+typedef PixelFormat<uint16_t, 3> RGB16;
+typedef PixelFormat<uint16_t, 4> RGBA16;
+typedef PixelFormat<float, 1> GrayF;
+typedef PixelFormat<float, 3> RGBF;
+typedef PixelFormat<float, 4> RGBAF;
+
+struct Interleaved {};
+struct Planar {};
+
+template <class Format, class Layout = Interleaved>
+struct ImageView;
+
+// canais intercalados; stride em amostras, entre o início de duas linhas
+template <class Format>
+struct ImageView<Format, Interleaved> {
+    typedef typename Format::Sample Sample;
+
+    Sample *data;
+    int width, height;
+    size_t stride;
+
+    ImageView() : data(NULL), width(0), height(0), stride(0) {}
+
+    ImageView(Sample *data, int width, int height, size_t stride = 0)
+        : data(data), width(width), height(height), stride(stride ? stride : (size_t)width * Format::channels) {}
+
+    Sample *row(int y) const {
+        return data + (size_t)y * stride;
+    }
+
+    Sample &at(int x, int y, int c) const {
+        return row(y)[(size_t)x * Format::channels + c];
+    }
+
+    bool contiguous() const {
+        return stride == (size_t)width * Format::channels;
+    }
+
+    ImageView crop(int x, int y, int w, int h) const {
+        return ImageView(row(y) + (size_t)x * Format::channels, w, h, stride);
+    }
+};
+
+// um plano por canal; planeStride em amostras, entre o início de dois planos
+template <class Format>
+struct ImageView<Format, Planar> {
+    typedef typename Format::Sample Sample;
+    typedef ImageView<PixelFormat<Sample, 1>, Interleaved> PlaneView;
+
+    Sample *data;
+    int width, height;
+    size_t stride, planeStride;
+
+    ImageView() : data(NULL), width(0), height(0), stride(0), planeStride(0) {}
+
+    ImageView(Sample *data, int width, int height, size_t stride = 0, size_t planeStride = 0)
+        : data(data), width(width), height(height), stride(stride ? stride : (size_t)width),
+          planeStride(planeStride ? planeStride : (stride ? stride : (size_t)width) * height) {}
+
+    Sample *row(int y, int c) const {
+        return data + c * planeStride + (size_t)y * stride;
+    }
+
+    Sample &at(int x, int y, int c) const {
+        return row(y, c)[x];
+    }
+
+    PlaneView plane(int c) const {
+        return PlaneView(data + c * planeStride, width, height, stride);
+    }
+
+    ImageView crop(int x, int y, int w, int h) const {
+        return ImageView(row(y, 0) + x, w, h, stride, planeStride);
+    }
+};
+
+// Dona dos pixels: linhas compactas (dá para passar data() para as funções
+// que esperam RGB8 compacto) e início alinhado em 64 bytes.
+template <class Format, class Layout = Interleaved>
+class Image {
+public:
+    typedef typename Format::Sample Sample;
+    typedef ImageView<Format, Layout> View;
+
+private:
+    static const size_t ALIGN = 64 / sizeof(Sample);
+
+    vector<Sample> storage;
+    size_t offset;
+    int w, h;
+
+public:
+    Image() : offset(0), w(0), h(0) {}
+
+    Image(int width, int height) : offset(0), w(0), h(0) {
+        resize(width, height);
+    }
+
+    Image(const Image &other) : offset(0), w(0), h(0) {
+        *this = other;
+    }
+
+    // a cópia pode cair em outro alinhamento: realoca e copia só os pixels
+    Image &operator=(const Image &other) {
+        if (this != &other) {
+            resize(other.w, other.h);
+            memcpy(data(), other.data(), sampleCount() * sizeof(Sample));
+        }
+        return *this;
+    }
+
+    Image(Image &&) = default;
+    Image &operator=(Image &&) = default;
+
+    // conteúdo não inicializado (zerado na primeira alocação)
+    void resize(int width, int height) {
+        w = width;
+        h = height;
+        storage.resize(sampleCount() + ALIGN);
+        size_t misalign = ((uintptr_t)storage.data() / sizeof(Sample)) % ALIGN;
+        offset = misalign ? ALIGN - misalign : 0;
+    }
+
+    int width() const {
+        return w;
+    }
+
+    int height() const {
+        return h;
+    }
+
+    size_t sampleCount() const {
+        return (size_t)w * h * Format::channels;
+    }
+
+    Sample *data() {
+        return storage.data() + offset;
+    }
+
+    const Sample *data() const {
+        return storage.data() + offset;
+    }
+
+    View view() {
+        return View(data(), w, h);
+    }
+
+    // vista de uma imagem constante: o chamador só deve ler por ela
+    View view() const {
+        return View(const_cast<Sample *>(data()), w, h);
+    }
+};
+
+/*---------------------------CONVERSÃO DE AMOSTRAS----------------------------*/
+template <typename A, typename B>
+inline B convertSample(A v) {
+    if (is_same<A, B>::value) return (B)v;
+    if (is_same<B, float>::value) return (B)(v * (1.0f / SampleTraits<A>::maxValue()));
+    if (is_same<A, float>::value) {
+        float x = (float)v * SampleTraits<B>::maxValue();
+        x = x < 0 ? 0 : (x > SampleTraits<B>::maxValue() ? SampleTraits<B>::maxValue() : x);
+        return (B)lrintf(x);
+    }
+    if (sizeof(A) == 1) return (B)(v * 257);                 // 8 -> 16 bits
+    return (B)(((uint32_t)v * 255 + 32767) / 65535);       // 16 -> 8 bits
+}
+
+template <class F>
+inline typename F::Sample &sampleAt(const ImageView<F, Interleaved> &v, int x, int y, int c) {
+    return v.at(x, y, c);
+}
+
+template <class F>
+inline typename F::Sample &sampleAt(const ImageView<F, Planar> &v, int x, int y, int c) {
+    return v.at(x, y, c);
+}
+
+// Conversão genérica, pixel a pixel: cinza vira R=G=B, cor vira a
+// luminância, o alfa que falta é opaco e o que sobra é descartado.
+template <class FA, class LA, class FB, class LB>
+inline void convertImage(const ImageView<FA, LA> &src, const ImageView<FB, LB> &dst) {
+    typedef typename FA::Sample A;
+    typedef typename FB::Sample B;
+    const int ca = FA::channels, cb = FB::channels;
+    for (int y = 0; y < src.height; y++) {
+        for (int x = 0; x < src.width; x++) {
+            if (ca >= 3 && cb < 3) {
+                float l = 0.2125f * convertSample<A, float>(sampleAt(src, x, y, 0)) +
+                          0.7154f * convertSample<A, float>(sampleAt(src, x, y, 1)) +
+                          0.0721f * convertSample<A, float>(sampleAt(src, x, y, 2));
+                sampleAt(dst, x, y, 0) = convertSample<float, B>(l);
+            } else {
+                for (int c = 0; c < (cb < 3 ? 1 : 3); c++) {
+                    sampleAt(dst, x, y, c) = convertSample<A, B>(sampleAt(src, x, y, ca < 3 ? 0 : c));
+                }
+            }
+            if (cb == 2 || cb == 4) {
+                sampleAt(dst, x, y, cb - 1) = (ca == 2 || ca == 4) ? convertSample<A, B>(sampleAt(src, x, y, ca - 1))
+                                                                    : FB::maxValue();
+            }
+        }
+    }
+}
+
+/*-------------------------------FAIXAS DE LINHA------------------------------*/
+// Cada conversão rápida trata uma linha; as versões SIMD terminam a linha
+// com a escalar.
+
+inline void splitRowScalar(const uint8_t *src, uint8_t *r, uint8_t *g, uint8_t *b, int n) {
+    for (int i = 0; i < n; i++, src += 3) {
+        r[i] = src[0];
+        g[i] = src[1];
+        b[i] = src[2];
+    }
+}
+
+inline void mergeRowScalar(const uint8_t *r, const uint8_t *g, const uint8_t *b, uint8_t *dst, int n) {
+    for (int i = 0; i < n; i++, dst += 3) {
+        dst[0] = r[i];
+        dst[1] = g[i];
+        dst[2] = b[i];
+    }
+}
+
+inline void narrowRowScalar(const uint16_t *src, uint8_t *dst, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = convertSample<uint16_t, uint8_t>(src[i]);
+}
+
+inline void widenRowScalar(const uint8_t *src, uint16_t *dst, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = (uint16_t)(src[i] * 257);
+}
+
+inline void toFloatRowScalar(const uint8_t *src, float *dst, int n) {
+    for (int i = 0; i < n; i++) dst[i] = src[i] * (1.0f / 255.0f);
+}
+
+inline void fromFloatRowScalar(const float *src, uint8_t *dst, int n) {
+    for (int i = 0; i < n; i++) dst[i] = convertSample<float, uint8_t>(src[i]);
+}
+
+#ifdef IF_X86_SIMD
+__attribute__((target("ssse3"))) inline void splitRowSSE(const uint8_t *src, uint8_t *r, uint8_t *g, uint8_t *b, int n) {
+    const RGBShuffleMasks &m = rgbShuffleMasks();
+    __m128i split[3][3];
+    for (int c = 0; c < 3; c++) {
+        for (int k = 0; k < 3; k++) split[c][k] = _mm_load_si128((const __m128i *)m.split[c][k]);
+    }
+    uint8_t *out[3] = { r, g, b };
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i *s = (const __m128i *)(src + 3 * i);
+        __m128i v0 = _mm_loadu_si128(s), v1 = _mm_loadu_si128(s + 1), v2 = _mm_loadu_si128(s + 2);
+        for (int c = 0; c < 3; c++) {
+            __m128i ch = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, split[c][0]), _mm_shuffle_epi8(v1, split[c][1])),
+                                      _mm_shuffle_epi8(v2, split[c][2]));
+            _mm_storeu_si128((__m128i *)(out[c] + i), ch);
+        }
+    }
+    splitRowScalar(src + 3 * i, r + i, g + i, b + i, n - i);
+}
+
+__attribute__((target("ssse3"))) inline void mergeRowSSE(const uint8_t *r, const uint8_t *g, const uint8_t *b, uint8_t *dst, int n) {
+    const RGBShuffleMasks &m = rgbShuffleMasks();
+    __m128i merge[3][3];
+    for (int k = 0; k < 3; k++) {
+        for (int c = 0; c < 3; c++) merge[k][c] = _mm_load_si128((const __m128i *)m.merge[k][c]);
+    }
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i ch[3] = { _mm_loadu_si128((const __m128i *)(r + i)), _mm_loadu_si128((const __m128i *)(g + i)),
+                          _mm_loadu_si128((const __m128i *)(b + i)) };
+        __m128i *d = (__m128i *)(dst + 3 * i);
+        for (int k = 0; k < 3; k++) {
+            __m128i v = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(ch[0], merge[k][0]), _mm_shuffle_epi8(ch[1], merge[k][1])),
+                                     _mm_shuffle_epi8(ch[2], merge[k][2]));
+            _mm_storeu_si128(d + k, v);
+        }
+    }
+    mergeRowScalar(r + i, g + i, b + i, dst + 3 * i, n - i);
+}
+
+// round(v / 257) em 16 bits: x = v + 128 (saturado), (x - (x >> 8)) >> 8;
+// conferido para todos os 65536 valores contra (v * 255 + 32767) / 65535
+__attribute__((target("sse2"))) inline void narrowRowSSE(const uint16_t *src, uint8_t *dst, size_t n) {
+    const __m128i half = _mm_set1_epi16(128);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_adds_epu16(_mm_loadu_si128((const __m128i *)(src + i)), half);
+        __m128i b = _mm_adds_epu16(_mm_loadu_si128((const __m128i *)(src + i + 8)), half);
+        a = _mm_srli_epi16(_mm_sub_epi16(a, _mm_srli_epi16(a, 8)), 8);
+        b = _mm_srli_epi16(_mm_sub_epi16(b, _mm_srli_epi16(b, 8)), 8);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(a, b));
+    }
+    narrowRowScalar(src + i, dst + i, n - i);
+}
+
+// v * 257 é o byte repetido nas duas metades
+__attribute__((target("sse2"))) inline void widenRowSSE(const uint8_t *src, uint16_t *dst, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_unpacklo_epi8(v, v));
+        _mm_storeu_si128((__m128i *)(dst + i + 8), _mm_unpackhi_epi8(v, v));
+    }
+    widenRowScalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2"))) inline void toFloatRowAVX2(const uint8_t *src, float *dst, int n) {
+    const __m256 scale = _mm256_set1_ps(1.0f / 255.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(src + i)));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    toFloatRowScalar(src + i, dst + i, n - i);
+}
+
+// cvtps arredonda para o par mais próximo, como lrintf; o limite antes da
+// conversão evita o estouro de valores muito grandes
+__attribute__((target("avx2"))) inline void fromFloatRowAVX2(const float *src, uint8_t *dst, int n) {
+    const __m256 scale = _mm256_set1_ps(255.0f), zero = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256 fa = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i), scale), zero), scale);
+        __m256 fb = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale), zero), scale);
+        __m256i a = _mm256_cvtps_epi32(fa), b = _mm256_cvtps_epi32(fb);
+        __m256i w = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xd8);
+        __m128i lo = _mm256_castsi256_si128(w), hi = _mm256_extracti128_si256(w, 1);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    fromFloatRowScalar(src + i, dst + i, n - i);
+}
+
+// 4 pixels RGB (12 bytes) para RGBA com alfa 255, e o contrário
+__attribute__((target("ssse3"))) inline void addAlphaRowSSE(const uint8_t *src, uint8_t *dst, int n) {
+    const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+    int i = 0;
+    // cada carga lê 16 bytes: os 4 do fim têm que existir
+    for (; i + 6 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + 3 * i));
+        _mm_storeu_si128((__m128i *)(dst + 4 * i), _mm_or_si128(_mm_shuffle_epi8(v, spread), alpha));
+    }
+    for (; i < n; i++) {
+        dst[4 * i] = src[3 * i];
+        dst[4 * i + 1] = src[3 * i + 1];
+        dst[4 * i + 2] = src[3 * i + 2];
+        dst[4 * i + 3] = 255;
+    }
+}
+
+__attribute__((target("ssse3"))) inline void dropAlphaRowSSE(const uint8_t *src, uint8_t *dst, int n) {
+    const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    int i = 0;
+    // cada gravação escreve 16 bytes: os 4 do fim são sobrescritos depois
+    for (; i + 6 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + 4 * i));
+        _mm_storeu_si128((__m128i *)(dst + 3 * i), _mm_shuffle_epi8(v, pack));
+    }
+    for (; i < n; i++) {
+        dst[3 * i] = src[4 * i];
+        dst[3 * i + 1] = src[4 * i + 1];
+        dst[3 * i + 2] = src[4 * i + 2];
+    }
+}
+#endif /* IF_X86_SIMD */
+
+inline void splitRow(const uint8_t *src, uint8_t *r, uint8_t *g, uint8_t *b, int n) {
+#ifdef IF_X86_SIMD
+    if (g_simdLevel != SIMD_SCALAR && simdHasSSSE3()) return splitRowSSE(src, r, g, b, n);
+#endif
+    splitRowScalar(src, r, g, b, n);
+}
+
+inline void mergeRow(const uint8_t *r, const uint8_t *g, const uint8_t *b, uint8_t *dst, int n) {
+#ifdef IF_X86_SIMD
+    if (g_simdLevel != SIMD_SCALAR && simdHasSSSE3()) return mergeRowSSE(r, g, b, dst, n);
+#endif
+    mergeRowScalar(r, g, b, dst, n);
+}
+
+inline void narrowRow(const uint16_t *src, uint8_t *dst, size_t n) {
+#ifdef IF_X86_SIMD
+    if (g_simdLevel != SIMD_SCALAR) return narrowRowSSE(src, dst, n);
+#endif
+    narrowRowScalar(src, dst, n);
+}
+
+inline void widenRow(const uint8_t *src, uint16_t *dst, size_t n) {
+#ifdef IF_X86_SIMD
+    if (g_simdLevel != SIMD_SCALAR) return widenRowSSE(src, dst, n);
+#endif
+    widenRowScalar(src, dst, n);
+}
+
+inline void toFloatRow(const uint8_t *src, float *dst, int n) {
+#ifdef IF_X86_SIMD
+    if (g_simdLevel == SIMD_AVX2) return toFloatRowAVX2(src, dst, n);
+#endif
+    toFloatRowScalar(src, dst, n);
+}
+
+inline void fromFloatRow(const float *src, uint8_t *dst, int n) {
+#ifdef IF_X86_SIMD
+    if (g_simdLevel == SIMD_AVX2) return fromFloatRowAVX2(src, dst, n);
+#endif
+    fromFloatRowScalar(src, dst, n);
+}
+
+/*-----------------------------CONVERSÕES RÁPIDAS-----------------------------*/
+// Sobrecargas mais específicas que a genérica: o compilador escolhe pelos
+// tipos das vistas.
+
+inline void convertImage(const ImageView<RGB8, Interleaved> &src, const ImageView<RGB8, Planar> &dst) {
+    for (int y = 0; y < src.height; y++) {
+        splitRow(src.row(y), dst.row(y, 0), dst.row(y, 1), dst.row(y, 2), src.width);
+    }
+}
+
+inline void convertImage(const ImageView<RGB8, Planar> &src, const ImageView<RGB8, Interleaved> &dst) {
+    for (int y = 0; y < src.height; y++) {
+        mergeRow(src.row(y, 0), src.row(y, 1), src.row(y, 2), dst.row(y), src.width);
+    }
+}
+
+// separa em planos de 8 bits numa linha temporária e converte cada plano
+inline void convertImage(const ImageView<RGB8, Interleaved> &src, const ImageView<RGBF, Planar> &dst) {
+    vector<uint8_t> planes((size_t)src.width * 3);
+    uint8_t *p[3] = { planes.data(), planes.data() + src.width, planes.data() + 2 * src.width };
+    for (int y = 0; y < src.height; y++) {
+        splitRow(src.row(y), p[0], p[1], p[2], src.width);
+        for (int c = 0; c < 3; c++) toFloatRow(p[c], dst.row(y, c), src.width);
+    }
+}
+
+inline void convertImage(const ImageView<RGBF, Planar> &src, const ImageView<RGB8, Interleaved> &dst) {
+    vector<uint8_t> planes((size_t)src.width * 3);
+    uint8_t *p[3] = { planes.data(), planes.data() + src.width, planes.data() + 2 * src.width };
+    for (int y = 0; y < src.height; y++) {
+        for (int c = 0; c < 3; c++) fromFloatRow(src.row(y, c), p[c], src.width);
+        mergeRow(p[0], p[1], p[2], dst.row(y), src.width);
+    }
+}
+
+template <int C>
+inline void convertImage(const ImageView<PixelFormat<uint16_t, C>, Interleaved> &src,
+                         const ImageView<PixelFormat<uint8_t, C>, Interleaved> &dst) {
+    for (int y = 0; y < src.height; y++) narrowRow(src.row(y), dst.row(y), (size_t)src.width * C);
+}
+
+template <int C>
+inline void convertImage(const ImageView<PixelFormat<uint8_t, C>, Interleaved> &src,
+                         const ImageView<PixelFormat<uint16_t, C>, Interleaved> &dst) {
+    for (int y = 0; y < src.height; y++) widenRow(src.row(y), dst.row(y), (size_t)src.width * C);
+}
+
+inline void convertImage(const ImageView<RGB8, Interleaved> &src, const ImageView<RGBA8, Interleaved> &dst) {
+#ifdef IF_X86_SIMD
+    if (g_simdLevel != SIMD_SCALAR && simdHasSSSE3()) {
+        for (int y = 0; y < src.height; y++) addAlphaRowSSE(src.row(y), dst.row(y), src.width);
+        return;
+    }
+#endif
+    convertImage<RGB8, Interleaved, RGBA8, Interleaved>(src, dst);
+}
+
+inline void convertImage(const ImageView<RGBA8, Interleaved> &src, const ImageView<RGB8, Interleaved> &dst) {
+#ifdef IF_X86_SIMD
+    if (g_simdLevel != SIMD_SCALAR && simdHasSSSE3()) {
+        for (int y = 0; y < src.height; y++) dropAlphaRowSSE(src.row(y), dst.row(y), src.width);
+        return;
+    }
+#endif
+    convertImage<RGBA8, Interleaved, RGB8, Interleaved>(src, dst);
+}
+
+// conversão para uma imagem nova, do mesmo tamanho
+template <class FB, class LB, class FA, class LA>
+inline Image<FB, LB> convertImage(const ImageView<FA, LA> &src) {
+    Image<FB, LB> out(src.width, src.height);
+    convertImage(src, out.view());
+    return out;
+}
+
+/*------------------------------FILTROS TIPADOS-------------------------------*/
+// Um laço por formato, escolhido na compilação. Os formatos com alfa deixam
+// o alfa como está.
+
+template <class F>
+inline void negative(const ImageView<F, Interleaved> &img) {
+    const typename F::Sample mx = F::maxValue();
+    const int colors = F::channels == 2 || F::channels == 4 ? F::channels - 1 : F::channels;
+    for (int y = 0; y < img.height; y++) {
+        typename F::Sample *p = img.row(y);
+        for (int x = 0; x < img.width; x++, p += F::channels) {
+            for (int c = 0; c < colors; c++) p[c] = mx - p[c];
+        }
+    }
+}
+
+// plano a plano: laços simples que o compilador vetoriza
+template <class F>
+inline void negative(const ImageView<F, Planar> &img) {
+    const typename F::Sample mx = F::maxValue();
+    const int colors = F::channels == 2 || F::channels == 4 ? F::channels - 1 : F::channels;
+    for (int c = 0; c < colors; c++) {
+        for (int y = 0; y < img.height; y++) {
+            typename F::Sample *__restrict p = img.row(y, c);
+            for (int x = 0; x < img.width; x++) p[x] = mx - p[x];
+        }
+    }
+}
+
+inline void negative(const ImageView<RGB8, Interleaved> &img) {
+    for (int y = 0; y < img.height; y++) negativeRGB8(img.row(y), img.width);
+}
+
+// luminância de 3 amostras: ponto fixo de 16 bits nos inteiros (a mesma
+// conta de grayPixel em 8 bits), float nos float
+inline uint8_t lumaOf(uint8_t r, uint8_t g, uint8_t b, GrayWeights w) {
+    return grayPixel(r, g, b, w);
+}
+
+inline uint16_t lumaOf(uint16_t r, uint16_t g, uint16_t b, GrayWeights w) {
+    return (uint16_t)(((uint32_t)r * w.r + (uint32_t)g * w.g + (uint32_t)b * w.b + 32768) >> 16);
+}
+
+inline float lumaOf(float r, float g, float b, GrayWeights w) {
+    return (r * w.r + g * w.g + b * w.b) * (1.0f / 65536.0f);
+}
+
+template <class F>
+inline void grayScale(const ImageView<F, Interleaved> &img, bool weighted = true) {
+    static_assert(F::channels >= 3, "tons de cinza precisa de R, G e B");
+    GrayWeights w = grayWeights(weighted);
+    for (int y = 0; y < img.height; y++) {
+        typename F::Sample *p = img.row(y);
+        for (int x = 0; x < img.width; x++, p += F::channels) {
+            p[0] = p[1] = p[2] = lumaOf(p[0], p[1], p[2], w);
+        }
+    }
+}
+
+template <class F>
+inline void grayScale(const ImageView<F, Planar> &img, bool weighted = true) {
+    static_assert(F::channels >= 3, "tons de cinza precisa de R, G e B");
+    GrayWeights w = grayWeights(weighted);
+    for (int y = 0; y < img.height; y++) {
+        typename F::Sample *__restrict r = img.row(y, 0);
+        typename F::Sample *__restrict g = img.row(y, 1);
+        typename F::Sample *__restrict b = img.row(y, 2);
+        for (int x = 0; x < img.width; x++) r[x] = lumaOf(r[x], g[x], b[x], w);
+        memcpy(g, r, img.width * sizeof(r[0]));
+        memcpy(b, r, img.width * sizeof(r[0]));
+    }
+}
+
+inline void grayScale(const ImageView<RGB8, Interleaved> &img, bool weighted = true) {
+    for (int y = 0; y < img.height; y++) grayScaleRGB8(img.row(y), img.width, weighted);
+}
+
+/*------------------------------------PPM-------------------------------------*/
+// formato em que cada tipo de amostra é gravado: float vira 16 bits
+template <typename S>
+struct PPMSample {
+    typedef S Type;
+};
+
+template <>
+struct PPMSample<float> {
+    typedef uint16_t Type;
+};
+
+// reescala amostras de maxval qualquer para a faixa cheia do tipo
+template <typename S>
+inline void ppmStretch(S *data, size_t count, int maxval) {
+    uint32_t mx = SampleTraits<S>::maxValue();
+    if ((uint32_t)maxval == mx) return;
+    for (size_t i = 0; i < count; i++) data[i] = (S)((data[i] * mx + maxval / 2) / maxval);
+}
+
+// Converte uma imagem lida (qualquer PPM/PGM) para o formato da imagem; a
+// escolha do laço de conversão é feita uma vez, pelo formato do arquivo.
+// As amostras de 'p' são reescaladas no lugar.
+template <class F, class L>
+inline void ppmToImage(PPMImage &p, Image<F, L> &img) {
+    img.resize(p.width, p.height);
+    if (p.maxval > 255) {
+        ppmStretch(p.data16(), p.sampleCount(), p.maxval);
+        if (p.channels == 3) {
+            convertImage(ImageView<RGB16, Interleaved>(p.data16(), p.width, p.height), img.view());
+        } else {
+            convertImage(ImageView<Gray16, Interleaved>(p.data16(), p.width, p.height), img.view());
+        }
+    } else {
+        ppmStretch(p.data(), p.sampleCount(), p.maxval);
+        if (p.channels == 3) {
+            convertImage(ImageView<RGB8, Interleaved>(p.data(), p.width, p.height), img.view());
+        } else {
+            convertImage(ImageView<Gray8, Interleaved>(p.data(), p.width, p.height), img.view());
+        }
+    }
+}
+
+template <class F, class L>
+inline bool readImage(const string &file, Image<F, L> &img) {
+    PPMImage p;
+    if (!readPPM(file, p)) {
+        return false;
+    }
+    ppmToImage(p, img);
+    return true;
+}
+
+// Grava como PPM/PGM/PAM. Imagens de 8 ou 16 bits intercaladas vão direto
+// (com stride); as demais passam antes por uma cópia intercalada.
+template <class F>
+inline bool writeImage(const string &file, const ImageView<F, Interleaved> &img,
+                       const PPMWriteOptions &opt = PPMWriteOptions()) {
+    typedef typename F::Sample S;
+    typedef typename PPMSample<S>::Type T;
+    if (!is_same<S, T>::value) {
+        Image<PixelFormat<T, F::channels> > out = convertImage<PixelFormat<T, F::channels>, Interleaved>(img);
+        return writePPM(file, ppmView((const unsigned char *)out.data(), out.width(), out.height(), F::channels,
+                                      SampleTraits<T>::maxValue()), opt);
+    }
+    return writePPM(file, ppmView((const unsigned char *)img.data, img.width, img.height, F::channels,
+                                  SampleTraits<T>::maxValue(), img.stride * sizeof(S)), opt);
+}
+
+template <class F>
+inline bool writeImage(const string &file, const ImageView<F, Planar> &img,
+                       const PPMWriteOptions &opt = PPMWriteOptions()) {
+    typedef PixelFormat<typename PPMSample<typename F::Sample>::Type, F::channels> Out;
+    Image<Out> out = convertImage<Out, Interleaved>(img);
+    return writeImage(file, out.view(), opt);
+}
+
+template <class F, class L>
+inline bool writeImage(const string &file, const Image<F, L> &img, const PPMWriteOptions &opt = PPMWriteOptions()) {
+    return writeImage(file, img.view(), opt);
+}
+
+#endif /* Image_h */
@@ -0,0 +1,437 @@
+//
+//  ImageFilters.h
+//
+//  Filtros pontuais do exemplo_03 (tons de cinza, negativo, colorização e
+//  chroma-key) sobre RGB 8 bits intercalado, com versões AVX2 e SSE e uma
+//  versão escalar de referência.
+//
+//  - tons de cinza usa pesos em ponto fixo de 16 bits (sem double);
+//  - chroma-key compara a distância ao quadrado com a tolerância ao
+//    quadrado, em inteiros (sem sqrt);
+//  - negativo e colorização não precisam separar os canais: são XOR/OR
+//    com um padrão de 3 bytes repetido, então bastam instruções SSE2;
+//  - tons de cinza e chroma-key separam R, G e B de 16 pixels (48 bytes)
+//    com pshufb, que exige SSSE3. Sem SSSE3 eles usam a versão escalar.
+//
+//  A versão usada é escolhida em tempo de execução (g_simdLevel), e pode ser
+//  forçada para comparação.
+//
+
+#ifndef ImageFilters_h
+#define ImageFilters_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IF_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+enum SimdLevel { SIMD_SCALAR = 0, SIMD_SSE, SIMD_AVX2 };
+
+inline SimdLevel detectSimdLevel() {
+#ifdef IF_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+    return SIMD_SSE;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+inline SimdLevel g_simdLevel = detectSimdLevel();
+
+inline const char *simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SIMD_AVX2: return "AVX2";
+        case SIMD_SSE:  return "SSE";
+        default:        return "escalar";
+    }
+}
+
+// pesos de luminância em ponto fixo (x 65536)
+struct GrayWeights {
+    uint16_t r, g, b;
+};
+
+inline GrayWeights grayWeights(bool weighted) {
+    GrayWeights w;
+    if (weighted) {
+        w.r = 13926;    // 0.2125
+        w.g = 46884;    // 0.7154
+        w.b = 4725;     // 0.0721
+    } else {
+        w.r = w.g = w.b = 21845;    // 1/3
+    }
+    return w;
+}
+
+// Mesma conta das versões SIMD: cada termo é ((c << 8) * peso) >> 16, isto
+// é, c * peso em 8.8, e a soma é arredondada para inteiro.
+inline unsigned char grayPixel(unsigned r, unsigned g, unsigned b, GrayWeights w) {
+    unsigned sum = (((r << 8) * w.r) >> 16) + (((g << 8) * w.g) >> 16) + (((b << 8) * w.b) >> 16);
+    return (unsigned char)((sum + 128) >> 8);
+}
+
+// Tolerância t (0..1, relativa à maior distância possível no cubo RGB)
+// convertida em limite inteiro para a distância ao quadrado: d/dmax < t
+// equivale a d² < ceil((t*dmax)²).
+inline int32_t chromaThreshold2(double t) {
+    const double dmax2 = 3.0 * 255.0 * 255.0;
+    if (t <= 0) return 0;
+    double thr = ceil(t * t * dmax2);
+    return thr > dmax2 + 1 ? (int32_t)dmax2 + 1 : (int32_t)thr;
+}
+
+/*----------------------------------ESCALAR-----------------------------------*/
+inline void grayScaleScalar(unsigned char *data, size_t pixels, GrayWeights w) {
+    for (size_t i = 0; i < pixels * 3; i += 3) {
+        data[i] = data[i + 1] = data[i + 2] = grayPixel(data[i], data[i + 1], data[i + 2], w);
+    }
+}
+
+inline void negativeScalar(unsigned char *data, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        data[i] ^= 255;
+    }
+}
+
+inline void colorizeScalar(unsigned char *data, size_t pixels, unsigned char r, unsigned char g, unsigned char b) {
+    for (size_t i = 0; i < pixels * 3; i += 3) {
+        data[i] |= r;
+        data[i + 1] |= g;
+        data[i + 2] |= b;
+    }
+}
+
+inline void chromaKeyScalar(unsigned char *data, size_t pixels, int r, int g, int b, int32_t thr2) {
+    for (size_t i = 0; i < pixels * 3; i += 3) {
+        int dr = data[i] - r;
+        int dg = data[i + 1] - g;
+        int db = data[i + 2] - b;
+        if (dr * dr + dg * dg + db * db < thr2) {
+            data[i] = data[i + 1] = data[i + 2] = 0;
+        }
+    }
+}
+
+#ifdef IF_X86_SIMD
+/*-------------------------------------SSE------------------------------------*/
+// Máscaras de pshufb para separar os canais de 16 pixels RGB (48 bytes em
+// três registradores), para espalhar um valor por pixel de volta nos 3
+// bytes do pixel e para intercalar três canais separados de novo.
+struct RGBShuffleMasks {
+    alignas(16) unsigned char split[3][3][16];  // [canal][registrador de origem]
+    alignas(16) unsigned char spread[3][16];    // [registrador de destino]
+    alignas(16) unsigned char merge[3][3][16];  // [registrador de destino][canal]
+
+    RGBShuffleMasks() {
+        for (int c = 0; c < 3; c++) {
+            for (int k = 0; k < 3; k++) {
+                for (int p = 0; p < 16; p++) {
+                    int src = 3 * p + c;
+                    split[c][k][p] = (src / 16 == k) ? (unsigned char)(src % 16) : 0x80;
+                }
+            }
+        }
+        for (int k = 0; k < 3; k++) {
+            for (int j = 0; j < 16; j++) {
+                spread[k][j] = (unsigned char)((16 * k + j) / 3);
+            }
+        }
+        for (int k = 0; k < 3; k++) {
+            for (int c = 0; c < 3; c++) {
+                for (int j = 0; j < 16; j++) {
+                    int dst = 16 * k + j;
+                    merge[k][c][j] = (dst % 3 == c) ? (unsigned char)(dst / 3) : 0x80;
+                }
+            }
+        }
+    }
+};
+
+inline const RGBShuffleMasks &rgbShuffleMasks() {
+    static const RGBShuffleMasks masks;
+    return masks;
+}
+
+__attribute__((target("sse2"))) inline void negativeSSE(unsigned char *data, size_t bytes) {
+    const __m128i ones = _mm_set1_epi8((char)0xff);
+    size_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        _mm_storeu_si128((__m128i *)(data + i), _mm_xor_si128(v, ones));
+    }
+    negativeScalar(data + i, bytes - i);
+}
+
+__attribute__((target("sse2"))) inline void colorizeSSE(unsigned char *data, size_t pixels, unsigned char r, unsigned char g, unsigned char b) {
+    alignas(16) unsigned char pattern[48];
+    for (int j = 0; j < 48; j += 3) {
+        pattern[j] = r;
+        pattern[j + 1] = g;
+        pattern[j + 2] = b;
+    }
+    __m128i p0 = _mm_load_si128((const __m128i *)pattern);
+    __m128i p1 = _mm_load_si128((const __m128i *)(pattern + 16));
+    __m128i p2 = _mm_load_si128((const __m128i *)(pattern + 32));
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        __m128i *d = (__m128i *)(data + i * 3);
+        _mm_storeu_si128(d, _mm_or_si128(_mm_loadu_si128(d), p0));
+        _mm_storeu_si128(d + 1, _mm_or_si128(_mm_loadu_si128(d + 1), p1));
+        _mm_storeu_si128(d + 2, _mm_or_si128(_mm_loadu_si128(d + 2), p2));
+    }
+    colorizeScalar(data + i * 3, pixels - i, r, g, b);
+}
+
+// soma ((c << 8) * peso) >> 16 dos três canais para 8 pixels em 16 bits
+#define IF_GRAY_HALF(UNPACK, R, G, B)                                                    \
+    _mm_add_epi16(_mm_add_epi16(_mm_mulhi_epu16(UNPACK(zero, R), wr),                    \
+                                _mm_mulhi_epu16(UNPACK(zero, G), wg)),                   \
+                  _mm_mulhi_epu16(UNPACK(zero, B), wb))
+
+__attribute__((target("ssse3"))) inline void grayScaleSSE(unsigned char *data, size_t pixels, GrayWeights w) {
+    const RGBShuffleMasks &m = rgbShuffleMasks();
+    __m128i split[3][3], spread[3];
+    for (int c = 0; c < 3; c++) {
+        for (int k = 0; k < 3; k++) split[c][k] = _mm_load_si128((const __m128i *)m.split[c][k]);
+        spread[c] = _mm_load_si128((const __m128i *)m.spread[c]);
+    }
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i wr = _mm_set1_epi16((short)w.r);
+    const __m128i wg = _mm_set1_epi16((short)w.g);
+    const __m128i wb = _mm_set1_epi16((short)w.b);
+    const __m128i half = _mm_set1_epi16(128);
+
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        __m128i *d = (__m128i *)(data + i * 3);
+        __m128i v0 = _mm_loadu_si128(d), v1 = _mm_loadu_si128(d + 1), v2 = _mm_loadu_si128(d + 2);
+        __m128i ch[3];
+        for (int k = 0; k < 3; k++) {
+            ch[k] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, split[k][0]), _mm_shuffle_epi8(v1, split[k][1])),
+                                 _mm_shuffle_epi8(v2, split[k][2]));
+        }
+        __m128i lo = IF_GRAY_HALF(_mm_unpacklo_epi8, ch[0], ch[1], ch[2]);
+        __m128i hi = IF_GRAY_HALF(_mm_unpackhi_epi8, ch[0], ch[1], ch[2]);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, half), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, half), 8);
+        __m128i gray = _mm_packus_epi16(lo, hi);
+        _mm_storeu_si128(d, _mm_shuffle_epi8(gray, spread[0]));
+        _mm_storeu_si128(d + 1, _mm_shuffle_epi8(gray, spread[1]));
+        _mm_storeu_si128(d + 2, _mm_shuffle_epi8(gray, spread[2]));
+    }
+    grayScaleScalar(data + i * 3, pixels - i, w);
+}
+
+// d² = dr² + dg² + db² de 4 pixels em 32 bits, com dr, dg e db em 16 bits
+#define IF_DIST2_QUARTER(UNPACK, DR, DG, DB)                                             \
+    _mm_add_epi32(_mm_madd_epi16(UNPACK(DR, DG), UNPACK(DR, DG)),                        \
+                  _mm_madd_epi16(UNPACK(DB, zero), UNPACK(DB, zero)))
+
+__attribute__((target("ssse3"))) inline void chromaKeySSE(unsigned char *data, size_t pixels, int r, int g, int b, int32_t thr2) {
+    const RGBShuffleMasks &m = rgbShuffleMasks();
+    __m128i split[3][3], spread[3];
+    for (int c = 0; c < 3; c++) {
+        for (int k = 0; k < 3; k++) split[c][k] = _mm_load_si128((const __m128i *)m.split[c][k]);
+        spread[c] = _mm_load_si128((const __m128i *)m.spread[c]);
+    }
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i key[3] = {_mm_set1_epi16((short)r), _mm_set1_epi16((short)g), _mm_set1_epi16((short)b)};
+    const __m128i thr = _mm_set1_epi32(thr2);
+
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        __m128i *d = (__m128i *)(data + i * 3);
+        __m128i v0 = _mm_loadu_si128(d), v1 = _mm_loadu_si128(d + 1), v2 = _mm_loadu_si128(d + 2);
+        __m128i dlo[3], dhi[3];
+        for (int k = 0; k < 3; k++) {
+            __m128i ch = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, split[k][0]), _mm_shuffle_epi8(v1, split[k][1])),
+                                      _mm_shuffle_epi8(v2, split[k][2]));
+            dlo[k] = _mm_sub_epi16(_mm_unpacklo_epi8(ch, zero), key[k]);
+            dhi[k] = _mm_sub_epi16(_mm_unpackhi_epi8(ch, zero), key[k]);
+        }
+        __m128i k0 = _mm_cmpgt_epi32(thr, IF_DIST2_QUARTER(_mm_unpacklo_epi16, dlo[0], dlo[1], dlo[2]));
+        __m128i k1 = _mm_cmpgt_epi32(thr, IF_DIST2_QUARTER(_mm_unpackhi_epi16, dlo[0], dlo[1], dlo[2]));
+        __m128i k2 = _mm_cmpgt_epi32(thr, IF_DIST2_QUARTER(_mm_unpacklo_epi16, dhi[0], dhi[1], dhi[2]));
+        __m128i k3 = _mm_cmpgt_epi32(thr, IF_DIST2_QUARTER(_mm_unpackhi_epi16, dhi[0], dhi[1], dhi[2]));
+        __m128i keyed = _mm_packs_epi16(_mm_packs_epi32(k0, k1), _mm_packs_epi32(k2, k3));
+        _mm_storeu_si128(d, _mm_andnot_si128(_mm_shuffle_epi8(keyed, spread[0]), v0));
+        _mm_storeu_si128(d + 1, _mm_andnot_si128(_mm_shuffle_epi8(keyed, spread[1]), v1));
+        _mm_storeu_si128(d + 2, _mm_andnot_si128(_mm_shuffle_epi8(keyed, spread[2]), v2));
+    }
+    chromaKeyScalar(data + i * 3, pixels - i, r, g, b, thr2);
+}
+
+/*------------------------------------AVX2------------------------------------*/
+// As versões AVX2 tratam dois blocos de 16 pixels de uma vez, um em cada
+// metade de 128 bits (pshufb não cruza as metades).
+__attribute__((target("avx2"))) inline __m256i loadTwoBlocks(const unsigned char *p, int k) {
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)p + k)),
+                                   _mm_loadu_si128((const __m128i *)(p + 48) + k), 1);
+}
+
+__attribute__((target("avx2"))) inline void storeTwoBlocks(unsigned char *p, int k, __m256i v) {
+    _mm_storeu_si128((__m128i *)p + k, _mm256_castsi256_si128(v));
+    _mm_storeu_si128((__m128i *)(p + 48) + k, _mm256_extracti128_si256(v, 1));
+}
+
+__attribute__((target("avx2"))) inline void negativeAVX2(unsigned char *data, size_t bytes) {
+    const __m256i ones = _mm256_set1_epi8((char)0xff);
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+        _mm256_storeu_si256((__m256i *)(data + i), _mm256_xor_si256(v, ones));
+    }
+    negativeSSE(data + i, bytes - i);
+}
+
+__attribute__((target("avx2"))) inline void colorizeAVX2(unsigned char *data, size_t pixels, unsigned char r, unsigned char g, unsigned char b) {
+    alignas(32) unsigned char pattern[96];
+    for (int j = 0; j < 96; j += 3) {
+        pattern[j] = r;
+        pattern[j + 1] = g;
+        pattern[j + 2] = b;
+    }
+    __m256i p0 = _mm256_load_si256((const __m256i *)pattern);
+    __m256i p1 = _mm256_load_si256((const __m256i *)(pattern + 32));
+    __m256i p2 = _mm256_load_si256((const __m256i *)(pattern + 64));
+    size_t i = 0;
+    for (; i + 32 <= pixels; i += 32) {
+        __m256i *d = (__m256i *)(data + i * 3);
+        _mm256_storeu_si256(d, _mm256_or_si256(_mm256_loadu_si256(d), p0));
+        _mm256_storeu_si256(d + 1, _mm256_or_si256(_mm256_loadu_si256(d + 1), p1));
+        _mm256_storeu_si256(d + 2, _mm256_or_si256(_mm256_loadu_si256(d + 2), p2));
+    }
+    colorizeSSE(data + i * 3, pixels - i, r, g, b);
+}
+
+#define IF_GRAY_HALF_256(UNPACK, R, G, B)                                                \
+    _mm256_add_epi16(_mm256_add_epi16(_mm256_mulhi_epu16(UNPACK(zero, R), wr),           \
+                                      _mm256_mulhi_epu16(UNPACK(zero, G), wg)),          \
+                     _mm256_mulhi_epu16(UNPACK(zero, B), wb))
+
+__attribute__((target("avx2"))) inline void grayScaleAVX2(unsigned char *data, size_t pixels, GrayWeights w) {
+    const RGBShuffleMasks &m = rgbShuffleMasks();
+    __m256i split[3][3], spread[3];
+    for (int c = 0; c < 3; c++) {
+        for (int k = 0; k < 3; k++) split[c][k] = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)m.split[c][k]));
+        spread[c] = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)m.spread[c]));
+    }
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i wr = _mm256_set1_epi16((short)w.r);
+    const __m256i wg = _mm256_set1_epi16((short)w.g);
+    const __m256i wb = _mm256_set1_epi16((short)w.b);
+    const __m256i half = _mm256_set1_epi16(128);
+
+    size_t i = 0;
+    for (; i + 32 <= pixels; i += 32) {
+        unsigned char *d = data + i * 3;
+        __m256i v0 = loadTwoBlocks(d, 0), v1 = loadTwoBlocks(d, 1), v2 = loadTwoBlocks(d, 2);
+        __m256i ch[3];
+        for (int k = 0; k < 3; k++) {
+            ch[k] = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(v0, split[k][0]), _mm256_shuffle_epi8(v1, split[k][1])),
+                                    _mm256_shuffle_epi8(v2, split[k][2]));
+        }
+        __m256i lo = IF_GRAY_HALF_256(_mm256_unpacklo_epi8, ch[0], ch[1], ch[2]);
+        __m256i hi = IF_GRAY_HALF_256(_mm256_unpackhi_epi8, ch[0], ch[1], ch[2]);
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, half), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, half), 8);
+        __m256i gray = _mm256_packus_epi16(lo, hi);
+        storeTwoBlocks(d, 0, _mm256_shuffle_epi8(gray, spread[0]));
+        storeTwoBlocks(d, 1, _mm256_shuffle_epi8(gray, spread[1]));
+        storeTwoBlocks(d, 2, _mm256_shuffle_epi8(gray, spread[2]));
+    }
+    grayScaleSSE(data + i * 3, pixels - i, w);
+}
+
+#define IF_DIST2_QUARTER_256(UNPACK, DR, DG, DB)                                         \
+    _mm256_add_epi32(_mm256_madd_epi16(UNPACK(DR, DG), UNPACK(DR, DG)),                  \
+                     _mm256_madd_epi16(UNPACK(DB, zero), UNPACK(DB, zero)))
+
+__attribute__((target("avx2"))) inline void chromaKeyAVX2(unsigned char *data, size_t pixels, int r, int g, int b, int32_t thr2) {
+    const RGBShuffleMasks &m = rgbShuffleMasks();
+    __m256i split[3][3], spread[3];
+    for (int c = 0; c < 3; c++) {
+        for (int k = 0; k < 3; k++) split[c][k] = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)m.split[c][k]));
+        spread[c] = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)m.spread[c]));
+    }
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i key[3] = {_mm256_set1_epi16((short)r), _mm256_set1_epi16((short)g), _mm256_set1_epi16((short)b)};
+    const __m256i thr = _mm256_set1_epi32(thr2);
+
+    size_t i = 0;
+    for (; i + 32 <= pixels; i += 32) {
+        unsigned char *d = data + i * 3;
+        __m256i v0 = loadTwoBlocks(d, 0), v1 = loadTwoBlocks(d, 1), v2 = loadTwoBlocks(d, 2);
+        __m256i dlo[3], dhi[3];
+        for (int k = 0; k < 3; k++) {
+            __m256i ch = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(v0, split[k][0]), _mm256_shuffle_epi8(v1, split[k][1])),
+                                         _mm256_shuffle_epi8(v2, split[k][2]));
+            dlo[k] = _mm256_sub_epi16(_mm256_unpacklo_epi8(ch, zero), key[k]);
+            dhi[k] = _mm256_sub_epi16(_mm256_unpackhi_epi8(ch, zero), key[k]);
+        }
+        // unpack/pack operam por metade, então a ordem dos pixels se mantém
+        __m256i k0 = _mm256_cmpgt_epi32(thr, IF_DIST2_QUARTER_256(_mm256_unpacklo_epi16, dlo[0], dlo[1], dlo[2]));
+        __m256i k1 = _mm256_cmpgt_epi32(thr, IF_DIST2_QUARTER_256(_mm256_unpackhi_epi16, dlo[0], dlo[1], dlo[2]));
+        __m256i k2 = _mm256_cmpgt_epi32(thr, IF_DIST2_QUARTER_256(_mm256_unpacklo_epi16, dhi[0], dhi[1], dhi[2]));
+        __m256i k3 = _mm256_cmpgt_epi32(thr, IF_DIST2_QUARTER_256(_mm256_unpackhi_epi16, dhi[0], dhi[1], dhi[2]));
+        __m256i keyed = _mm256_packs_epi16(_mm256_packs_epi32(k0, k1), _mm256_packs_epi32(k2, k3));
+        storeTwoBlocks(d, 0, _mm256_andnot_si256(_mm256_shuffle_epi8(keyed, spread[0]), v0));
+        storeTwoBlocks(d, 1, _mm256_andnot_si256(_mm256_shuffle_epi8(keyed, spread[1]), v1));
+        storeTwoBlocks(d, 2, _mm256_andnot_si256(_mm256_shuffle_epi8(keyed, spread[2]), v2));
+    }
+    chromaKeySSE(data + i * 3, pixels - i, r, g, b, thr2);
+}
+#endif /* IF_X86_SIMD */
+
+/*-------------------------------ENTRADAS PÚBLICAS----------------------------*/
+inline bool simdHasSSSE3() {
+#ifdef IF_X86_SIMD
+    return __builtin_cpu_supports("ssse3");
+#else
+    return false;
+#endif
+}
+
+// média ponderada (luminância) ou aritmética
+inline void grayScaleRGB8(unsigned char *data, size_t pixels, bool weighted) {
+    GrayWeights w = grayWeights(weighted);
+#ifdef IF_X86_SIMD
+    if (g_simdLevel == SIMD_AVX2) return grayScaleAVX2(data, pixels, w);
+    if (g_simdLevel == SIMD_SSE && simdHasSSSE3()) return grayScaleSSE(data, pixels, w);
+#endif
+    grayScaleScalar(data, pixels, w);
+}
+
+inline void negativeRGB8(unsigned char *data, size_t pixels) {
+#ifdef IF_X86_SIMD
+    if (g_simdLevel == SIMD_AVX2) return negativeAVX2(data, pixels * 3);
+    if (g_simdLevel == SIMD_SSE) return negativeSSE(data, pixels * 3);
+#endif
+    negativeScalar(data, pixels * 3);
+}
+
+inline void colorizeRGB8(unsigned char *data, size_t pixels, int r, int g, int b) {
+#ifdef IF_X86_SIMD
+    if (g_simdLevel == SIMD_AVX2) return colorizeAVX2(data, pixels, r, g, b);
+    if (g_simdLevel == SIMD_SSE) return colorizeSSE(data, pixels, r, g, b);
+#endif
+    colorizeScalar(data, pixels, r, g, b);
+}
+
+// pixels a menos de t (0..1) da cor-chave viram preto
+inline void chromaKeyRGB8(unsigned char *data, size_t pixels, int r, int g, int b, double t) {
+    int32_t thr2 = chromaThreshold2(t);
+#ifdef IF_X86_SIMD
+    if (g_simdLevel == SIMD_AVX2) return chromaKeyAVX2(data, pixels, r, g, b, thr2);
+    if (g_simdLevel == SIMD_SSE && simdHasSSSE3()) return chromaKeySSE(data, pixels, r, g, b, thr2);
+#endif
+    chromaKeyScalar(data, pixels, r, g, b, thr2);
+}
+
+#endif /* ImageFilters_h */
@@ -0,0 +1,610 @@
+//
+//  PPM.h
+//
+//  Leitura e escrita de imagens Netpbm: PPM (P3 texto, P6 binário) e PGM
+//  (P2 texto, P5 binário), com comentários no cabeçalho e maxval até 65535.
+//
+//  O arquivo inteiro é mapeado em memória (mmap). Nos formatos binários de
+//  8 bits os pixels apontam direto para o mapeamento (MAP_PRIVATE: escrever
+//  neles não altera o arquivo), sem nenhuma cópia. Os formatos texto são
+//  convertidos com std::from_chars em uma única varredura do buffer.
+//
+//  A escrita acumula a saída em um buffer grande e, no caso binário de
+//  8 bits, manda as linhas direto da imagem de origem com writev, mesmo
+//  quando elas não são contíguas (PPMRowView com stride). Imagens com alfa
+//  (2 ou 4 canais) são gravadas como PAM (P7), sempre binário.
+//
+
+#ifndef PPM_h
+#define PPM_h
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <charconv>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <errno.h>
+#endif
+
+using namespace std;
+
+class PPMImage {
+    unsigned char *pixels;
+    vector<unsigned char> owned;
+    void *mapping;
+    size_t mappingLength;
+
+public:
+    int width, height;
+    int channels;   // 3 para PPM (P3/P6), 1 para PGM (P2/P5)
+    int maxval;     // até 255: 1 byte por amostra; acima: uint16_t na ordem da máquina
+
+    PPMImage() : pixels(NULL), mapping(NULL), mappingLength(0), width(0), height(0), channels(0), maxval(0) {}
+
+    ~PPMImage() {
+        release();
+    }
+
+    PPMImage(const PPMImage &) = delete;
+    PPMImage &operator=(const PPMImage &) = delete;
+
+    PPMImage(PPMImage &&other) : PPMImage() {
+        *this = std::move(other);
+    }
+
+    PPMImage &operator=(PPMImage &&other) {
+        if (this != &other) {
+            release();
+            bool ownedPixels = other.pixels != NULL && other.mapping == NULL;
+            owned.swap(other.owned);
+            pixels = ownedPixels ? owned.data() : other.pixels;
+            mapping = other.mapping;
+            mappingLength = other.mappingLength;
+            width = other.width;
+            height = other.height;
+            channels = other.channels;
+            maxval = other.maxval;
+            other.pixels = NULL;
+            other.mapping = NULL;
+            other.release();
+        }
+        return *this;
+    }
+
+    int bytesPerSample() const {
+        return maxval > 255 ? 2 : 1;
+    }
+
+    size_t sampleCount() const {
+        return (size_t)width * height * channels;
+    }
+
+    size_t rowBytes() const {
+        return (size_t)width * channels * bytesPerSample();
+    }
+
+    unsigned char *data() {
+        return pixels;
+    }
+
+    const unsigned char *data() const {
+        return pixels;
+    }
+
+    uint16_t *data16() {
+        return (uint16_t *)pixels;
+    }
+
+    const uint16_t *data16() const {
+        return (const uint16_t *)pixels;
+    }
+
+    bool isMapped() const {
+        return mapping != NULL;
+    }
+
+    // buffer próprio, não inicializado
+    void allocate(int w, int h, int c, int mv) {
+        release();
+        width = w;
+        height = h;
+        channels = c;
+        maxval = mv;
+        owned.resize(sampleCount() * bytesPerSample());
+        pixels = owned.data();
+    }
+
+    // passa a usar pixels dentro de um arquivo mapeado; a imagem libera o
+    // mapeamento quando for destruída
+    void adoptMapping(void *map, size_t length, size_t offset) {
+        mapping = map;
+        mappingLength = length;
+        pixels = (unsigned char *)map + offset;
+    }
+
+    void release() {
+#ifndef _WIN32
+        if (mapping) munmap(mapping, mappingLength);
+#endif
+        mapping = NULL;
+        mappingLength = 0;
+        pixels = NULL;
+        vector<unsigned char>().swap(owned);
+        width = height = channels = maxval = 0;
+    }
+};
+
+// Conteúdo bruto de um arquivo: mapeado quando possível, senão lido.
+struct PPMFileBuffer {
+    const char *begin;
+    const char *end;
+    void *map;
+    size_t mapLength;
+    vector<char> storage;
+
+    PPMFileBuffer() : begin(NULL), end(NULL), map(NULL), mapLength(0) {}
+
+    ~PPMFileBuffer() {
+#ifndef _WIN32
+        if (map) munmap(map, mapLength);
+#endif
+    }
+
+    bool load(const string &file) {
+#ifndef _WIN32
+        int fd = ::open(file.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *m = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (m != MAP_FAILED) {
+                madvise(m, st.st_size, MADV_SEQUENTIAL);
+                map = m;
+                mapLength = st.st_size;
+                begin = (const char *)m;
+                end = begin + mapLength;
+                ::close(fd);
+                return true;
+            }
+        }
+        ::close(fd);
+#endif
+        FILE *f = fopen(file.c_str(), "rb");
+        if (!f) return false;
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        storage.resize(size > 0 ? size : 0);
+        size_t got = fread(storage.data(), 1, storage.size(), f);
+        fclose(f);
+        begin = storage.data();
+        end = begin + got;
+        return true;
+    }
+
+    // entrega o mapeamento para outro dono (ver PPMImage::adoptMapping)
+    void *detach() {
+        void *m = map;
+        map = NULL;
+        return m;
+    }
+};
+
+// pula espaços em branco e comentários (# até o fim da linha)
+inline const char *ppmSkipSpace(const char *p, const char *end) {
+    while (p < end) {
+        if (*p == '#') {
+            while (p < end && *p != '\n') p++;
+        } else if ((unsigned char)*p <= ' ') {
+            p++;
+        } else {
+            break;
+        }
+    }
+    return p;
+}
+
+inline bool ppmNextInt(const char *&p, const char *end, int &value) {
+    p = ppmSkipSpace(p, end);
+    from_chars_result r = from_chars(p, end, value);
+    if (r.ec != errc() || r.ptr == p) return false;
+    p = r.ptr;
+    return true;
+}
+
+// Converte as amostras em texto de P2/P3. Valores fora de [0, maxval] ou
+// em número insuficiente são erro; o que sobrar no fim do arquivo é ignorado.
+template <typename T>
+inline bool ppmParseText(const char *p, const char *end, T *out, size_t count, int maxval) {
+    for (size_t i = 0; i < count; i++) {
+        int v;
+        if (!ppmNextInt(p, end, v) || v < 0 || v > maxval) return false;
+        out[i] = (T)v;
+    }
+    return true;
+}
+
+// Cabeçalho de um arquivo Netpbm; 'type' é o dígito do formato ('2', '3',
+// '5' ou '6').
+struct PPMHeader {
+    char type;
+    int width, height;
+    int channels;
+    int maxval;
+};
+
+// Lê o cabeçalho a partir de 'p' e deixa 'p' no primeiro byte dos pixels.
+// Em caso de erro escreve a mensagem em cerr (a não ser com 'quiet') e
+// retorna falso; se o erro foi o fim de [p, end), 'p' fica em 'end'.
+inline bool ppmParseHeader(const string &file, const char *&p, const char *end, PPMHeader &hdr, bool quiet = false) {
+    if (end - p < 2 || p[0] != 'P' || (p[1] != '2' && p[1] != '3' && p[1] != '5' && p[1] != '6')) {
+        if (end - p < 2) p = end;
+        if (!quiet) cerr << file << ": formato não suportado (esperado P2, P3, P5 ou P6)" << endl;
+        return false;
+    }
+    hdr.type = p[1];
+    p += 2;
+
+    if (!ppmNextInt(p, end, hdr.width) || !ppmNextInt(p, end, hdr.height) || !ppmNextInt(p, end, hdr.maxval) ||
+        hdr.width <= 0 || hdr.height <= 0 || hdr.maxval <= 0 || hdr.maxval > 65535) {
+        if (!quiet) cerr << file << ": cabeçalho inválido" << endl;
+        return false;
+    }
+    // exatamente um espaço separa o cabeçalho dos dados
+    if (p >= end || (unsigned char)*p > ' ') {
+        if (!quiet) cerr << file << ": cabeçalho inválido" << endl;
+        return false;
+    }
+    p++;
+    hdr.channels = (hdr.type == '3' || hdr.type == '6') ? 3 : 1;
+    return true;
+}
+
+inline bool readPPM(const string &file, PPMImage &img) {
+    PPMFileBuffer buf;
+    if (!buf.load(file)) {
+        cerr << "Erro ao abrir " << file << endl;
+        return false;
+    }
+
+    const char *p = buf.begin;
+    const char *end = buf.end;
+    PPMHeader hdr;
+    if (!ppmParseHeader(file, p, end, hdr)) {
+        return false;
+    }
+    char type = hdr.type;
+    int w = hdr.width;
+    int h = hdr.height;
+    int maxval = hdr.maxval;
+
+    int channels = hdr.channels;
+    size_t count = (size_t)w * h * channels;
+
+    if (type == '2' || type == '3') {
+        img.allocate(w, h, channels, maxval);
+        bool ok = maxval > 255 ? ppmParseText(p, end, img.data16(), count, maxval)
+                               : ppmParseText(p, end, img.data(), count, maxval);
+        if (!ok) {
+            cerr << file << ": dados de pixel inválidos ou incompletos" << endl;
+            img.release();
+            return false;
+        }
+        return true;
+    }
+
+    size_t bytes = count * (maxval > 255 ? 2 : 1);
+    if ((size_t)(end - p) < bytes) {
+        cerr << file << ": arquivo truncado" << endl;
+        return false;
+    }
+    if (maxval <= 255 && buf.map) {
+        size_t offset = p - buf.begin;
+        size_t length = buf.mapLength;
+        img.release();
+        img.width = w;
+        img.height = h;
+        img.channels = channels;
+        img.maxval = maxval;
+        img.adoptMapping(buf.detach(), length, offset);
+        return true;
+    }
+
+    img.allocate(w, h, channels, maxval);
+    if (maxval <= 255) {
+        memcpy(img.data(), p, bytes);
+    } else {
+        // 16 bits no arquivo são big-endian
+        const unsigned char *s = (const unsigned char *)p;
+        uint16_t *d = img.data16();
+        for (size_t i = 0; i < count; i++) {
+            d[i] = (uint16_t)((s[2 * i] << 8) | s[2 * i + 1]);
+        }
+    }
+    return true;
+}
+
+// Converte qualquer imagem lida para RGB 8 bits intercalado (o formato que
+// os filtros do exemplo_03 esperam): cinza vira R=G=B e maxval é
+// reescalado para 255. Não faz nada se a imagem já estiver nesse formato.
+inline void ppmToRGB8(PPMImage &img) {
+    if (img.channels == 3 && img.maxval == 255) return;
+
+    PPMImage rgb;
+    rgb.allocate(img.width, img.height, 3, 255);
+    size_t n = (size_t)img.width * img.height;
+    unsigned char *d = rgb.data();
+    int mv = img.maxval;
+    for (size_t i = 0; i < n; i++) {
+        for (int c = 0; c < 3; c++) {
+            size_t s = i * img.channels + (img.channels == 3 ? c : 0);
+            unsigned v = img.maxval > 255 ? img.data16()[s] : img.data()[s];
+            d[i * 3 + c] = (unsigned char)((v * 255 + mv / 2) / mv);
+        }
+    }
+    img = std::move(rgb);
+}
+
+// Vista somente leitura de uma imagem: 'stride' é a distância em bytes entre
+// o início de duas linhas consecutivas, permitindo gravar recortes ou
+// buffers com preenchimento sem montar uma cópia compacta.
+struct PPMRowView {
+    const unsigned char *data;
+    int width, height;
+    int channels;
+    int maxval;         // acima de 255 as amostras são uint16_t na ordem da máquina
+    size_t stride;
+};
+
+inline PPMRowView ppmView(const unsigned char *data, int w, int h, int channels = 3, int maxval = 255, size_t stride = 0) {
+    PPMRowView v;
+    v.data = data;
+    v.width = w;
+    v.height = h;
+    v.channels = channels;
+    v.maxval = maxval;
+    v.stride = stride ? stride : (size_t)w * channels * (maxval > 255 ? 2 : 1);
+    return v;
+}
+
+inline PPMRowView ppmView(const PPMImage &img) {
+    return ppmView(img.data(), img.width, img.height, img.channels, img.maxval, img.rowBytes());
+}
+
+struct PPMWriteOptions {
+    bool binary;            // P6/P5; falso grava P3/P2
+    bool sync;              // fsync antes de fechar
+    const char *comment;    // linha de comentário opcional no cabeçalho
+    size_t bufferSize;
+
+    PPMWriteOptions() : binary(true), sync(false), comment(NULL), bufferSize(1 << 20) {}
+};
+
+// Saída com buffer próprio sobre o descritor de arquivo.
+class PPMOutput {
+    vector<char> buffer;
+    size_t used;
+#ifndef _WIN32
+    int fd;
+#else
+    FILE *fp;
+#endif
+
+    bool writeAll(const char *p, size_t n) {
+        while (n > 0) {
+#ifndef _WIN32
+            ssize_t r = ::write(fd, p, n);
+            if (r < 0 && errno == EINTR) continue;     // sinal antes de gravar algo
+            if (r < 0) return false;
+#else
+            size_t r = fwrite(p, 1, n, fp);
+            if (r == 0) return false;
+#endif
+            p += r;
+            n -= r;
+        }
+        return true;
+    }
+
+public:
+    bool ok;
+
+    PPMOutput(size_t bufferSize) : buffer(bufferSize), used(0), ok(false) {
+#ifndef _WIN32
+        fd = -1;
+#else
+        fp = NULL;
+#endif
+    }
+
+    ~PPMOutput() {
+#ifndef _WIN32
+        if (fd >= 0) ::close(fd);
+#else
+        if (fp) fclose(fp);
+#endif
+    }
+
+    bool open(const string &file) {
+#ifndef _WIN32
+        fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        ok = fd >= 0;
+#else
+        fp = fopen(file.c_str(), "wb");
+        ok = fp != NULL;
+#endif
+        return ok;
+    }
+
+    // espaço livre no buffer para escrever no mínimo 'n' bytes
+    char *reserve(size_t n) {
+        if (buffer.size() - used < n) flush();
+        if (buffer.size() < n) buffer.resize(n);
+        return buffer.data() + used;
+    }
+
+    void commit(size_t n) {
+        used += n;
+    }
+
+    void put(const char *p, size_t n) {
+        memcpy(reserve(n), p, n);
+        commit(n);
+    }
+
+    void flush() {
+        if (used > 0 && ok) ok = writeAll(buffer.data(), used);
+        used = 0;
+    }
+
+    // 'rows' linhas de 'rowBytes' bytes separadas por 'stride', sem cópia
+    void putRows(const unsigned char *data, size_t rowBytes, size_t stride, int rows) {
+        flush();
+        if (!ok) return;
+        if (stride == rowBytes) {
+            ok = writeAll((const char *)data, rowBytes * rows);
+            return;
+        }
+#ifndef _WIN32
+        const int batch = IOV_MAX < 1024 ? IOV_MAX : 1024;
+        vector<struct iovec> iov(batch);
+        for (int r0 = 0; r0 < rows && ok; r0 += batch) {
+            int n = rows - r0 < batch ? rows - r0 : batch;
+            for (int i = 0; i < n; i++) {
+                iov[i].iov_base = (void *)(data + (size_t)(r0 + i) * stride);
+                iov[i].iov_len = rowBytes;
+            }
+            size_t total = rowBytes * n;
+            ssize_t r;
+            do {
+                r = writev(fd, iov.data(), n);
+            } while (r < 0 && errno == EINTR);
+            if (r < 0) {
+                ok = false;
+            } else if ((size_t)r < total) {
+                // escrita parcial: completa linha a linha a partir de onde parou
+                size_t done = r;
+                for (int i = 0; i < n && ok; i++) {
+                    if (done >= rowBytes) {
+                        done -= rowBytes;
+                        continue;
+                    }
+                    ok = writeAll((const char *)iov[i].iov_base + done, rowBytes - done);
+                    done = 0;
+                }
+            }
+        }
+#else
+        for (int r = 0; r < rows && ok; r++) {
+            ok = writeAll((const char *)data + (size_t)r * stride, rowBytes);
+        }
+#endif
+    }
+
+    bool close(bool sync) {
+        flush();
+#ifndef _WIN32
+        if (ok && sync) ok = fsync(fd) == 0;
+        if (fd >= 0 && ::close(fd) != 0) ok = false;
+        fd = -1;
+#else
+        if (ok && sync) ok = fflush(fp) == 0;
+        if (fp && fclose(fp) != 0) ok = false;
+        fp = NULL;
+#endif
+        return ok;
+    }
+};
+
+// Monta o cabeçalho em 'buf' e retorna seu tamanho (truncado em size - 1).
+// Para magic '7' (PAM), 'channels' define DEPTH e TUPLTYPE.
+inline size_t ppmFormatHeader(char *buf, size_t size, char magic, int w, int h, int channels, int maxval,
+                              const char *comment) {
+    int len;
+    if (magic == '7') {
+        len = snprintf(buf, size, "P7\n%s%s%sWIDTH %d\nHEIGHT %d\nDEPTH %d\nMAXVAL %d\nTUPLTYPE %s\nENDHDR\n",
+                       comment ? "# " : "", comment ? comment : "", comment ? "\n" : "", w, h, channels, maxval,
+                       channels == 4 ? "RGB_ALPHA" : (channels == 2 ? "GRAYSCALE_ALPHA" : (channels == 3 ? "RGB" : "GRAYSCALE")));
+    } else {
+        len = snprintf(buf, size, "P%c\n%s%s%s%d %d\n%d\n", magic,
+                       comment ? "# " : "", comment ? comment : "", comment ? "\n" : "", w, h, maxval);
+    }
+    return len < (int)size ? len : size - 1;
+}
+
+// Grava reaproveitando 'out' (e o seu buffer) de um arquivo para o outro;
+// opt.bufferSize só vale na criação de 'out'.
+inline bool writePPM(PPMOutput &out, const string &file, const PPMRowView &img,
+                     const PPMWriteOptions &opt = PPMWriteOptions()) {
+    if (!out.open(file)) {
+        cerr << "Erro ao criar " << file << endl;
+        return false;
+    }
+
+    bool alpha = img.channels == 2 || img.channels == 4;
+    char magic = alpha ? '7' : img.channels == 3 ? (opt.binary ? '6' : '3') : (opt.binary ? '5' : '2');
+    char header[512];
+    out.put(header, ppmFormatHeader(header, sizeof(header), magic, img.width, img.height, img.channels, img.maxval,
+                                    opt.comment));
+
+    bool binary = opt.binary || alpha;
+    bool wide = img.maxval > 255;
+    size_t samples = (size_t)img.width * img.channels;
+    if (binary && !wide) {
+        out.putRows(img.data, samples, img.stride, img.height);
+    } else if (binary) {
+        // 16 bits são gravados em big-endian
+        for (int y = 0; y < img.height; y++) {
+            const uint16_t *row = (const uint16_t *)(img.data + (size_t)y * img.stride);
+            unsigned char *d = (unsigned char *)out.reserve(samples * 2);
+            for (size_t i = 0; i < samples; i++) {
+                d[2 * i] = row[i] >> 8;
+                d[2 * i + 1] = row[i] & 0xff;
+            }
+            out.commit(samples * 2);
+        }
+    } else {
+        // um pixel por linha, bem abaixo do limite de 70 colunas do formato
+        for (int y = 0; y < img.height; y++) {
+            const unsigned char *row = img.data + (size_t)y * img.stride;
+            for (int x = 0; x < img.width; x++) {
+                char *d = out.reserve(img.channels * 6);
+                char *p = d;
+                for (int c = 0; c < img.channels; c++) {
+                    size_t i = (size_t)x * img.channels + c;
+                    unsigned v = wide ? ((const uint16_t *)row)[i] : row[i];
+                    p = to_chars(p, d + img.channels * 6, v).ptr;
+                    *p++ = c + 1 < img.channels ? ' ' : '\n';
+                }
+                out.commit(p - d);
+            }
+        }
+    }
+
+    if (!out.close(opt.sync)) {
+        cerr << "Erro ao gravar " << file << endl;
+        return false;
+    }
+    return true;
+}
+
+inline bool writePPM(const string &file, const PPMRowView &img, const PPMWriteOptions &opt = PPMWriteOptions()) {
+    PPMOutput out(opt.bufferSize);
+    return writePPM(out, file, img, opt);
+}
+
+inline bool writePPM(const string &file, const PPMImage &img, const PPMWriteOptions &opt = PPMWriteOptions()) {
+    return writePPM(file, ppmView(img), opt);
+}
+
+#endif /* PPM_h */
@@ -0,0 +1,452 @@
+//
+//  Resample.h
+//
+//  Redimensionamento de imagens (bilinear, bicúbico e Lanczos) para reduzir
+//  quadros antes dos filtros e gerar miniaturas, em RGB 8 bits intercalado
+//  e em float planar (Image<RGBF, Planar> e afins).
+//
+//  O filtro é separável: uma passada horizontal para a nova largura e uma
+//  vertical para a nova altura. Os pesos de cada eixo são calculados uma vez
+//  (ResampleAxis): cada pixel de saída lê 'taps' amostras consecutivas a
+//  partir de first[x], já com a borda resolvida, então os laços internos
+//  não testam limites. Na redução o núcleo é alargado pela escala, para
+//  cobrir todos os pixels de entrada e não gerar serrilhado.
+//
+//  Em 8 bits os pesos têm 14 bits de fração e cada passada arredonda para
+//  8 bits; as versões escalar, SSE e AVX2 fazem a mesma conta e dão o mesmo
+//  resultado. Em float as somas seguem a mesma ordem nas três versões e o
+//  resultado não é limitado a [0, 1] (Lanczos e bicúbico podem passar um
+//  pouco nas bordas fortes).
+//
+//  A saída é dividida em faixas de linhas pelo FilterExecutor: cada faixa
+//  passa só as linhas de entrada de que precisa pela horizontal, para um
+//  buffer da thread, e a vertical lê dali.
+//
+
+#ifndef Resample_h
+#define Resample_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+
+#include "ImageFilters.h"
+#include "FilterExecutor.h"
+#include "Image.h"
+
+using namespace std;
+
+enum ResampleFilter { RESAMPLE_BILINEAR, RESAMPLE_BICUBIC, RESAMPLE_LANCZOS };
+
+inline const char *resampleFilterName(ResampleFilter f) {
+    switch (f) {
+        case RESAMPLE_BILINEAR: return "bilinear";
+        case RESAMPLE_BICUBIC:  return "bicúbico";
+        default:                return "Lanczos";
+    }
+}
+
+// raio do núcleo em pixels de entrada (sem redução)
+inline double resampleSupport(ResampleFilter f) {
+    return f == RESAMPLE_BILINEAR ? 1.0 : (f == RESAMPLE_BICUBIC ? 2.0 : 3.0);
+}
+
+inline double resampleSinc(double x) {
+    if (x == 0) return 1.0;
+    x *= M_PI;
+    return sin(x) / x;
+}
+
+inline double resampleKernel(ResampleFilter f, double x) {
+    x = fabs(x);
+    switch (f) {
+        case RESAMPLE_BILINEAR:
+            return x < 1 ? 1 - x : 0;
+        case RESAMPLE_BICUBIC: {
+            // Keys com a = -0.5 (o Catmull-Rom)
+            const double a = -0.5;
+            if (x < 1) return ((a + 2) * x - (a + 3)) * x * x + 1;
+            if (x < 2) return ((a * x - 5 * a) * x + 8 * a) * x - 4 * a;
+            return 0;
+        }
+        default:
+            return x < 3 ? resampleSinc(x) * resampleSinc(x / 3) : 0;
+    }
+}
+
+// Pesos de um eixo: a saída i é a soma de weights[i * taps + k] vezes a
+// entrada first[i] + k. taps é par sempre que cabe na entrada (a versão
+// SSE de 8 bits soma os taps de dois em dois) e first[i] + taps nunca
+// passa do fim; os taps que sobram têm peso zero.
+struct ResampleAxis {
+    int taps;
+    vector<int> first;
+    vector<float> weights;
+    vector<float> weightsByTap;     // [k * saídas + i], para a horizontal float
+    vector<int16_t> fixed;          // 14 bits de fração, soma 16384
+
+    void build(int srcSize, int dstSize, ResampleFilter f) {
+        double scale = (double)srcSize / dstSize;
+        double stretch = scale > 1 ? scale : 1;
+        double support = resampleSupport(f) * stretch;
+
+        // entradas [lo, hi) de cada saída; taps é a maior janela
+        vector<int> lo(dstSize), hi(dstSize);
+        taps = 1;
+        for (int i = 0; i < dstSize; i++) {
+            double center = (i + 0.5) * scale;
+            lo[i] = (int)floor(center - support + 0.5);
+            hi[i] = (int)floor(center + support + 0.5);
+            lo[i] = lo[i] < 0 ? 0 : lo[i];
+            hi[i] = hi[i] > srcSize ? srcSize : hi[i];
+            taps = hi[i] - lo[i] > taps ? hi[i] - lo[i] : taps;
+        }
+        taps += taps & 1;
+        taps = taps > srcSize ? srcSize : taps;
+        first.assign(dstSize, 0);
+        weights.assign((size_t)dstSize * taps, 0.0f);
+        weightsByTap.assign((size_t)dstSize * taps, 0.0f);
+        fixed.assign((size_t)dstSize * taps, 0);
+
+        vector<double> w(taps);
+        for (int i = 0; i < dstSize; i++) {
+            double center = (i + 0.5) * scale;
+            int start = lo[i] < srcSize - taps ? lo[i] : srcSize - taps;
+            first[i] = start;
+
+            double total = 0;
+            for (int k = 0; k < taps; k++) {
+                int j = start + k;
+                w[k] = j >= lo[i] && j < hi[i] ? resampleKernel(f, (j + 0.5 - center) / stretch) : 0;
+                total += w[k];
+            }
+            if (total == 0) {
+                // janela tão estreita que o núcleo não pegou nenhum centro
+                w[lo[i] - start] = total = 1;
+            }
+
+            int sum = 0, largest = 0;
+            for (int k = 0; k < taps; k++) {
+                w[k] /= total;
+                int q = (int)lrint(w[k] * 16384);
+                fixed[(size_t)i * taps + k] = (int16_t)q;
+                sum += q;
+                if (w[k] > w[largest]) largest = k;
+                weights[(size_t)i * taps + k] = (float)w[k];
+                weightsByTap[(size_t)k * dstSize + i] = (float)w[k];
+            }
+            // o arredondamento de cada peso não pode mudar o brilho
+            fixed[(size_t)i * taps + largest] += (int16_t)(16384 - sum);
+        }
+    }
+};
+
+inline unsigned char resampleClamp(int v) {
+    v = (v + 8192) >> 14;
+    return (unsigned char)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+/*----------------------------------ESCALAR-----------------------------------*/
+// saídas [x0, x1) de uma linha RGB
+inline void resampleRowScalar(const unsigned char *row, const ResampleAxis &ax, int x0, int x1, unsigned char *out) {
+    for (int x = x0; x < x1; x++) {
+        const unsigned char *p = row + ax.first[x] * 3;
+        const int16_t *w = &ax.fixed[(size_t)x * ax.taps];
+        int r = 0, g = 0, b = 0;
+        for (int k = 0; k < ax.taps; k++, p += 3) {
+            r += p[0] * w[k];
+            g += p[1] * w[k];
+            b += p[2] * w[k];
+        }
+        out[x * 3] = resampleClamp(r);
+        out[x * 3 + 1] = resampleClamp(g);
+        out[x * 3 + 2] = resampleClamp(b);
+    }
+}
+
+// out[i] = soma de rows[k][i] * w[k], para as amostras [i0, i1)
+inline void resampleColumnsScalar(const unsigned char *const *rows, const int16_t *w, int taps, int i0, int i1,
+                                  unsigned char *out) {
+    for (int i = i0; i < i1; i++) {
+        int sum = 0;
+        for (int k = 0; k < taps; k++) sum += rows[k][i] * w[k];
+        out[i] = resampleClamp(sum);
+    }
+}
+
+inline void resampleRowFloatScalar(const float *row, const ResampleAxis &ax, int x0, int x1, float *out) {
+    for (int x = x0; x < x1; x++) {
+        const float *p = row + ax.first[x];
+        const float *w = &ax.weights[(size_t)x * ax.taps];
+        float sum = 0;
+        for (int k = 0; k < ax.taps; k++) sum += p[k] * w[k];
+        out[x] = sum;
+    }
+}
+
+inline void resampleColumnsFloatScalar(const float *const *rows, const float *w, int taps, int i0, int i1, float *out) {
+    for (int i = i0; i < i1; i++) {
+        float sum = 0;
+        for (int k = 0; k < taps; k++) sum += rows[k][i] * w[k];
+        out[i] = sum;
+    }
+}
+
+#ifdef IF_X86_SIMD
+/*-------------------------------------SSE------------------------------------*/
+// Dois taps por vez: 8 bytes (dois pixels e 2 bytes do seguinte) viram
+// (r0 r1 g0 g1 b0 b1 0 0) em 16 bits e madd com (w0 w1) soma os pares.
+// Os pixels cujo último par leria além da linha ficam com a escalar.
+__attribute__((target("ssse3"))) inline void resampleRowSSE(const unsigned char *row, int width, const ResampleAxis &ax,
+                                                           int x0, int x1, unsigned char *out) {
+    if (ax.taps & 1) return resampleRowScalar(row, ax, x0, x1, out);
+    const __m128i pairs = _mm_setr_epi8(0, -1, 3, -1, 1, -1, 4, -1, 2, -1, 5, -1, -1, -1, -1, -1);
+    const __m128i half = _mm_set1_epi32(8192);
+    for (int x = x0; x < x1; x++) {
+        if (3 * (ax.first[x] + ax.taps) + 2 > 3 * width) {
+            resampleRowScalar(row, ax, x, x + 1, out);
+            continue;
+        }
+        const unsigned char *p = row + ax.first[x] * 3;
+        const int16_t *w = &ax.fixed[(size_t)x * ax.taps];
+        __m128i sum = half;
+        for (int k = 0; k < ax.taps; k += 2, p += 6) {
+            __m128i v = _mm_shuffle_epi8(_mm_loadl_epi64((const __m128i *)p), pairs);
+            __m128i wk = _mm_set1_epi32((int)(((uint32_t)(uint16_t)w[k + 1] << 16) | (uint16_t)w[k]));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(v, wk));
+        }
+        sum = _mm_srai_epi32(sum, 14);
+        int rgb = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(sum, sum), sum));
+        memcpy(out + x * 3, &rgb, 3);
+    }
+}
+
+// Duas linhas por vez: os bytes das duas intercalados em 16 bits e madd com
+// (w[k] w[k+1]). Um tap ímpar no fim faz par com ele mesmo e peso zero.
+__attribute__((target("sse2"))) inline void resampleColumnsSSE(const unsigned char *const *rows, const int16_t *w, int taps,
+                                                              int i0, int i1, unsigned char *out) {
+    const __m128i zero = _mm_setzero_si128(), half = _mm_set1_epi32(8192);
+    int i = i0;
+    for (; i + 16 <= i1; i += 16) {
+        __m128i s0 = half, s1 = half, s2 = half, s3 = half;
+        for (int k = 0; k < taps; k += 2) {
+            bool pair = k + 1 < taps;
+            __m128i a = _mm_loadu_si128((const __m128i *)(rows[k] + i));
+            __m128i b = _mm_loadu_si128((const __m128i *)(rows[pair ? k + 1 : k] + i));
+            __m128i wk = _mm_set1_epi32((int)(((uint32_t)(uint16_t)(pair ? w[k + 1] : 0) << 16) | (uint16_t)w[k]));
+            __m128i lo = _mm_unpacklo_epi8(a, b), hi = _mm_unpackhi_epi8(a, b);
+            s0 = _mm_add_epi32(s0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), wk));
+            s1 = _mm_add_epi32(s1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), wk));
+            s2 = _mm_add_epi32(s2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), wk));
+            s3 = _mm_add_epi32(s3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), wk));
+        }
+        __m128i lo = _mm_packs_epi32(_mm_srai_epi32(s0, 14), _mm_srai_epi32(s1, 14));
+        __m128i hi = _mm_packs_epi32(_mm_srai_epi32(s2, 14), _mm_srai_epi32(s3, 14));
+        _mm_storeu_si128((__m128i *)(out + i), _mm_packus_epi16(lo, hi));
+    }
+    resampleColumnsScalar(rows, w, taps, i, i1, out);
+}
+
+__attribute__((target("sse2"))) inline void resampleColumnsFloatSSE(const float *const *rows, const float *w, int taps,
+                                                                   int samples, float *out) {
+    int i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        __m128 sum = _mm_setzero_ps();
+        for (int k = 0; k < taps; k++) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(rows[k] + i), _mm_set1_ps(w[k])));
+        }
+        _mm_storeu_ps(out + i, sum);
+    }
+    resampleColumnsFloatScalar(rows, w, taps, i, samples, out);
+}
+
+/*------------------------------------AVX2------------------------------------*/
+// 16 amostras por vez: cvtepu8 leva cada linha a 16 bits e unpack intercala
+// as duas linhas dentro de cada metade de 128 bits; packs depois devolve a
+// ordem original e o permute junta as duas metades.
+__attribute__((target("avx2"))) inline void resampleColumnsAVX2(const unsigned char *const *rows, const int16_t *w, int taps,
+                                                               int samples, unsigned char *out) {
+    const __m256i half = _mm256_set1_epi32(8192);
+    int i = 0;
+    for (; i + 16 <= samples; i += 16) {
+        __m256i lo = half, hi = half;
+        for (int k = 0; k < taps; k += 2) {
+            bool pair = k + 1 < taps;
+            __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(rows[k] + i)));
+            __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(rows[pair ? k + 1 : k] + i)));
+            __m256i wk = _mm256_set1_epi32((int)(((uint32_t)(uint16_t)(pair ? w[k + 1] : 0) << 16) | (uint16_t)w[k]));
+            lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), wk));
+            hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), wk));
+        }
+        __m256i v = _mm256_packs_epi32(_mm256_srai_epi32(lo, 14), _mm256_srai_epi32(hi, 14));
+        v = _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), 0xD8);
+        _mm_storeu_si128((__m128i *)(out + i), _mm256_castsi256_si128(v));
+    }
+    resampleColumnsSSE(rows, w, taps, i, samples, out);
+}
+
+// 8 saídas por vez: gather busca a amostra first[x] + k de cada uma
+__attribute__((target("avx2"))) inline void resampleRowFloatAVX2(const float *row, const ResampleAxis &ax, int x0, int x1,
+                                                                float *out) {
+    int dstSize = (int)ax.first.size();
+    int x = x0;
+    for (; x + 8 <= x1; x += 8) {
+        __m256i index = _mm256_loadu_si256((const __m256i *)&ax.first[x]);
+        __m256 sum = _mm256_setzero_ps();
+        for (int k = 0; k < ax.taps; k++) {
+            __m256 v = _mm256_i32gather_ps(row + k, index, 4);
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(v, _mm256_loadu_ps(&ax.weightsByTap[(size_t)k * dstSize + x])));
+        }
+        _mm256_storeu_ps(out + x, sum);
+    }
+    resampleRowFloatScalar(row, ax, x, x1, out);
+}
+
+__attribute__((target("avx2"))) inline void resampleColumnsFloatAVX2(const float *const *rows, const float *w, int taps,
+                                                                    int samples, float *out) {
+    int i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        __m256 sum = _mm256_setzero_ps();
+        for (int k = 0; k < taps; k++) {
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(rows[k] + i), _mm256_set1_ps(w[k])));
+        }
+        _mm256_storeu_ps(out + i, sum);
+    }
+    resampleColumnsFloatScalar(rows, w, taps, i, samples, out);
+}
+#endif /* IF_X86_SIMD */
+
+/*-------------------------------ENTRADAS PÚBLICAS----------------------------*/
+inline void resampleRow(const unsigned char *row, int width, const ResampleAxis &ax, unsigned char *out) {
+#ifdef IF_X86_SIMD
+    if (g_simdLevel != SIMD_SCALAR && simdHasSSSE3()) return resampleRowSSE(row, width, ax, 0, (int)ax.first.size(), out);
+#endif
+    (void)width;
+    resampleRowScalar(row, ax, 0, (int)ax.first.size(), out);
+}
+
+inline void resampleColumns(const unsigned char *const *rows, const int16_t *w, int taps, int samples, unsigned char *out) {
+#ifdef IF_X86_SIMD
+    if (g_simdLevel == SIMD_AVX2) return resampleColumnsAVX2(rows, w, taps, samples, out);
+    if (g_simdLevel == SIMD_SSE) return resampleColumnsSSE(rows, w, taps, 0, samples, out);
+#endif
+    resampleColumnsScalar(rows, w, taps, 0, samples, out);
+}
+
+inline void resampleRowFloat(const float *row, const ResampleAxis &ax, float *out) {
+#ifdef IF_X86_SIMD
+    if (g_simdLevel == SIMD_AVX2) return resampleRowFloatAVX2(row, ax, 0, (int)ax.first.size(), out);
+#endif
+    resampleRowFloatScalar(row, ax, 0, (int)ax.first.size(), out);
+}
+
+inline void resampleColumnsFloat(const float *const *rows, const float *w, int taps, int samples, float *out) {
+#ifdef IF_X86_SIMD
+    if (g_simdLevel == SIMD_AVX2) return resampleColumnsFloatAVX2(rows, w, taps, samples, out);
+    if (g_simdLevel == SIMD_SSE) return resampleColumnsFloatSSE(rows, w, taps, samples, out);
+#endif
+    resampleColumnsFloatScalar(rows, w, taps, 0, samples, out);
+}
+
+// linhas de saída por faixa: o orçamento conta as linhas de entrada que a
+// faixa relê, e pelo menos 'taps' linhas para que a releitura entre faixas
+// vizinhas não passe do dobro
+inline void resampleBands(FilterExecutor &exec, const ResampleAxis &ay, size_t rowBytes,
+                          const function<void(int, int)> &fn) {
+    int dstRows = (int)ay.first.size();
+    double scale = dstRows ? (double)(ay.first.back() + ay.taps) / dstRows : 1;
+    scale = scale < 1 ? 1 : scale;
+    exec.runBands(dstRows, (size_t)(rowBytes * scale), ay.taps, fn);
+}
+
+// Redimensiona src para o tamanho de dst (com strides quaisquer; não podem
+// se sobrepor).
+inline void resample(FilterExecutor &exec, const ImageView<RGB8, Interleaved> &src,
+                     const ImageView<RGB8, Interleaved> &dst, ResampleFilter filter = RESAMPLE_BICUBIC) {
+    if (src.width <= 0 || src.height <= 0 || dst.width <= 0 || dst.height <= 0) return;
+    ResampleAxis ax, ay;
+    ax.build(src.width, dst.width, filter);
+    ay.build(src.height, dst.height, filter);
+    size_t samples = (size_t)dst.width * 3;
+
+    resampleBands(exec, ay, samples, [&](int y0, int y1) {
+        int sy0 = ay.first[y0], sy1 = ay.first[y1 - 1] + ay.taps;
+        thread_local vector<unsigned char> buffer;
+        thread_local vector<const unsigned char *> lines;
+        buffer.resize((size_t)(sy1 - sy0) * samples);
+        lines.resize(sy1 - sy0);
+        for (int sy = sy0; sy < sy1; sy++) {
+            unsigned char *line = &buffer[(size_t)(sy - sy0) * samples];
+            resampleRow(src.row(sy), src.width, ax, line);
+            lines[sy - sy0] = line;
+        }
+        for (int y = y0; y < y1; y++) {
+            resampleColumns(&lines[ay.first[y] - sy0], &ay.fixed[(size_t)y * ay.taps], ay.taps, (int)samples, dst.row(y));
+        }
+    });
+}
+
+// float planar, canal a canal
+template <int C>
+inline void resample(FilterExecutor &exec, const ImageView<PixelFormat<float, C>, Planar> &src,
+                     const ImageView<PixelFormat<float, C>, Planar> &dst, ResampleFilter filter = RESAMPLE_BICUBIC) {
+    if (src.width <= 0 || src.height <= 0 || dst.width <= 0 || dst.height <= 0) return;
+    ResampleAxis ax, ay;
+    ax.build(src.width, dst.width, filter);
+    ay.build(src.height, dst.height, filter);
+    size_t samples = dst.width;
+
+    resampleBands(exec, ay, samples * C * sizeof(float), [&](int y0, int y1) {
+        int sy0 = ay.first[y0], sy1 = ay.first[y1 - 1] + ay.taps;
+        thread_local vector<float> buffer;
+        thread_local vector<const float *> lines;
+        buffer.resize((size_t)(sy1 - sy0) * samples);
+        lines.resize(sy1 - sy0);
+        for (int c = 0; c < C; c++) {
+            for (int sy = sy0; sy < sy1; sy++) {
+                float *line = &buffer[(size_t)(sy - sy0) * samples];
+                resampleRowFloat(src.row(sy, c), ax, line);
+                lines[sy - sy0] = line;
+            }
+            for (int y = y0; y < y1; y++) {
+                resampleColumnsFloat(&lines[ay.first[y] - sy0], &ay.weights[(size_t)y * ay.taps], ay.taps,
+                                     (int)samples, dst.row(y, c));
+            }
+        }
+    });
+}
+
+// Tamanho final: com as duas medidas, exatamente width x height (mesmo que
+// distorça); com uma delas <= 0, ela segue a proporção da outra; sem
+// nenhuma, o tamanho original.
+inline void resampleSize(int srcWidth, int srcHeight, int &width, int &height) {
+    if (width <= 0 && height <= 0) {
+        width = srcWidth;
+        height = srcHeight;
+    } else if (height <= 0) {
+        height = (int)((long long)srcHeight * width / srcWidth);
+    } else if (width <= 0) {
+        width = (int)((long long)srcWidth * height / srcHeight);
+    }
+    width = width < 1 ? 1 : width;
+    height = height < 1 ? 1 : height;
+}
+
+// imagem nova com o tamanho pedido
+template <class F>
+inline Image<F, Planar> resampled(FilterExecutor &exec, const Image<F, Planar> &src, int width, int height,
+                                  ResampleFilter filter = RESAMPLE_BICUBIC) {
+    Image<F, Planar> out(width, height);
+    resample(exec, src.view(), out.view(), filter);
+    return out;
+}
+
+inline Image<RGB8> resampled(FilterExecutor &exec, const Image<RGB8> &src, int width, int height,
+                             ResampleFilter filter = RESAMPLE_BICUBIC) {
+    Image<RGB8> out(width, height);
+    resample(exec, src.view(), out.view(), filter);
+    return out;
+}
+
+#endif /* Resample_h */
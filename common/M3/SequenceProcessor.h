@@ -0,0 +1,317 @@
+//
+//  SequenceProcessor.h
+//
+//  Modo sequência do exemplo_03: a cadeia de filtros aplicada a quadros
+//  numerados (renders, quadros de vídeo: "quadros/f_%04d.ppm" ou
+//  "quadros/f_####.ppm"), gravados na mesma ordem.
+//
+//  Três estágios ligados por filas limitadas: uma thread lê o quadro n + 1
+//  (e os seguintes) enquanto os filtros trabalham no quadro n e outra thread
+//  grava o n - 1. Os quadros circulam por um conjunto fixo de buffers: o
+//  leitor pega um buffer livre, o gravador o devolve, e nenhum quadro aloca
+//  memória depois que os buffers chegam ao tamanho do maior quadro. Com mais
+//  de um trabalhador de filtros os quadros podem terminar fora de ordem; o
+//  gravador os segura até chegar a vez de cada um.
+//
+//  Cada estágio mede o tempo ocupado e o tempo parado esperando o vizinho:
+//  leitor parado é disco mais rápido que os filtros, filtros parados são
+//  disco lento, e assim por diante.
+//
+
+#ifndef SequenceProcessor_h
+#define SequenceProcessor_h
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <filesystem>
+#include <iostream>
+
+#include "PPM.h"
+#include "FilterExecutor.h"
+#include "FilterChain.h"
+#include "StreamProcessor.h"
+
+using namespace std;
+
+// Nome do quadro n: "%d"/"%04d" como no printf, ou uma sequência de '#'
+// (um por dígito, completada com zeros). Vazio se o padrão não tiver número.
+inline string sequenceName(const string &pattern, int n) {
+    size_t pos = pattern.find('%');
+    if (pos != string::npos) {
+        size_t end = pos + 1;
+        while (end < pattern.size() && pattern[end] >= '0' && pattern[end] <= '9') end++;
+        if (end >= pattern.size() || pattern[end] != 'd') return "";
+        char number[32];
+        snprintf(number, sizeof(number), pattern.substr(pos, end + 1 - pos).c_str(), n);
+        return pattern.substr(0, pos) + number + pattern.substr(end + 1);
+    }
+    pos = pattern.find('#');
+    if (pos == string::npos) return "";
+    size_t end = pattern.find_first_not_of('#', pos);
+    end = end == string::npos ? pattern.size() : end;
+    char number[32];
+    snprintf(number, sizeof(number), "%0*d", (int)(end - pos), n);
+    return pattern.substr(0, pos) + number + pattern.substr(end);
+}
+
+struct SequenceOptions {
+    string outputDir;           // onde gravar (mesmo nome de cada quadro, extensão .ppm)
+    int first, last;            // quadros [first, last]; first < 0 começa em 0 ou 1, last < 0 vai até faltar um
+    int buffers;                // quadros em circulação entre os estágios
+    int workers;                // quadros filtrados ao mesmo tempo (cada um com parte dos núcleos)
+    const char *comment;
+    bool quiet;                 // sem uma linha por quadro
+
+    SequenceOptions() : first(-1), last(-1), buffers(4), workers(1), comment(NULL), quiet(false) {}
+};
+
+struct SequenceStats {
+    int frames, failed;
+    double megapixels;
+    double seconds;
+    double busy[3], stalled[3];     // segundos de cada estágio: leitura, filtros, gravação
+
+    SequenceStats() : frames(0), failed(0), megapixels(0), seconds(0) {
+        for (int s = 0; s < 3; s++) busy[s] = stalled[s] = 0;
+    }
+};
+
+class SequenceProcessor {
+    typedef chrono::steady_clock Clock;
+
+    struct Frame {
+        int number;             // número no nome do arquivo
+        int order;              // posição na sequência (0, 1, ...)
+        int width, height;
+        vector<unsigned char> pixels;   // RGB8; só cresce
+        vector<unsigned char> scratch;  // segundo buffer dos filtros de vizinhança
+        bool ok;
+        double readMs, computeMs;
+    };
+
+    static double secondsSince(Clock::time_point t) {
+        return chrono::duration<double>(Clock::now() - t).count();
+    }
+
+    FilterChain &chain;
+    FilterExecutor &exec;
+    SequenceOptions opt;
+    string pattern;
+    mutex printMutex;
+
+    static bool exists(const string &file) {
+        error_code ec;
+        return !file.empty() && filesystem::exists(file, ec);
+    }
+
+    string outputName(int number) const {
+        namespace fs = filesystem;
+        fs::path out = fs::path(opt.outputDir.empty() ? "." : opt.outputDir) / fs::path(sequenceName(pattern, number)).filename();
+        out.replace_extension(".ppm");
+        return out.string();
+    }
+
+    // P5/P6 de 8 bits vão direto do disco para o buffer; os demais formatos
+    // passam pelo readPPM (e alocam) antes da cópia
+    static bool readFrame(const string &file, Frame &f) {
+        PPMBandReader reader;
+        if (reader.open(file, true)) {
+            f.width = reader.header.width;
+            f.height = reader.header.height;
+            f.pixels.resize((size_t)f.width * f.height * 3);
+            return reader.readRows(0, f.height, f.pixels.data());
+        }
+        PPMImage img;
+        if (!readPPM(file, img)) return false;
+        ppmToRGB8(img);
+        f.width = img.width;
+        f.height = img.height;
+        f.pixels.resize((size_t)f.width * f.height * 3);
+        memcpy(f.pixels.data(), img.data(), f.pixels.size());
+        return true;
+    }
+
+    void report(const Frame &f) {
+        if (opt.quiet) return;
+        lock_guard<mutex> lock(printMutex);
+        string name = sequenceName(pattern, f.number);
+        if (!f.ok) {
+            cout << name << ": FALHOU" << endl;
+            return;
+        }
+        printf("%s: leitura %.1f ms, filtros %.1f ms\n", name.c_str(), f.readMs, f.computeMs);
+    }
+
+public:
+    SequenceProcessor(FilterChain &chain, FilterExecutor &exec, const string &pattern,
+                      const SequenceOptions &opt = SequenceOptions())
+        : chain(chain), exec(exec), opt(opt), pattern(pattern) {}
+
+    // Processa a sequência; falso se o padrão é inválido, se nenhum quadro
+    // foi encontrado ou se algum quadro falhou.
+    bool run(SequenceStats &stats) {
+        namespace fs = filesystem;
+        stats = SequenceStats();
+        if (sequenceName(pattern, 0).empty()) {
+            cerr << "Padrão sem número de quadro: " << pattern << " (use %04d ou ####)" << endl;
+            return false;
+        }
+        int first = opt.first;
+        if (first < 0) first = exists(sequenceName(pattern, 0)) || !exists(sequenceName(pattern, 1)) ? 0 : 1;
+        if (opt.last >= 0 && opt.last < first) {
+            cerr << "Intervalo de quadros invertido: " << first << ":" << opt.last << endl;
+            return false;
+        }
+        if (!exists(sequenceName(pattern, first))) {
+            cerr << "Quadro inicial não encontrado: " << sequenceName(pattern, first) << endl;
+            return false;
+        }
+        error_code ec;
+        if (!opt.outputDir.empty()) fs::create_directories(opt.outputDir, ec);
+        if (ec) {
+            cerr << "Erro ao criar " << opt.outputDir << ": " << ec.message() << endl;
+            return false;
+        }
+        if (fs::exists(outputName(first), ec) && fs::equivalent(sequenceName(pattern, first), outputName(first), ec)) {
+            cerr << "A saída seria a própria sequência de entrada" << endl;
+            return false;
+        }
+
+        int count = opt.buffers > 1 ? opt.buffers : 2;
+        int workers = opt.workers > 0 ? opt.workers : 1;
+        vector<unique_ptr<Frame> > pool(count);
+        BlockingQueue<Frame *> idle(count), toFilter(count), toWrite(count);
+        for (int i = 0; i < count; i++) {
+            pool[i].reset(new Frame());
+            idle.push(pool[i].get());
+        }
+
+        // um executor só não pode ser usado por duas threads ao mesmo
+        // tempo: com vários trabalhadores cada um tem o seu
+        vector<unique_ptr<FilterExecutor> > executors;
+        if (workers > 1) {
+            int share = exec.threadCount() / workers;
+            for (int w = 0; w < workers; w++) executors.push_back(unique_ptr<FilterExecutor>(new FilterExecutor(share > 0 ? share : 1)));
+        }
+
+        mutex statsMutex;
+        Clock::time_point start = Clock::now();
+
+        thread reader([&] {
+            double busy = 0, stalled = 0;
+            for (int order = 0, n = first; opt.last < 0 || n <= opt.last; order++, n++) {
+                string file = sequenceName(pattern, n);
+                if (opt.last < 0 && !exists(file)) break;
+                Clock::time_point t = Clock::now();
+                Frame *f;
+                if (!idle.pop(f)) break;
+                stalled += secondsSince(t);
+
+                t = Clock::now();
+                f->number = n;
+                f->order = order;
+                f->computeMs = 0;
+                f->ok = readFrame(file, *f);
+                f->readMs = secondsSince(t) * 1e3;
+                busy += f->readMs / 1e3;
+                toFilter.push(f);
+            }
+            toFilter.close();
+            lock_guard<mutex> lock(statsMutex);
+            stats.busy[0] = busy;
+            stats.stalled[0] = stalled;
+        });
+
+        vector<thread> filters;
+        int filtersLeft = workers;
+        for (int w = 0; w < workers; w++) {
+            filters.push_back(thread([&, w] {
+                FilterExecutor &e = workers > 1 ? *executors[w] : exec;
+                double busy = 0, stalled = 0;
+                Frame *f;
+                for (;;) {
+                    Clock::time_point t = Clock::now();
+                    if (!toFilter.pop(f)) break;
+                    stalled += secondsSince(t);
+                    if (f->ok) {
+                        t = Clock::now();
+                        // o buffer interno de FilterChain::apply seria disputado
+                        // pelos trabalhadores: cada quadro leva o seu
+                        if (!chain.inPlace()) f->scratch.resize(f->pixels.size());
+                        unsigned char *result = chain.apply(e, f->pixels.data(), f->scratch.data(), f->width, f->height);
+                        if (result != f->pixels.data()) f->pixels.swap(f->scratch);
+                        f->computeMs = secondsSince(t) * 1e3;
+                        busy += f->computeMs / 1e3;
+                    }
+                    toWrite.push(f);
+                }
+                lock_guard<mutex> lock(statsMutex);
+                stats.busy[1] += busy;
+                stats.stalled[1] += stalled;
+                if (--filtersLeft == 0) toWrite.close();
+            }));
+        }
+
+        thread writer([&] {
+            double busy = 0, stalled = 0;
+            // quadros que chegaram antes da vez: no máximo count - 1
+            vector<Frame *> pending(count, (Frame *)NULL);
+            PPMOutput out(1 << 16);
+            PPMWriteOptions wo;
+            wo.comment = opt.comment;
+            int next = 0;
+            Frame *f;
+            for (;;) {
+                Clock::time_point t = Clock::now();
+                if (!toWrite.pop(f)) break;
+                stalled += secondsSince(t);
+                pending[f->order % count] = f;
+                while ((f = pending[next % count]) != NULL && f->order == next) {
+                    pending[next % count] = NULL;
+                    t = Clock::now();
+                    if (f->ok) {
+                        f->ok = writePPM(out, outputName(f->number), ppmView(f->pixels.data(), f->width, f->height), wo);
+                    }
+                    busy += secondsSince(t);
+                    report(*f);
+                    stats.frames++;
+                    if (f->ok) {
+                        stats.megapixels += (double)f->width * f->height / 1e6;
+                    } else {
+                        stats.failed++;
+                    }
+                    next++;
+                    idle.push(f);
+                }
+            }
+            lock_guard<mutex> lock(statsMutex);
+            stats.busy[2] = busy;
+            stats.stalled[2] = stalled;
+        });
+
+        reader.join();
+        for (size_t w = 0; w < filters.size(); w++) filters[w].join();
+        writer.join();
+        stats.seconds = secondsSince(start);
+        return stats.frames > 0 && stats.failed == 0;
+    }
+};
+
+inline void printSequenceStats(const SequenceStats &s) {
+    double t = s.seconds > 0 ? s.seconds : 1e-9;
+    printf("%d quadros (%d com erro) em %.2f s: %.1f quadros/s, %.1f MP/s\n", s.frames, s.failed, s.seconds,
+           (s.frames - s.failed) / t, s.megapixels / t);
+    const char *names[3] = { "leitura: ", "filtros: ", "gravação:" };
+    const char *waits[3] = { "buffer livre", "quadro lido", "quadro filtrado" };
+    for (int i = 0; i < 3; i++) {
+        printf("  %s ocupada %6.2f s, parada %6.2f s esperando %s\n", names[i], s.busy[i], s.stalled[i], waits[i]);
+    }
+}
+
+#endif /* SequenceProcessor_h */
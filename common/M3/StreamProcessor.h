@@ -0,0 +1,372 @@
+//
+//  StreamProcessor.h
+//
+//  Processamento de imagens PPM maiores que a memória, em faixas de linhas.
+//
+//  A imagem nunca é carregada inteira: uma thread lê a próxima faixa do
+//  disco enquanto a thread que chamou aplica os filtros na faixa atual e
+//  outra thread grava a anterior. As faixas circulam por um conjunto fixo
+//  de buffers, então o pico de memória é de poucas faixas, seja a imagem de
+//  10 MB ou de 100 GB.
+//
+//  Filtros de vizinhança recebem 'halo' linhas extras acima e abaixo de
+//  cada faixa (relidas do arquivo), com as bordas da imagem replicadas como
+//  em FilterExecutor::runNeighborhood.
+//
+
+#ifndef StreamProcessor_h
+#define StreamProcessor_h
+
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+
+#include "PPM.h"
+#include "FilterExecutor.h"
+#include "FilterPipeline.h"
+#include "FilterChain.h"
+
+using namespace std;
+
+// Fila entre threads. Com capacidade > 0, push espera haver espaço;
+// depois de close(), pop esvazia o que restou e então retorna falso.
+template <typename T>
+class BlockingQueue {
+    mutex m;
+    condition_variable notEmpty, notFull;
+    deque<T> items;
+    size_t capacity;
+    bool closed;
+
+public:
+    explicit BlockingQueue(size_t capacity = 0) : capacity(capacity), closed(false) {}
+
+    // retorna falso se a fila já foi fechada
+    bool push(const T &item) {
+        unique_lock<mutex> lock(m);
+        notFull.wait(lock, [this] { return closed || capacity == 0 || items.size() < capacity; });
+        if (closed) return false;
+        items.push_back(item);
+        notEmpty.notify_one();
+        return true;
+    }
+
+    bool pop(T &item) {
+        unique_lock<mutex> lock(m);
+        notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty()) return false;
+        item = items.front();
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        lock_guard<mutex> lock(m);
+        closed = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+};
+
+// Uma faixa em processamento. 'in' aponta para a linha y0 - haloTop e tem
+// haloTop + (y1 - y0) + haloBottom linhas RGB8; 'out' aponta para a linha
+// y0 do resultado. Sem halo, 'out' é a própria entrada (filtro no lugar);
+// com halo, 'out' é um segundo buffer do mesmo tamanho de 'in', e compute
+// pode apontá-lo para qualquer lugar dos dois buffers.
+struct StreamBand {
+    int index;
+    int y0, y1;
+    int width, height;          // dimensões da imagem inteira
+    int haloTop, haloBottom;
+    unsigned char *in;
+    unsigned char *out;
+    size_t stride;
+
+    int rows() const {
+        return y1 - y0;
+    }
+};
+
+struct PPMStreamOptions {
+    int bandRows;               // linhas por faixa
+    int halo;                   // linhas de vizinhança de cada lado
+    int slots;                  // faixas em circulação (lendo, filtrando, gravando)
+    const char *comment;        // comentário no cabeçalho da saída
+    bool sync;                  // fsync antes de fechar
+
+    PPMStreamOptions() : bandRows(256), halo(0), slots(4), comment(NULL), sync(false) {}
+};
+
+// Memória usada pelos buffers das faixas para uma imagem de largura 'width'.
+inline size_t ppmStreamMemory(int width, const PPMStreamOptions &opt) {
+    size_t rowBytes = (size_t)width * 3;
+    size_t perSlot = (size_t)(opt.bandRows + 2 * opt.halo) * rowBytes;
+    if (opt.halo > 0) perSlot *= 2;
+    return perSlot * opt.slots;
+}
+
+// Leitura de linhas em posições arbitrárias de um P5/P6 de 8 bits.
+class PPMBandReader {
+#ifndef _WIN32
+    int fd;
+#else
+    FILE *fp;
+#endif
+    long long dataOffset;
+    size_t fileRowBytes;
+    unsigned char scale[256];
+
+public:
+    PPMHeader header;
+
+    PPMBandReader() : dataOffset(0), fileRowBytes(0) {
+#ifndef _WIN32
+        fd = -1;
+#else
+        fp = NULL;
+#endif
+    }
+
+    ~PPMBandReader() {
+#ifndef _WIN32
+        if (fd >= 0) ::close(fd);
+#else
+        if (fp) fclose(fp);
+#endif
+    }
+
+    // quiet: sem mensagem quando o arquivo não abre ou não é P5/P6 de 8 bits
+    // (quem chamou vai tentar ler de outro jeito e reportar)
+    bool open(const string &file, bool quiet = false) {
+#ifndef _WIN32
+        fd = ::open(file.c_str(), O_RDONLY);
+        if (fd < 0) {
+            if (!quiet) cerr << "Erro ao abrir " << file << endl;
+            return false;
+        }
+#else
+        fp = fopen(file.c_str(), "rb");
+        if (!fp) {
+            if (!quiet) cerr << "Erro ao abrir " << file << endl;
+            return false;
+        }
+#endif
+        // comentários podem deixar o cabeçalho maior que o primeiro bloco:
+        // enquanto a análise esbarrar no fim do que foi lido, lê o dobro
+        vector<char> head(4096);
+        const char *p;
+        for (;;) {
+            size_t got;
+#ifndef _WIN32
+            ssize_t r = pread(fd, head.data(), head.size(), 0);
+            got = r > 0 ? r : 0;
+#else
+            fseek(fp, 0, SEEK_SET);
+            got = fread(head.data(), 1, head.size(), fp);
+#endif
+            p = head.data();
+            const char *end = p + got;
+            if (ppmParseHeader(file, p, end, header, true)) break;
+            if (p == end && got == head.size()) {
+                head.resize(2 * head.size());
+                continue;
+            }
+            if (!quiet) {
+                p = head.data();
+                ppmParseHeader(file, p, end, header);
+            }
+            return false;
+        }
+        if (header.type != '5' && header.type != '6') {
+            if (!quiet) cerr << file << ": o modo em faixas só lê P5/P6 (os formatos texto exigem a imagem inteira)" << endl;
+            return false;
+        }
+        if (header.maxval > 255) {
+            if (!quiet) cerr << file << ": o modo em faixas só lê imagens de 8 bits" << endl;
+            return false;
+        }
+        dataOffset = p - head.data();
+        fileRowBytes = (size_t)header.width * header.channels;
+        for (int v = 0; v < 256; v++) {
+            int s = (v * 255 + header.maxval / 2) / header.maxval;
+            scale[v] = s > 255 ? 255 : s;
+        }
+        return true;
+    }
+
+    // Lê as linhas [y0, y1) em 'dst' como RGB8 compacto (cinza vira R=G=B).
+    bool readRows(int y0, int y1, unsigned char *dst) {
+        size_t bytes = (size_t)(y1 - y0) * fileRowBytes;
+        long long offset = dataOffset + (long long)y0 * fileRowBytes;
+        size_t done = 0;
+#ifndef _WIN32
+        while (done < bytes) {
+            ssize_t r = pread(fd, dst + done, bytes - done, offset + done);
+            if (r <= 0) break;
+            done += r;
+        }
+#else
+        if (_fseeki64(fp, offset, SEEK_SET) == 0) done = fread(dst, 1, bytes, fp);
+#endif
+        if (done < bytes) return false;
+
+        size_t pixels = (size_t)(y1 - y0) * header.width;
+        if (header.channels == 1) {
+            // de trás para frente: o destino de cada pixel nunca está antes da origem
+            for (size_t i = pixels; i-- > 0;) {
+                unsigned char v = scale[dst[i]];
+                dst[3 * i] = dst[3 * i + 1] = dst[3 * i + 2] = v;
+            }
+        } else if (header.maxval != 255) {
+            for (size_t i = 0; i < pixels * 3; i++) dst[i] = scale[dst[i]];
+        }
+        return true;
+    }
+};
+
+// Lê 'in' em faixas, chama compute(faixa) na thread de quem chamou e grava
+// o resultado em 'out' (P6), com leitura, cálculo e gravação sobrepostos.
+// Entrada e saída não podem ser o mesmo arquivo.
+inline bool streamPPM(const string &in, const string &out, const PPMStreamOptions &opt,
+                      const function<void(StreamBand &)> &compute) {
+    PPMBandReader reader;
+    if (!reader.open(in)) {
+        return false;
+    }
+    int w = reader.header.width;
+    int h = reader.header.height;
+    int halo = opt.halo > 0 ? opt.halo : 0;
+    int bandRows = opt.bandRows > 0 ? opt.bandRows : 1;
+    int slotCount = opt.slots >= 2 ? opt.slots : 2;
+    size_t stride = (size_t)w * 3;
+
+    PPMOutput output(1 << 16);
+    if (!output.open(out)) {
+        cerr << "Erro ao criar " << out << endl;
+        return false;
+    }
+    char header[512];
+    output.put(header, ppmFormatHeader(header, sizeof(header), '6', w, h, 3, 255, opt.comment));
+
+    struct Slot {
+        vector<unsigned char> in, out;
+        StreamBand band;
+    };
+    vector<Slot> slots(slotCount);
+    BlockingQueue<Slot *> freeSlots, ready, done;
+    for (int i = 0; i < slotCount; i++) {
+        slots[i].in.resize((size_t)(bandRows + 2 * halo) * stride);
+        if (halo > 0) slots[i].out.resize(slots[i].in.size());
+        freeSlots.push(&slots[i]);
+    }
+
+    atomic<bool> readFailed(false), failed(false);
+
+    thread readThread([&] {
+        int bands = (h + bandRows - 1) / bandRows;
+        for (int i = 0; i < bands && !failed; i++) {
+            Slot *s;
+            if (!freeSlots.pop(s)) break;
+            StreamBand &b = s->band;
+            b.index = i;
+            b.y0 = i * bandRows;
+            b.y1 = b.y0 + bandRows < h ? b.y0 + bandRows : h;
+            b.width = w;
+            b.height = h;
+            b.haloTop = b.y0 - halo < 0 ? b.y0 : halo;
+            b.haloBottom = b.y1 + halo > h ? h - b.y1 : halo;
+            b.stride = stride;
+            b.in = s->in.data();
+            b.out = halo > 0 ? s->out.data() : b.in;
+            if (!reader.readRows(b.y0 - b.haloTop, b.y1 + b.haloBottom, b.in)) {
+                readFailed = true;
+                break;
+            }
+            ready.push(s);
+        }
+        ready.close();
+    });
+
+    thread writeThread([&] {
+        Slot *s;
+        while (done.pop(s)) {
+            if (!failed) {
+                output.putRows(s->band.out, stride, stride, s->band.rows());
+                if (!output.ok) failed = true;
+            }
+            freeSlots.push(s);
+        }
+    });
+
+    Slot *s;
+    while (ready.pop(s)) {
+        if (!failed) compute(s->band);
+        done.push(s);
+    }
+    done.close();
+    writeThread.join();
+    readThread.join();
+
+    if (readFailed) {
+        cerr << in << ": arquivo truncado" << endl;
+        return false;
+    }
+    if (!output.close(opt.sync) || failed) {
+        cerr << "Erro ao gravar " << out << endl;
+        return false;
+    }
+    return true;
+}
+
+// Cadeia de filtros pontuais aplicada faixa a faixa.
+inline bool streamPipeline(const string &in, const string &out, const FilterPipeline &pipeline,
+                           FilterExecutor &exec, PPMStreamOptions opt = PPMStreamOptions()) {
+    opt.halo = 0;
+    return streamPPM(in, out, opt, [&](StreamBand &b) {
+        pipeline.apply(exec, b.in, (size_t)b.rows() * b.width);
+    });
+}
+
+// Filtro de vizinhança faixa a faixa. As linhas que o filtro recebe em
+// FilterTile são relativas ao início do halo da faixa, não à imagem.
+inline bool streamNeighborhood(const string &in, const string &out, FilterExecutor &exec, int halo,
+                               const NeighborhoodKernel &fn, PPMStreamOptions opt = PPMStreamOptions()) {
+    opt.halo = halo;
+    return streamPPM(in, out, opt, [&](StreamBand &b) {
+        int rows = b.haloTop + b.rows() + b.haloBottom;
+        exec.runNeighborhood(b.in, b.stride, b.out, b.stride, b.width, rows, 3, halo, fn,
+                             b.haloTop, b.haloTop + b.rows());
+    });
+}
+
+// Cadeia com filtros de vizinhança faixa a faixa: a faixa é lida com a
+// soma dos halos da cadeia e filtrada inteira, como se fosse uma imagem.
+// As linhas perto das pontas da faixa saem erradas (a vizinhança foi
+// replicada), mas nunca mais do que o halo total, e só o miolo é gravado.
+// Ajustes automáticos (equalização, níveis, CLAHE) não dá para fazer assim:
+// cada faixa seria corrigida pelas próprias estatísticas.
+inline bool streamChain(const string &in, const string &out, const FilterChain &chain,
+                        FilterExecutor &exec, PPMStreamOptions opt = PPMStreamOptions()) {
+    if (chain.wholeImage()) {
+        cerr << in << ": ajustes automáticos precisam da imagem inteira na memória" << endl;
+        return false;
+    }
+    opt.halo = chain.halo();
+    if (!chain.inPlace() && opt.halo == 0) opt.halo = 1;       // só para ter o segundo buffer
+    return streamPPM(in, out, opt, [&](StreamBand &b) {
+        int rows = b.haloTop + b.rows() + b.haloBottom;
+        unsigned char *result = chain.apply(exec, b.in, b.out, b.width, rows);
+        b.out = result + (size_t)b.haloTop * b.stride;
+    });
+}
+
+#endif /* StreamProcessor_h */
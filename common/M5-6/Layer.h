@@ -1,7 +1,16 @@
+class StreamedTexture;
+
 typedef struct Layer {
 		float z;
 		unsigned int tid;
 		char * filename;
 		float offsetx, offsety, ratex, ratey;
+
+		// camadas paginadas (ver StreamedTexture.h): tid passa a ser o atlas
+		// de páginas residentes e pageTableTid a tabela de indireção
+		// página virtual -> slot; viewx é a fração da largura visível na tela
+		StreamedTexture * stream;
+		unsigned int pageTableTid;
+		float viewx;
 	
-} Layer;
\ No newline at end of file
+} Layer;
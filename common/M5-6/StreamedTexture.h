@@ -0,0 +1,378 @@
+//
+//  StreamedTexture.h
+//
+//  Textura virtual paginada para camadas de parallax muito largas (panoramas
+//  com dezenas de milhares de pixels), que não cabem em uma única textura nem
+//  no orçamento de memória.
+//
+//  A imagem é dividida em páginas de tamanho fixo, gravadas em um arquivo de
+//  páginas (ver bakeStreamedTexture). Em tempo de execução só as páginas
+//  próximas da janela visível ficam residentes em uma textura-cache (atlas de
+//  slots); uma tabela de indireção (página virtual -> slot) diz ao shader onde
+//  cada página está. Uma thread de fundo lê as páginas do disco, priorizando
+//  as visíveis e depois as seguintes no sentido da rolagem.
+//
+
+#ifndef StreamedTexture_h
+#define StreamedTexture_h
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#ifdef _WIN32
+#define ST_FSEEK _fseeki64
+#else
+#define ST_FSEEK fseeko
+#endif
+
+using namespace std;
+
+// Cabeçalho do arquivo de páginas. Depois dele vêm pagesX * pagesY páginas,
+// linha a linha, cada uma com (pageSize + 2*border)^2 texels RGBA8. A borda
+// replica os vizinhos (com repetição horizontal, como GL_REPEAT) para que a
+// filtragem bilinear não vaze entre slots do atlas.
+struct StreamedTextureHeader {
+    char magic[4];
+    int32_t width, height;
+    int32_t pageSize, border;
+    int32_t pagesX, pagesY;
+};
+
+// Converte uma imagem comum (PNG, JPG...) para o arquivo de páginas. A
+// decodificação via stb_image precisa da imagem inteira em memória; para
+// panoramas que nem isso comportam, o arquivo pode ser gerado por um
+// ladrilhador externo seguindo o mesmo formato.
+inline bool bakeStreamedTexture(const char *imageFile, const char *pagesFile, int pageSize = 256, int border = 1) {
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(imageFile, &width, &height, &nrChannels, 4);
+    if (!data) {
+        cout << "Failed to load texture " << imageFile << endl;
+        return false;
+    }
+    FILE *out = fopen(pagesFile, "wb");
+    if (!out) {
+        stbi_image_free(data);
+        return false;
+    }
+
+    StreamedTextureHeader hdr;
+    memcpy(hdr.magic, "VTX1", 4);
+    hdr.width = width;
+    hdr.height = height;
+    hdr.pageSize = pageSize;
+    hdr.border = border;
+    hdr.pagesX = (width + pageSize - 1) / pageSize;
+    hdr.pagesY = (height + pageSize - 1) / pageSize;
+    fwrite(&hdr, sizeof(hdr), 1, out);
+
+    int slot = pageSize + 2 * border;
+    vector<unsigned char> page(slot * slot * 4);
+    for (int py = 0; py < hdr.pagesY; py++) {
+        for (int px = 0; px < hdr.pagesX; px++) {
+            for (int y = 0; y < slot; y++) {
+                int sy = py * pageSize + y - border;
+                sy = sy < 0 ? 0 : (sy >= height ? height - 1 : sy);
+                for (int x = 0; x < slot; x++) {
+                    int sx = (px * pageSize + x - border) % width;
+                    if (sx < 0) sx += width;
+                    memcpy(&page[(y * slot + x) * 4], &data[((size_t)sy * width + sx) * 4], 4);
+                }
+            }
+            fwrite(page.data(), 1, page.size(), out);
+        }
+    }
+    fclose(out);
+    stbi_image_free(data);
+    return true;
+}
+
+class StreamedTexture {
+    // estado de carga de cada página virtual (protegido por mtx)
+    enum { PAGE_IDLE = 0, PAGE_QUEUED, PAGE_LOADING };
+
+    struct LoadedPage {
+        int page;
+        vector<unsigned char> pixels;
+    };
+
+    StreamedTextureHeader hdr;
+    FILE *file;
+    int slotSize;              // pageSize + 2*border
+    int slotsX, slotsY;
+    unsigned int cacheTid;     // atlas com as páginas residentes
+    unsigned int tableTid;     // indireção: (slotX, slotY, residente, -) por página
+
+    vector<unsigned char> table;
+    bool tableDirty;
+    vector<int> pageSlot;      // slot ocupado pela página, ou -1
+    vector<int> slotPage;      // página guardada no slot, ou -1
+    vector<unsigned int> slotLastUse;
+    unsigned int frame;
+
+    // comunicação com a thread de leitura
+    thread worker;
+    mutex mtx;
+    condition_variable cv;
+    bool stopping;
+    deque<int> queue;
+    vector<unsigned char> state;
+    vector<LoadedPage> ready;
+    vector<vector<unsigned char> > freeBuffers;
+
+    void loaderLoop() {
+        size_t pageBytes = (size_t)slotSize * slotSize * 4;
+        for (;;) {
+            int page;
+            vector<unsigned char> buffer;
+            {
+                unique_lock<mutex> lock(mtx);
+                cv.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (stopping) return;
+                page = queue.front();
+                queue.pop_front();
+                state[page] = PAGE_LOADING;
+                if (!freeBuffers.empty()) {
+                    buffer.swap(freeBuffers.back());
+                    freeBuffers.pop_back();
+                }
+            }
+            buffer.resize(pageBytes);
+            ST_FSEEK(file, (int64_t)sizeof(hdr) + (int64_t)page * pageBytes, SEEK_SET);
+            if (fread(buffer.data(), 1, pageBytes, file) != pageBytes) {
+                memset(buffer.data(), 0, pageBytes);
+            }
+            lock_guard<mutex> lock(mtx);
+            ready.push_back(LoadedPage());
+            ready.back().page = page;
+            ready.back().pixels.swap(buffer);
+        }
+    }
+
+    // Acrescenta a 'wanted' as páginas que cobrem [x0, x1) x [y0, y1) em
+    // pixels virtuais. Em x a imagem se repete, então o intervalo é dobrado
+    // para dentro de [0, width).
+    void collectPages(double x0, double x1, double y0, double y1, vector<int> &wanted) {
+        int ps = hdr.pageSize;
+        int r0 = (int)floor(y0 / ps);
+        int r1 = (int)floor((y1 - 1e-3) / ps);
+        r0 = r0 < 0 ? 0 : r0;
+        r1 = r1 >= hdr.pagesY ? hdr.pagesY - 1 : r1;
+
+        double intervals[2][2];
+        int count = 1;
+        if (x1 - x0 >= hdr.width) {
+            intervals[0][0] = 0;
+            intervals[0][1] = hdr.width;
+        } else {
+            double a = fmod(x0, (double)hdr.width);
+            if (a < 0) a += hdr.width;
+            double b = a + (x1 - x0);
+            intervals[0][0] = a;
+            intervals[0][1] = b < hdr.width ? b : hdr.width;
+            if (b > hdr.width) {
+                intervals[1][0] = 0;
+                intervals[1][1] = b - hdr.width;
+                count = 2;
+            }
+        }
+        for (int i = 0; i < count; i++) {
+            int c0 = (int)floor(intervals[i][0] / ps);
+            int c1 = (int)floor((intervals[i][1] - 1e-3) / ps);
+            c1 = c1 >= hdr.pagesX ? hdr.pagesX - 1 : c1;
+            for (int c = c0; c <= c1; c++) {
+                for (int r = r0; r <= r1; r++) {
+                    wanted.push_back(r * hdr.pagesX + c);
+                }
+            }
+        }
+    }
+
+    // slot livre ou o menos recentemente usado que não esteja em uso neste quadro
+    int findSlot() {
+        int best = -1;
+        for (int s = 0; s < (int)slotPage.size(); s++) {
+            if (slotPage[s] < 0) return s;
+            if (slotLastUse[s] < frame && (best < 0 || slotLastUse[s] < slotLastUse[best])) {
+                best = s;
+            }
+        }
+        return best;
+    }
+
+    void setTableEntry(int page, int slot) {
+        unsigned char *e = &table[page * 4];
+        e[0] = slot < 0 ? 0 : slot % slotsX;
+        e[1] = slot < 0 ? 0 : slot / slotsX;
+        e[2] = slot < 0 ? 0 : 1;
+        e[3] = 0;
+        tableDirty = true;
+    }
+
+public:
+    // páginas além da janela visível carregadas no sentido da rolagem
+    int prefetchPages;
+    // limite de envios à GPU por quadro, para não causar engasgos
+    int maxUploadsPerFrame;
+
+    StreamedTexture() : file(NULL), cacheTid(0), tableTid(0), tableDirty(false), frame(0),
+                        stopping(false), prefetchPages(2), maxUploadsPerFrame(4) {}
+
+    ~StreamedTexture() {
+        if (worker.joinable()) {
+            {
+                lock_guard<mutex> lock(mtx);
+                stopping = true;
+            }
+            cv.notify_all();
+            worker.join();
+        }
+        if (file) fclose(file);
+        if (cacheTid) glDeleteTextures(1, &cacheTid);
+        if (tableTid) glDeleteTextures(1, &tableTid);
+    }
+
+    // Abre o arquivo de páginas e cria o atlas com cacheSlotsX x cacheSlotsY
+    // páginas residentes. O atlas precisa comportar a janela visível mais a
+    // pré-busca; páginas sem slot aparecem transparentes.
+    bool open(const char *pagesFile, int cacheSlotsX, int cacheSlotsY) {
+        file = fopen(pagesFile, "rb");
+        if (!file) return false;
+        if (fread(&hdr, sizeof(hdr), 1, file) != 1 || memcmp(hdr.magic, "VTX1", 4) != 0) {
+            cout << "Invalid page file " << pagesFile << endl;
+            fclose(file);
+            file = NULL;
+            return false;
+        }
+        slotSize = hdr.pageSize + 2 * hdr.border;
+        slotsX = cacheSlotsX;
+        slotsY = cacheSlotsY;
+
+        int pages = hdr.pagesX * hdr.pagesY;
+        table.assign(pages * 4, 0);
+        pageSlot.assign(pages, -1);
+        state.assign(pages, PAGE_IDLE);
+        slotPage.assign(slotsX * slotsY, -1);
+        slotLastUse.assign(slotsX * slotsY, 0);
+
+        glGenTextures(1, &cacheTid);
+        glBindTexture(GL_TEXTURE_2D, cacheTid);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, slotsX * slotSize, slotsY * slotSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+        // texturas inteiras exigem GL_NEAREST
+        glGenTextures(1, &tableTid);
+        glBindTexture(GL_TEXTURE_2D, tableTid);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8UI, hdr.pagesX, hdr.pagesY, 0, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, table.data());
+
+        worker = thread(&StreamedTexture::loaderLoop, this);
+        return true;
+    }
+
+    // Chamado uma vez por quadro com a janela visível em coordenadas de
+    // textura normalizadas (u pode passar de 1, a imagem se repete em x) e a
+    // velocidade de rolagem, cujo sinal orienta a pré-busca.
+    void update(float u0, float u1, float v0, float v1, float direction) {
+        frame++;
+        double x0 = (double)u0 * hdr.width, x1 = (double)u1 * hdr.width;
+        double y0 = (double)v0 * hdr.height, y1 = (double)v1 * hdr.height;
+        double ahead = (double)prefetchPages * hdr.pageSize;
+
+        // visíveis primeiro, depois a pré-busca em ordem de distância
+        vector<int> wanted;
+        collectPages(x0, x1, y0, y1, wanted);
+        if (direction >= 0) {
+            collectPages(x1, x1 + ahead, y0, y1, wanted);
+        } else {
+            collectPages(x0 - ahead, x0, y0, y1, wanted);
+        }
+        for (size_t i = 0; i < wanted.size(); i++) {
+            int s = pageSlot[wanted[i]];
+            if (s >= 0) slotLastUse[s] = frame;
+        }
+
+        vector<LoadedPage> arrived;
+        bool wake;
+        {
+            lock_guard<mutex> lock(mtx);
+            for (size_t i = 0; i < queue.size(); i++) {
+                state[queue[i]] = PAGE_IDLE;
+            }
+            queue.clear();
+            for (size_t i = 0; i < wanted.size(); i++) {
+                int p = wanted[i];
+                if (pageSlot[p] < 0 && state[p] == PAGE_IDLE) {
+                    state[p] = PAGE_QUEUED;
+                    queue.push_back(p);
+                }
+            }
+            int n = (int)ready.size() < maxUploadsPerFrame ? (int)ready.size() : maxUploadsPerFrame;
+            for (int i = 0; i < n; i++) {
+                arrived.push_back(LoadedPage());
+                arrived.back().page = ready[i].page;
+                arrived.back().pixels.swap(ready[i].pixels);
+                state[ready[i].page] = PAGE_IDLE;
+            }
+            ready.erase(ready.begin(), ready.begin() + n);
+            wake = !queue.empty();
+        }
+        if (wake) cv.notify_one();
+
+        if (!arrived.empty()) {
+            glBindTexture(GL_TEXTURE_2D, cacheTid);
+            for (size_t i = 0; i < arrived.size(); i++) {
+                int page = arrived[i].page;
+                int slot = pageSlot[page] < 0 ? findSlot() : -1;
+                if (slot >= 0) {
+                    if (slotPage[slot] >= 0) {
+                        pageSlot[slotPage[slot]] = -1;
+                        setTableEntry(slotPage[slot], -1);
+                    }
+                    glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % slotsX) * slotSize, (slot / slotsX) * slotSize,
+                                    slotSize, slotSize, GL_RGBA, GL_UNSIGNED_BYTE, arrived[i].pixels.data());
+                    slotPage[slot] = page;
+                    slotLastUse[slot] = frame;
+                    pageSlot[page] = slot;
+                    setTableEntry(page, slot);
+                }
+            }
+            lock_guard<mutex> lock(mtx);
+            for (size_t i = 0; i < arrived.size(); i++) {
+                freeBuffers.push_back(vector<unsigned char>());
+                freeBuffers.back().swap(arrived[i].pixels);
+            }
+        }
+
+        if (tableDirty) {
+            glBindTexture(GL_TEXTURE_2D, tableTid);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, hdr.pagesX, hdr.pagesY, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, table.data());
+            tableDirty = false;
+        }
+    }
+
+    unsigned int getCacheTexture() { return cacheTid; }
+    unsigned int getPageTableTexture() { return tableTid; }
+    int getWidth() { return hdr.width; }
+    int getHeight() { return hdr.height; }
+    int getPageSize() { return hdr.pageSize; }
+    int getBorder() { return hdr.border; }
+};
+
+#endif /* StreamedTexture_h */
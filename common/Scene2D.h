@@ -0,0 +1,248 @@
+//
+//  Scene2D.h
+//
+//  Formato binário das cenas dos editores de triângulos (Ex1Parte3M2, Ex2):
+//
+//      cabeçalho (Scene2DHeader, 48 bytes)
+//      vértices: 3 Batch2DVertex por triângulo, já no layout do VBO
+//      atributos por triângulo: Scene2DShape (cor exata e marcações)
+//
+//  As seções começam em múltiplos de 16 bytes. A gravação junta cabeçalho,
+//  vértices e atributos em uma única chamada writev, sem copiar nada para
+//  um buffer intermediário. A leitura mapeia o arquivo (mmap) e só confere
+//  o cabeçalho e os tamanhos: os vértices são entregues como estão, prontos
+//  para glBufferData ou Batch2DBuffer::assign, sem conversão nenhuma.
+//
+//  O arquivo usa a ordem de bytes da máquina que gravou; o cabeçalho tem
+//  um marcador para recusar arquivos de máquinas com a ordem contrária.
+//
+
+#ifndef Scene2D_h
+#define Scene2D_h
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <errno.h>
+#endif
+
+#include "Batch2D.h"
+
+using namespace std;
+
+const uint32_t SCENE2D_VERSION = 1;
+const uint32_t SCENE2D_BYTE_ORDER = 0x01020304;
+
+struct Scene2DHeader {
+    char magic[4];                  // "TRI2"
+    uint32_t version;
+    uint32_t byteOrder;             // SCENE2D_BYTE_ORDER na ordem de quem gravou
+    uint32_t vertexSize;            // sizeof(Batch2DVertex)
+    uint32_t shapeSize;             // sizeof(Scene2DShape)
+    uint32_t reserved;
+    uint64_t shapes;                // triângulos
+    uint64_t vertexOffset;          // início dos vértices, em bytes
+    uint64_t shapeOffset;           // início dos atributos, em bytes
+};
+
+// Atributos de um triângulo que o VBO não guarda com precisão total
+struct Scene2DShape {
+    float r, g, b;
+    uint32_t flags;                 // SCENE2D_SELECTED...
+};
+
+const uint32_t SCENE2D_SELECTED = 1;
+
+inline uint64_t scene2DAlign(uint64_t n) {
+    return (n + 15) & ~(uint64_t)15;
+}
+
+// Grava 'count' triângulos: 3 * count vértices e count atributos. Falso
+// (com a mensagem em cerr) se o arquivo não puder ser criado ou gravado
+inline bool writeScene2D(const string &file, const Batch2DVertex *vertices, const Scene2DShape *shapes, size_t count) {
+    Scene2DHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "TRI2", 4);
+    header.version = SCENE2D_VERSION;
+    header.byteOrder = SCENE2D_BYTE_ORDER;
+    header.vertexSize = sizeof(Batch2DVertex);
+    header.shapeSize = sizeof(Scene2DShape);
+    header.shapes = count;
+    size_t vertexBytes = 3 * count * sizeof(Batch2DVertex), shapeBytes = count * sizeof(Scene2DShape);
+    header.vertexOffset = scene2DAlign(sizeof(Scene2DHeader));
+    header.shapeOffset = scene2DAlign(header.vertexOffset + vertexBytes);
+
+    // o cabeçalho e os preenchimentos de alinhamento saem de um bloco de zeros
+    static const char zeros[16] = { 0 };
+    const char *parts[5] = { (const char *)&header, zeros, (const char *)vertices, zeros, (const char *)shapes };
+    size_t lengths[5] = { sizeof(header), (size_t)(header.vertexOffset - sizeof(header)), vertexBytes,
+                          (size_t)(header.shapeOffset - header.vertexOffset - vertexBytes), shapeBytes };
+
+    bool ok = true;
+#ifndef _WIN32
+    int fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        cerr << "Erro ao criar " << file << endl;
+        return false;
+    }
+    struct iovec iov[5];
+    int n = 0;
+    for (int i = 0; i < 5; i++) {
+        if (lengths[i] == 0) continue;
+        iov[n].iov_base = (void *)parts[i];
+        iov[n].iov_len = lengths[i];
+        n++;
+    }
+    // uma chamada grava tudo; se ela for parcial, continua de onde parou
+    for (int i = 0; i < n && ok;) {
+        ssize_t r = writev(fd, iov + i, n - i);
+        if (r < 0 && errno == EINTR) continue;     // sinal antes de gravar algo
+        if (r < 0) {
+            ok = false;
+            break;
+        }
+        size_t done = r;
+        while (i < n && done >= iov[i].iov_len) done -= iov[i++].iov_len;
+        if (i < n) {
+            iov[i].iov_base = (char *)iov[i].iov_base + done;
+            iov[i].iov_len -= done;
+        }
+    }
+    if (::close(fd) != 0) ok = false;
+#else
+    FILE *fp = fopen(file.c_str(), "wb");
+    if (!fp) {
+        cerr << "Erro ao criar " << file << endl;
+        return false;
+    }
+    for (int i = 0; i < 5 && ok; i++) {
+        if (lengths[i] > 0) ok = fwrite(parts[i], 1, lengths[i], fp) == lengths[i];
+    }
+    if (fclose(fp) != 0) ok = false;
+#endif
+    if (!ok) cerr << "Erro ao gravar " << file << endl;
+    return ok;
+}
+
+// Cena lida de um arquivo: mapeado quando possível, senão lido inteiro.
+// Os ponteiros valem enquanto o objeto existir
+class Scene2DFile {
+    const char *begin;
+    size_t length;
+    void *map;
+    vector<char> storage;
+    Scene2DHeader header;
+
+    void release() {
+#ifndef _WIN32
+        if (map) munmap(map, length);
+#endif
+        map = NULL;
+        begin = NULL;
+        length = 0;
+        vector<char>().swap(storage);
+        memset(&header, 0, sizeof(header));
+    }
+
+    bool bytes(const string &file) {
+#ifndef _WIN32
+        int fd = ::open(file.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (m != MAP_FAILED) {
+                madvise(m, st.st_size, MADV_SEQUENTIAL);
+                map = m;
+                length = st.st_size;
+                begin = (const char *)m;
+                ::close(fd);
+                return true;
+            }
+        }
+        ::close(fd);
+#endif
+        FILE *f = fopen(file.c_str(), "rb");
+        if (!f) return false;
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        storage.resize(size > 0 ? size : 0);
+        length = fread(storage.data(), 1, storage.size(), f);
+        fclose(f);
+        begin = storage.data();
+        return true;
+    }
+
+public:
+    Scene2DFile() : begin(NULL), length(0), map(NULL) {
+        memset(&header, 0, sizeof(header));
+    }
+
+    ~Scene2DFile() {
+        release();
+    }
+
+    Scene2DFile(const Scene2DFile &) = delete;
+    Scene2DFile &operator=(const Scene2DFile &) = delete;
+
+    // Falso (com a mensagem em cerr) se o arquivo não existe, não é uma
+    // cena, é de outra versão ou ordem de bytes, ou está truncado
+    bool load(const string &file) {
+        release();
+        if (!bytes(file)) {
+            cerr << "Erro ao abrir " << file << endl;
+            return false;
+        }
+        if (length < sizeof(Scene2DHeader)) {
+            cerr << file << ": não é uma cena" << endl;
+            release();
+            return false;
+        }
+        memcpy(&header, begin, sizeof(header));
+        const char *problem = NULL;
+        if (memcmp(header.magic, "TRI2", 4) != 0) {
+            problem = "não é uma cena";
+        } else if (header.byteOrder != SCENE2D_BYTE_ORDER) {
+            problem = "gravada com outra ordem de bytes";
+        } else if (header.version != SCENE2D_VERSION || header.vertexSize != sizeof(Batch2DVertex) ||
+                   header.shapeSize != sizeof(Scene2DShape)) {
+            problem = "versão do formato diferente";
+        } else if (header.shapes > (length / sizeof(Batch2DVertex)) / 3 ||
+                   header.vertexOffset % 16 || header.shapeOffset % 16 ||
+                   header.vertexOffset > length || 3 * header.shapes * sizeof(Batch2DVertex) > length - header.vertexOffset ||
+                   header.shapeOffset > length || header.shapes * sizeof(Scene2DShape) > length - header.shapeOffset) {
+            problem = "arquivo truncado";
+        }
+        if (problem) {
+            cerr << file << ": " << problem << endl;
+            release();
+            return false;
+        }
+        return true;
+    }
+
+    size_t size() const {
+        return header.shapes;
+    }
+
+    const Batch2DVertex *vertices() const {
+        return (const Batch2DVertex *)(begin + header.vertexOffset);
+    }
+
+    const Scene2DShape *shapes() const {
+        return (const Scene2DShape *)(begin + header.shapeOffset);
+    }
+};
+
+#endif /* Scene2D_h */
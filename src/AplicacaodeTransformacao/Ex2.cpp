@@ -20,41 +20,38 @@ using namespace glm;
 
 #include <cmath>
 
+// Desenho em lote: shader e buffer de vértices compartilhados pelos exercícios
+#include "Batch2D.h"
+
+// Seleção por ponto: hierarquia de caixas dos triângulos
+#include "Bvh2D.h"
+
+// Cena em arquivo binário: S grava, L carrega
+#include "Scene2D.h"
+
 // Protótipo da função de callback de teclado
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode);
 void mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
+void cursor_position_callback(GLFWwindow *window, double xpos, double ypos);
 
-// Protótipos das funções
-GLuint createTriangle(float x0, float y0, float x1, float y1, float x2, float y2);
-int setupShader();
-int setupGeometry();
 
 // Dimensões da janela (pode ser alterado em tempo de execução)
 const GLuint WIDTH = 800, HEIGHT = 600;
 
-// Código fonte do Vertex Shader (em GLSL): ainda hardcoded
-const GLchar *vertexShaderSource = R"(
-#version 400
-layout (location = 0) in vec3 position;
-uniform mat4 projection;
-uniform mat4 model;
-void main()	
-{
-	//...pode ter mais linhas de código aqui!
-	gl_Position = projection * model * vec4(position.x, position.y, position.z, 1.0);
-}
-)";
-
-// Código fonte do Fragment Shader (em GLSL): ainda hardcoded
-const GLchar *fragmentShaderSource = R"(
-#version 400
-uniform vec4 inputColor;
-out vec4 color;
-void main()
-{
-	color = inputColor;
-}
-)";
+vector<vec2> triangleVertices; // de 3 em 3
+vector<vec3> triangleColors;   // uma por triângulo
+
+// Arrasto com o botão esquerdo e destaque do triângulo sob o cursor; o id
+// na BVH é o índice do triângulo (vértices 3 * id em diante)
+Bvh2D bvh;
+int hovered = -1, dragged = -1;
+vec2 lastCursor;
+
+vec2 toNDC(double xpos, double ypos);
+
+const char *SCENE_FILE = "cena_ex2.tri";
+void saveScene();
+void loadScene();
 
 int main()
 {
@@ -85,6 +82,7 @@ int main()
     // Registra os callbacks
     glfwSetKeyCallback(window, key_callback);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetCursorPosCallback(window, cursor_position_callback);
 
     // Inicializa GLAD
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
@@ -96,13 +94,11 @@ int main()
     // Viewport inicial
     glViewport(0, 0, WIDTH, HEIGHT);
 
-    // Compila shaders
-    GLuint shaderProgram = setupShader();
-
-    // Cria triângulo
-    GLuint triangleVAO = createTriangle(-0.5f, -0.5f, 0.5f, -0.5f, 0.0f, 0.5f);
+    // Shader e buffer de vértices do lote
+    Batch2D batch;
+    if (!batch.init())
+        return -1;
 
-    vector<GLuint> triangleVAOs;
     int numTriangles = 5;
     float spacing = 1.6f / (numTriangles - 1); // Espaçamento proporcional em X
     float baseX = -0.8f;                       // Ponto de partida à esquerda
@@ -113,48 +109,37 @@ int main()
     {
         float offsetX = baseX + i * spacing;
 
-        triangleVAOs.push_back(createTriangle(
-            offsetX - size / 2.0f, baseY, // vértice esquerdo
-            offsetX + size / 2.0f, baseY, // vértice direito
-            offsetX, baseY + size         // vértice superior
-            ));
+        triangleVertices.push_back(vec2(offsetX - size / 2.0f, baseY)); // vértice esquerdo
+        triangleVertices.push_back(vec2(offsetX + size / 2.0f, baseY)); // vértice direito
+        triangleVertices.push_back(vec2(offsetX, baseY + size));        // vértice superior
+        triangleColors.push_back(vec3(0.2f, 0.8f, 0.4f));
+        bvh.add(triangleVertices[3 * i], triangleVertices[3 * i + 1], triangleVertices[3 * i + 2]);
     }
+    bvh.build();
 
     // Loop principal
     while (!glfwWindowShouldClose(window))
     {
         // Processa eventos
         glfwPollEvents();
+        bvh.update();
 
         // Limpa a tela
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        // Usa o shader
-        glUseProgram(shaderProgram);
+        // Projeção identidade: coordenadas normalizadas, sem transformação
+        batch.begin(mat4(1.0f));
 
-        // Define a cor uniformemente
-        GLint colorLoc = glGetUniformLocation(shaderProgram, "inputColor");
-        glUniform4f(colorLoc, 0.2f, 0.8f, 0.4f, 1.0f); // Verde
-
-        // Define matrizes de modelo e projeção como identidade
-        GLint modelLoc = glGetUniformLocation(shaderProgram, "model");
-        GLint projLoc = glGetUniformLocation(shaderProgram, "projection");
-
-        mat4 model = mat4(1.0f);
-        mat4 projection = mat4(1.0f);
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, value_ptr(model));
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, value_ptr(projection));
-
-        // Renderiza o triângulo
-        // Renderiza os 5 triângulos
-        for (GLuint vao : triangleVAOs)
+        // Renderiza os triângulos (mais claros sob o cursor) com uma chamada de desenho
+        for (size_t i = 0; i + 2 < triangleVertices.size(); i += 3)
         {
-            glBindVertexArray(vao);
-            glDrawArrays(GL_TRIANGLES, 0, 3);
+            vec3 color = triangleColors[i / 3];
+            if ((int)i / 3 == hovered)
+                color = color * 0.5f + vec3(0.5f);
+            batch.triangle(triangleVertices[i], triangleVertices[i + 1], triangleVertices[i + 2], vec4(color, 1.0f));
         }
-
-        glBindVertexArray(0);
+        batch.end();
 
         // Troca os buffers
         glfwSwapBuffers(window);
@@ -169,177 +154,89 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 {
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, GL_TRUE);
+    if (key == GLFW_KEY_S && action == GLFW_PRESS)
+        saveScene();
+    if (key == GLFW_KEY_L && action == GLFW_PRESS)
+        loadScene();
 }
 
-int setupShader()
+
+void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
 {
-    // Vertex shader
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-    // Checando erros de compilação (exibição via log no terminal)
-    GLint success;
-    GLchar infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"
-                  << infoLog << std::endl;
-    }
-    // Fragment shader
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-    // Checando erros de compilação (exibição via log no terminal)
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n"
-                  << infoLog << std::endl;
-    }
-    // Linkando os shaders e criando o identificador do programa de shader
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    // Checando por erros de linkagem
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success)
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
     {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
-                  << infoLog << std::endl;
+        double xpos, ypos;
+        glfwGetCursorPos(window, &xpos, &ypos);
+        lastCursor = toNDC(xpos, ypos);
+        dragged = bvh.pick(lastCursor);
     }
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    return shaderProgram;
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE)
+        dragged = -1;
 }
 
-int setupGeometry()
+void cursor_position_callback(GLFWwindow *window, double xpos, double ypos)
 {
-    // Aqui setamos as coordenadas x, y e z do triângulo e as armazenamos de forma
-    // sequencial, já visando mandar para o VBO (Vertex Buffer Objects)
-    // Cada atributo do vértice (coordenada, cores, coordenadas de textura, normal, etc)
-    // Pode ser arazenado em um VBO único ou em VBOs separados
-    GLfloat vertices[] = {
-        // x    y    z
-        // T0
-        -0.5, -0.5, 0.0, // v0
-        0.5, -0.5, 0.0,  // v1
-        0.0, 0.5, 0.0,   // v2
-    };
-
-    GLuint VBO, VAO;
-    // Geração do identificador do VBO
-    glGenBuffers(1, &VBO);
-    // Faz a conexão (vincula) do buffer como um buffer de array
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    // Envia os dados do array de floats para o buffer da OpenGl
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    // Geração do identificador do VAO (Vertex Array Object)
-    glGenVertexArrays(1, &VAO);
-    // Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de vértices
-    // e os ponteiros para os atributos
-    glBindVertexArray(VAO);
-    // Para cada atributo do vertice, criamos um "AttribPointer" (ponteiro para o atributo), indicando:
-    //  Localização no shader * (a localização dos atributos devem ser correspondentes no layout especificado no vertex shader)
-    //  Numero de valores que o atributo tem (por ex, 3 coordenadas xyz)
-    //  Tipo do dado
-    //  Se está normalizado (entre zero e um)
-    //  Tamanho em bytes
-    //  Deslocamento a partir do byte zero
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid *)0);
-    glEnableVertexAttribArray(0);
-
-    // Observe que isso é permitido, a chamada para glVertexAttribPointer registrou o VBO como o objeto de buffer de vértice
-    // atualmente vinculado - para que depois possamos desvincular com segurança
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    // Desvincula o VAO (é uma boa prática desvincular qualquer buffer ou array para evitar bugs medonhos)
-    glBindVertexArray(0);
-
-    return VAO;
+    vec2 cursor = toNDC(xpos, ypos);
+    if (dragged >= 0)
+    {
+        // move o triângulo e só reajusta as caixas acima dele na BVH
+        vec2 *v = &triangleVertices[3 * dragged];
+        for (int i = 0; i < 3; i++)
+            v[i] = v[i] + (cursor - lastCursor);
+        bvh.set(dragged, v[0], v[1], v[2]);
+    }
+    hovered = bvh.pick(cursor);
+    lastCursor = cursor;
 }
 
-GLuint createTriangle(float x0, float y0, float x1, float y1, float x2, float y2)
+// Pixels da janela (origem em cima) para coordenadas normalizadas
+vec2 toNDC(double xpos, double ypos)
 {
-    GLuint VAO;
-
-    GLfloat vertices[] = {
-        x0,
-        y0,
-        0.0f,
-        x1,
-        y1,
-        0.0f,
-        x2,
-        y2,
-        0.0f,
-    };
-
-    GLuint VBO;
-    glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO); // Vincula novamente para garantir
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid *)0);
-    glEnableVertexAttribArray(0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-
-    return VAO;
+    return vec2(2.0f * (float)xpos / WIDTH - 1.0f, 1.0f - 2.0f * (float)ypos / HEIGHT);
 }
 
-GLuint createTriangleVAO()
+// Os vértices vão no layout do VBO do lote, a cor exata nos atributos
+void saveScene()
 {
-    GLuint VAO, VBO;
-    GLfloat vertices[] = {
-        // x, y
-        -0.1f, -0.1f,
-        0.1f, -0.1f,
-        0.0f, 0.1f};
-
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-
-    return VAO;
+    size_t count = triangleColors.size();
+    vector<Batch2DVertex> vertices(3 * count);
+    vector<Scene2DShape> shapes(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t packed = batch2DColor(vec4(triangleColors[i], 1.0f));
+        for (int j = 0; j < 3; j++)
+        {
+            Batch2DVertex v = { triangleVertices[3 * i + j].x, triangleVertices[3 * i + j].y, 0, 0, packed };
+            vertices[3 * i + j] = v;
+        }
+        shapes[i].r = triangleColors[i].r;
+        shapes[i].g = triangleColors[i].g;
+        shapes[i].b = triangleColors[i].b;
+        shapes[i].flags = 0;
+    }
+    if (writeScene2D(SCENE_FILE, vertices.data(), shapes.data(), count))
+        cout << "Cena gravada em " << SCENE_FILE << ": " << count << " triangulos" << endl;
 }
 
-void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
+void loadScene()
 {
-    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+    Scene2DFile scene;
+    if (!scene.load(SCENE_FILE))
+        return;
+
+    size_t count = scene.size();
+    const Batch2DVertex *v = scene.vertices();
+    triangleVertices.resize(3 * count);
+    triangleColors.resize(count);
+    bvh.clear();
+    for (size_t i = 0; i < count; i++)
     {
-        double xpos, ypos;
-        glfwGetCursorPos(window, &xpos, &ypos);
-        // cout << xpos << "  " << ypos << endl;
-
-        /*Triangle tri;
-        tri.position = vec3(xpos,ypos,0.0);
-        tri.dimensions = vec3(100.0,100.0,1.0);
-
-        tri.color = vec3(colors[iColor].r, colors[iColor].g, colors[iColor].b);
-        iColor = (iColor + 1) % colors.size();
-        triangles.push_back(tri);
-        */
+        for (int j = 0; j < 3; j++)
+            triangleVertices[3 * i + j] = vec2(v[3 * i + j].x, v[3 * i + j].y);
+        triangleColors[i] = vec3(scene.shapes()[i].r, scene.shapes()[i].g, scene.shapes()[i].b);
+        bvh.add(triangleVertices[3 * i], triangleVertices[3 * i + 1], triangleVertices[3 * i + 2]);
     }
-}
\ No newline at end of file
+    bvh.build();
+    hovered = dragged = -1;
+    cout << "Cena carregada de " << SCENE_FILE << ": " << count << " triangulos" << endl;
+}
@@ -20,55 +20,45 @@ using namespace glm;
 
 #include <cmath>
 
+// Desenho em lote: shader e buffer de vértices compartilhados pelos exercícios
+#include "Batch2D.h"
+
+// Desenho instanciado: posição, dimensões, rotação e cor por triângulo
+#include "Instanced2D.h"
+
+#include <stdlib.h>
+
 // Protótipo da função de callback de teclado
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode);
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 
-// Protótipos das funções
-GLuint createTriangle(float x0, float y0, float x1, float y1, float x2, float y2);
-int setupShader();
-int setupGeometry();
 
 // Dimensões da janela (pode ser alterado em tempo de execução)
 const GLuint WIDTH = 800, HEIGHT = 600;
 
-// Código fonte do Vertex Shader (em GLSL): ainda hardcoded
-const GLchar *vertexShaderSource = R"(
-#version 400
-layout (location = 0) in vec3 position;
-uniform mat4 projection;
-uniform mat4 model;
-void main()	
-{
-	//...pode ter mais linhas de código aqui!
-	gl_Position = projection * model * vec4(position.x, position.y, position.z, 1.0);
-}
-)";
-
-// Código fonte do Fragment Shader (em GLSL): ainda hardcoded
-const GLchar *fragmentShaderSource = R"(
-#version 400
-uniform vec4 inputColor;
-out vec4 color;
-void main()
-{
-	color = inputColor;
-}
-)";
-
 struct Triangle 
 {
 	vec3 position;
 	vec3 dimensions;
 	vec3 color;
+	float rotation; // graus
+	float spin;		// radianos por segundo
 };
 
 vector<Triangle> triangles;
 
+// Modo instanciado (padrão): uma instância compacta por triângulo, montada
+// no vertex shader; a tecla I alterna com o lote, que monta as matrizes na CPU
+Instanced2D instances;
+bool instanced = true;
+
+Instance2D toInstance(const Triangle &tri);
+void spawnTriangles(int count);
+
 vector <vec3> colors;
 int iColor = 0;
 
-int main()
+int main(int argc, char **argv)
 {
 	// Inicialização da GLFW
 	glfwInit();
@@ -133,31 +123,30 @@ int main()
 	glfwGetFramebufferSize(window, &width, &height);
 	glViewport(0, 0, width, height);
 
-	// Compilando e buildando o programa de shader
-	GLuint shaderID = setupShader();
-
-	
-	GLuint VAO = createTriangle(-0.5,-0.5,0.5,-0.5,0.0,0.5);
+	// O lote compila o shader e cria o buffer dos vértices
+	Batch2D batch;
+	if (!batch.init() || !instances.init())
+		return -1;
 	
 	Triangle tri;
 	tri.position = vec3(400.0,300.0,0.0);
 	tri.dimensions = vec3(100.0,100.0,1.0);
 	tri.color = vec3(colors[iColor].r, colors[iColor].g, colors[iColor].b);
 	iColor = (iColor + 1) % colors.size();
+	tri.rotation = 180.0f;
+	tri.spin = 0.0f;
 	triangles.push_back(tri);
+	instances.add(toInstance(tri));
 
-
-	glUseProgram(shaderID);
-
-	// Enviando a cor desejada (vec4) para o fragment shader
-	// Utilizamos a variáveis do tipo uniform em GLSL para armazenar esse tipo de info
-	// que não está nos buffers
-	GLint colorLoc = glGetUniformLocation(shaderID, "inputColor");
+	// Teste de carga: N triângulos girando, com o tempo por quadro no console
+	int spawned = argc > 1 ? atoi(argv[1]) : 0;
+	spawnTriangles(spawned);
+	double lastReport = glfwGetTime();
+	int frames = 0;
 
 	// Matriz de projeção paralela ortográfica
 	// mat4 projection = ortho(-10.0, 10.0, -10.0, 10.0, -1.0, 1.0);
 	mat4 projection = ortho(0.0, 800.0, 600.0, 0.0, -1.0, 1.0);
-	glUniformMatrix4fv(glGetUniformLocation(shaderID, "projection"), 1, GL_FALSE, value_ptr(projection));
 
 	// Loop da aplicação - "game loop"
 	while (!glfwWindowShouldClose(window))
@@ -172,35 +161,49 @@ int main()
 		glLineWidth(10);
 		glPointSize(20);
 
-		glBindVertexArray(VAO); // Conectando ao buffer de geometria
-
-		for (int i = 0; i < triangles.size(); i++)
+		float time = (float)glfwGetTime();
+		if (instanced)
 		{
-			// Matriz de modelo: transformações na geometria (objeto)
-			mat4 model = mat4(1); // matriz identidade
-			// Translação
-			model = translate(model,vec3(triangles[i].position.x,triangles[i].position.y,0.0));
-
-			model = rotate(model,radians(180.0f),vec3(0.0,0.0,1.0));
-			// Escala
-			model = scale(model,vec3(triangles[i].dimensions.x,triangles[i].dimensions.y,1.0));
-			glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
-
-			glUniform4f(colorLoc, triangles[i].color.r, triangles[i].color.g, triangles[i].color.b, 1.0f); // enviando cor para variável uniform inputColor
-			// Chamada de desenho - drawcall
-			// Poligono Preenchido - GL_TRIANGLES
-			glDrawArrays(GL_TRIANGLES, 0, 3);
+			// Uma chamada instanciada; só as instâncias novas são enviadas
+			instances.draw(projection, time);
+		}
+		else
+		{
+			batch.begin(projection);
+
+			for (int i = 0; i < triangles.size(); i++)
+			{
+				// Matriz de modelo: transformações na geometria (objeto)
+				mat4 model = mat4(1); // matriz identidade
+				// Translação
+				model = translate(model,vec3(triangles[i].position.x,triangles[i].position.y,0.0));
+
+				model = rotate(model,radians(triangles[i].rotation) + triangles[i].spin * time,vec3(0.0,0.0,1.0));
+				// Escala
+				model = scale(model,vec3(triangles[i].dimensions.x,triangles[i].dimensions.y,1.0));
+				batch.setTransform(model);
+
+				// Poligono Preenchido: vai para o lote, aplicada a matriz de modelo
+				batch.triangle(vec2(-0.5, -0.5), vec2(0.5, -0.5), vec2(0.0, 0.5), vec4(triangles[i].color, 1.0f));
+			}
+			// Desenho com contorno (linhas)
+			// batch.line(vec2(-0.5, -0.5), vec2(0.5, -0.5), vec4(1.0f, 0.0f, 1.0f, 1.0f));
+
+			// Desenho só dos pontos (vértices)
+			// batch.point(vec2(0.0, 0.5), vec4(1.0f, 1.0f, 0.0f, 1.0f));
+
+			// Chamada de desenho - drawcall: uma para todos os triângulos
+			batch.end();
 		}
-		// Desenho com contorno (linhas)
-		// glUniform4f(colorLoc, 1.0f, 0.0f, 1.0f, 1.0f); //enviando cor para variável uniform inputColor
-		// glDrawArrays(GL_LINE_LOOP, 0, 3); //Desenha T0
-		// glDrawArrays(GL_LINE_LOOP, 3, 3); //Desenha T1
-
-		// Desenho só dos pontos (vértices)
-		// glUniform4f(colorLoc, 1.0f, 1.0f, 0.0f, 1.0f); //enviando cor para variável uniform inputColor
-		// glDrawArrays(GL_POINTS, 0, 6);
 
-		glBindVertexArray(0); // Desconectando o buffer de geometria
+		frames++;
+		if (spawned > 0 && time - lastReport >= 1.0)
+		{
+			cout << triangles.size() << " triangulos, " << (instanced ? "instanciado" : "lote") << ": "
+				 << 1000.0 * (time - lastReport) / frames << " ms/quadro" << endl;
+			lastReport = time;
+			frames = 0;
+		}
 
 		// Troca os buffers da tela
 		glfwSwapBuffers(window);
@@ -216,146 +219,13 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 {
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, GL_TRUE);
-}
-
-int setupShader()
-{
-	// Vertex shader
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-	glCompileShader(vertexShader);
-	// Checando erros de compilação (exibição via log no terminal)
-	GLint success;
-	GLchar infoLog[512];
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-	if (!success)
+	if (key == GLFW_KEY_I && action == GLFW_PRESS)
 	{
-		glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"
-				  << infoLog << std::endl;
+		instanced = !instanced;
+		cout << "Modo " << (instanced ? "instanciado" : "lote") << endl;
 	}
-	// Fragment shader
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-	glCompileShader(fragmentShader);
-	// Checando erros de compilação (exibição via log no terminal)
-	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-	if (!success)
-	{
-		glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n"
-				  << infoLog << std::endl;
-	}
-	// Linkando os shaders e criando o identificador do programa de shader
-	GLuint shaderProgram = glCreateProgram();
-	glAttachShader(shaderProgram, vertexShader);
-	glAttachShader(shaderProgram, fragmentShader);
-	glLinkProgram(shaderProgram);
-	// Checando por erros de linkagem
-	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-	if (!success)
-	{
-		glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
-				  << infoLog << std::endl;
-	}
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
-
-	return shaderProgram;
 }
 
-int setupGeometry()
-{
-	// Aqui setamos as coordenadas x, y e z do triângulo e as armazenamos de forma
-	// sequencial, já visando mandar para o VBO (Vertex Buffer Objects)
-	// Cada atributo do vértice (coordenada, cores, coordenadas de textura, normal, etc)
-	// Pode ser arazenado em um VBO único ou em VBOs separados
-	GLfloat vertices[] = {
-		// x    y    z
-		// T0
-		-0.5, -0.5, 0.0, // v0
-		0.5, -0.5, 0.0,	 // v1
-		0.0, 0.5, 0.0,	 // v2
-	};
-
-	GLuint VBO, VAO;
-	// Geração do identificador do VBO
-	glGenBuffers(1, &VBO);
-	// Faz a conexão (vincula) do buffer como um buffer de array
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	// Envia os dados do array de floats para o buffer da OpenGl
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-	// Geração do identificador do VAO (Vertex Array Object)
-	glGenVertexArrays(1, &VAO);
-	// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de vértices
-	// e os ponteiros para os atributos
-	glBindVertexArray(VAO);
-	// Para cada atributo do vertice, criamos um "AttribPointer" (ponteiro para o atributo), indicando:
-	//  Localização no shader * (a localização dos atributos devem ser correspondentes no layout especificado no vertex shader)
-	//  Numero de valores que o atributo tem (por ex, 3 coordenadas xyz)
-	//  Tipo do dado
-	//  Se está normalizado (entre zero e um)
-	//  Tamanho em bytes
-	//  Deslocamento a partir do byte zero
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid *)0);
-	glEnableVertexAttribArray(0);
-
-	// Observe que isso é permitido, a chamada para glVertexAttribPointer registrou o VBO como o objeto de buffer de vértice
-	// atualmente vinculado - para que depois possamos desvincular com segurança
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	// Desvincula o VAO (é uma boa prática desvincular qualquer buffer ou array para evitar bugs medonhos)
-	glBindVertexArray(0);
-
-	return VAO;
-}
-
-GLuint createTriangle(float x0, float y0, float x1, float y1, float x2, float y2)
-{
-	GLuint VAO;
-
-	GLfloat vertices[] = {
-		// x    y    z
-		// T0
-		x0, y0, 0.0, // v0
-		x1, y1, 0.0, // v1
-		x2, y2, 0.0, // v2
-	};
-
-	GLuint VBO;
-	// Geração do identificador do VBO
-	glGenBuffers(1, &VBO);
-	// Faz a conexão (vincula) do buffer como um buffer de array
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	// Envia os dados do array de floats para o buffer da OpenGl
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-	// Geração do identificador do VAO (Vertex Array Object)
-	glGenVertexArrays(1, &VAO);
-	// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de vértices
-	// e os ponteiros para os atributos
-	glBindVertexArray(VAO);
-	// Para cada atributo do vertice, criamos um "AttribPointer" (ponteiro para o atributo), indicando:
-	//  Localização no shader * (a localização dos atributos devem ser correspondentes no layout especificado no vertex shader)
-	//  Numero de valores que o atributo tem (por ex, 3 coordenadas xyz)
-	//  Tipo do dado
-	//  Se está normalizado (entre zero e um)
-	//  Tamanho em bytes
-	//  Deslocamento a partir do byte zero
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid *)0);
-	glEnableVertexAttribArray(0);
-
-	// Observe que isso é permitido, a chamada para glVertexAttribPointer registrou o VBO como o objeto de buffer de vértice
-	// atualmente vinculado - para que depois possamos desvincular com segurança
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	// Desvincula o VAO (é uma boa prática desvincular qualquer buffer ou array para evitar bugs medonhos)
-	glBindVertexArray(0);
-
-	return VAO;
-}
 
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 {
@@ -371,7 +241,43 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 
 		tri.color = vec3(colors[iColor].r, colors[iColor].g, colors[iColor].b);
 		iColor = (iColor + 1) % colors.size();
+		tri.rotation = 180.0f;
+		tri.spin = 0.0f;
 		triangles.push_back(tri);
+		instances.add(toInstance(tri));
 		
 	}
-}
\ No newline at end of file
+}
+
+Instance2D toInstance(const Triangle &tri)
+{
+	return instance2D(vec2(tri.position.x, tri.position.y), vec2(tri.dimensions.x, tri.dimensions.y), tri.rotation, vec4(tri.color, 1.0f), tri.spin);
+}
+
+// Espalha 'count' triângulos pequenos pela janela, cada um girando com
+// velocidade própria; no modo instanciado o giro não custa envio nenhum
+void spawnTriangles(int count)
+{
+	if (count <= 0)
+		return;
+	triangles.reserve(triangles.size() + count);
+	instances.reserve(instances.size() + count);
+	unsigned seed = 2024;
+	for (int i = 0; i < count; i++)
+	{
+		seed = seed * 1103515245u + 12345u;
+		float x = (float)((seed >> 8) % WIDTH);
+		seed = seed * 1103515245u + 12345u;
+		float y = (float)((seed >> 8) % HEIGHT);
+		seed = seed * 1103515245u + 12345u;
+
+		Triangle tri;
+		tri.position = vec3(x, y, 0.0);
+		tri.dimensions = vec3(8.0, 8.0, 1.0);
+		tri.color = colors[i % colors.size()];
+		tri.rotation = (float)(seed % 360);
+		tri.spin = ((float)((seed >> 9) % 2000) / 1000.0f - 1.0f) * 3.0f;
+		triangles.push_back(tri);
+		instances.add(toInstance(tri));
+	}
+}
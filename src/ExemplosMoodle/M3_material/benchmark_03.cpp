@@ -0,0 +1,830 @@
+// Medições de desempenho das rotinas de imagem do exemplo_03.
+//
+// Uso: benchmark_03 [megapixels] [diretório temporário]
+// Gera imagens sintéticas do tamanho pedido (padrão 12 MP) e mede cada
+// etapa, comparando com a implementação original quando ela existe.
+
+#include <iostream>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <filesystem>
+#include <math.h>
+
+#include "PPM.h"
+#include "ImageFilters.h"
+#include "FilterExecutor.h"
+#include "FilterPipeline.h"
+#include "StreamProcessor.h"
+#include "ChromaKey.h"
+#include "Convolution.h"
+#include "Histogram.h"
+#include "Image.h"
+#include "Resample.h"
+#include "SequenceProcessor.h"
+#include "FilterChain.h"
+#include "GLFilters.h"
+
+using namespace std;
+
+double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void report(const char *name, double seconds, size_t pixels, size_t bytes) {
+    printf("  %-28s %8.2f ms %10.1f MP/s %10.1f MB/s\n", name, seconds * 1000.0,
+           pixels / seconds / 1e6, bytes / seconds / 1e6);
+}
+
+// imagem RGB sintética, com gradiente e ruído para não ser trivial
+vector<unsigned char> makeImage(int w, int h) {
+    vector<unsigned char> data((size_t)w * h * 3);
+    unsigned seed = 12345;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            seed = seed * 1103515245u + 12345u;
+            unsigned char *p = &data[((size_t)y * w + x) * 3];
+            p[0] = (unsigned char)(x * 255 / w);
+            p[1] = (unsigned char)(y * 255 / h);
+            p[2] = (unsigned char)(seed >> 24);
+        }
+    }
+    return data;
+}
+
+// grava 'rgb' como P5/P6/P3, convertendo para cinza ou 16 bits se pedido
+void writeRaw(const string &file, const char *magic, int w, int h, int channels, int maxval,
+              const vector<unsigned char> &rgb) {
+    PPMImage img;
+    img.allocate(w, h, channels, maxval);
+    size_t n = (size_t)w * h;
+    for (size_t i = 0; i < n; i++) {
+        for (int c = 0; c < channels; c++) {
+            unsigned v = rgb[i * 3 + c];
+            if (maxval > 255) {
+                img.data16()[i * channels + c] = v * 257;
+            } else {
+                img.data()[i * channels + c] = v;
+            }
+        }
+    }
+    PPMWriteOptions opt;
+    opt.binary = magic[1] != '3';
+    opt.comment = "benchmark";
+    writePPM(file, img, opt);
+}
+
+// leitura P3 original do exemplo_03 (ifstream >> por canal)
+unsigned char *legacyOpenP3(const string &file, int &w, int &h) {
+    ifstream arq(file);
+    string magic;
+    char BUFFER[1024];
+    arq >> magic;
+    arq.getline(BUFFER, 1024);
+    arq.getline(BUFFER, 1024);
+    int maxValue;
+    arq >> w >> h >> maxValue;
+    unsigned char *data = new unsigned char[(size_t)w * h * 3];
+    size_t n = (size_t)w * h * 3;
+    for (size_t j = 0; j < n; j++) {
+        int g;
+        arq >> g;
+        data[j] = (unsigned char)g;
+    }
+    return data;
+}
+
+// gravação P3 original do exemplo_03 (endl a cada amostra)
+void legacySave(const string &file, const unsigned char *data, int w, int h) {
+    ofstream arq(file);
+    arq << "P3" << endl;
+    arq << "#Gerado por chroma-key." << endl;
+    arq << w << " " << h << endl << "255" << endl;
+    size_t length = (size_t)w * h * 3;
+    for (size_t i = 0; i < length; i++) {
+        arq << (int)data[i] << endl;
+    }
+    arq.close();
+}
+
+// filtros originais do exemplo_03, sem as perguntas ao usuário
+void legacyChromaKey(unsigned char *data, int w, int h, int r, int g, int b, double t) {
+    double dmax = 441.6729559301;
+    int length = w * h * 3;
+    for (int i = 0; i < length; i += 3) {
+        double dr = data[i] - r, dg = data[i + 1] - g, db = data[i + 2] - b;
+        double d = sqrt(dr * dr + dg * dg + db * db);
+        if (d / dmax < t) {
+            data[i] = data[i + 1] = data[i + 2] = 0;
+        }
+    }
+}
+
+void legacyGrayScale(unsigned char *data, int w, int h) {
+    double rw = 0.2125, gw = 0.7154, bw = 0.0721;
+    int length = w * h * 3;
+    for (int i = 0; i < length; i += 3) {
+        data[i] = data[i + 1] = data[i + 2] = (int)(data[i] * rw + data[i + 1] * gw + data[i + 2] * bw);
+    }
+}
+
+void legacyColorize(unsigned char *data, int w, int h, int r, int g, int b) {
+    int length = w * h * 3;
+    for (int i = 0; i < length; i += 3) {
+        data[i] = data[i] | r;
+        data[i + 1] = data[i + 1] | g;
+        data[i + 2] = data[i + 2] | b;
+    }
+}
+
+void legacyNegative(unsigned char *data, int w, int h) {
+    int length = w * h * 3;
+    for (int i = 0; i < length; i += 3) {
+        data[i] = data[i] ^ 255;
+        data[i + 1] = data[i + 1] ^ 255;
+        data[i + 2] = data[i + 2] ^ 255;
+    }
+}
+
+size_t fileSize(const string &file) {
+    ifstream in(file, ios::binary | ios::ate);
+    return (size_t)in.tellg();
+}
+
+unsigned checksum(const unsigned char *data, size_t n) {
+    unsigned s = 0;
+    for (size_t i = 0; i < n; i++) s += data[i];
+    return s;
+}
+
+void benchRead(const string &dir, int w, int h, const vector<unsigned char> &rgb) {
+    printf("Leitura PPM/PGM (%d x %d)\n", w, h);
+    size_t pixels = (size_t)w * h;
+    const char *magics[] = {"P6", "P5", "P6", "P3"};
+    const int maxvals[] = {255, 255, 65535, 255};
+    const char *names[] = {"P6 8 bits (mmap)", "P5 8 bits (mmap)", "P6 16 bits", "P3 from_chars"};
+    for (int i = 0; i < 4; i++) {
+        string file = dir + "/bench_" + to_string(i) + ".ppm";
+        int channels = magics[i][1] == '5' ? 1 : 3;
+        writeRaw(file, magics[i], w, h, channels, maxvals[i], rgb);
+
+        double t0 = now();
+        PPMImage img;
+        if (!readPPM(file, img)) return;
+        // toca todos os bytes para contar as faltas de página do mapeamento
+        volatile unsigned s = checksum(img.data(), img.sampleCount() * img.bytesPerSample());
+        (void)s;
+        double t1 = now();
+        report(names[i], t1 - t0, pixels, fileSize(file));
+
+        if (magics[i][1] == '3') {
+            int lw, lh;
+            t0 = now();
+            unsigned char *legacy = legacyOpenP3(file, lw, lh);
+            t1 = now();
+            report("P3 original (ifstream >>)", t1 - t0, pixels, fileSize(file));
+            delete[] legacy;
+        }
+        remove(file.c_str());
+    }
+}
+
+void benchWrite(const string &dir, int w, int h, const vector<unsigned char> &rgb) {
+    printf("Escrita PPM (%d x %d)\n", w, h);
+    size_t pixels = (size_t)w * h;
+    string file = dir + "/bench_out.ppm";
+    PPMRowView view = ppmView(rgb.data(), w, h);
+    PPMWriteOptions opt;
+
+    double t0 = now();
+    writePPM(file, view, opt);
+    report("P6", now() - t0, pixels, fileSize(file));
+
+    opt.sync = true;
+    t0 = now();
+    writePPM(file, view, opt);
+    report("P6 + fsync", now() - t0, pixels, fileSize(file));
+    opt.sync = false;
+
+    // metade esquerda da imagem: linhas não contíguas, gravadas com writev
+    PPMRowView half = ppmView(rgb.data(), w / 2, h, 3, 255, (size_t)w * 3);
+    t0 = now();
+    writePPM(file, half, opt);
+    report("P6 recorte com stride", now() - t0, pixels / 2, fileSize(file));
+
+    PPMImage wide;
+    wide.allocate(w, h, 3, 65535);
+    for (size_t i = 0; i < pixels * 3; i++) wide.data16()[i] = rgb[i] * 257;
+    t0 = now();
+    writePPM(file, wide, opt);
+    report("P6 16 bits", now() - t0, pixels, fileSize(file));
+
+    opt.binary = false;
+    t0 = now();
+    writePPM(file, view, opt);
+    report("P3", now() - t0, pixels, fileSize(file));
+
+    // a versão original é lenta demais para a imagem inteira: usa 1 MP
+    int lh = (int)(1e6 / w) < h ? (int)(1e6 / w) : h;
+    t0 = now();
+    legacySave(file, rgb.data(), w, lh);
+    report("P3 original (endl)", now() - t0, (size_t)w * lh, fileSize(file));
+    remove(file.c_str());
+}
+
+// Cada filtro roda sobre uma cópia nova da imagem; o tempo da cópia não
+// entra na medida.
+void benchFilters(int w, int h, const vector<unsigned char> &rgb) {
+    printf("Filtros pontuais (%d x %d)\n", w, h);
+    size_t pixels = (size_t)w * h;
+    vector<unsigned char> work;
+    const char *filters[] = {"chroma-key", "tons de cinza", "colorizar", "negativo"};
+    SimdLevel best = g_simdLevel;
+
+    for (int f = 0; f < 4; f++) {
+        work = rgb;
+        double t0 = now();
+        switch (f) {
+            case 0: legacyChromaKey(work.data(), w, h, 0, 255, 0, 0.4); break;
+            case 1: legacyGrayScale(work.data(), w, h); break;
+            case 2: legacyColorize(work.data(), w, h, 40, 0, 90); break;
+            case 3: legacyNegative(work.data(), w, h); break;
+        }
+        string name = string(filters[f]) + " original";
+        report(name.c_str(), now() - t0, pixels, pixels * 3);
+
+        for (int level = SIMD_SCALAR; level <= best; level++) {
+            g_simdLevel = (SimdLevel)level;
+            work = rgb;
+            t0 = now();
+            switch (f) {
+                case 0: chromaKeyRGB8(work.data(), pixels, 0, 255, 0, 0.4); break;
+                case 1: grayScaleRGB8(work.data(), pixels, true); break;
+                case 2: colorizeRGB8(work.data(), pixels, 40, 0, 90); break;
+                case 3: negativeRGB8(work.data(), pixels); break;
+            }
+            name = string(filters[f]) + " " + simdLevelName((SimdLevel)level);
+            report(name.c_str(), now() - t0, pixels, pixels * 3);
+        }
+    }
+    g_simdLevel = best;
+}
+
+// média 3x3 simples, só para exercitar o caminho de vizinhança
+void box3(const FilterTile &t, const unsigned char *const *src, unsigned char *const *dst, int width) {
+    for (int r = 0; r < t.y1 - t.y0; r++) {
+        for (int x = t.x0; x < t.x1; x++) {
+            int xl = x > 0 ? x - 1 : 0;
+            int xr = x + 1 < width ? x + 1 : width - 1;
+            for (int c = 0; c < 3; c++) {
+                int sum = 0;
+                for (int dy = -1; dy <= 1; dy++) {
+                    sum += src[r + dy][xl * 3 + c] + src[r + dy][x * 3 + c] + src[r + dy][xr * 3 + c];
+                }
+                dst[r][x * 3 + c] = (unsigned char)(sum / 9);
+            }
+        }
+    }
+}
+
+// Escala com o número de threads; o checksum tem que ser o mesmo em todas.
+void benchExecutor(int w, int h, const vector<unsigned char> &rgb) {
+    printf("Execução paralela em ladrilhos (%d x %d)\n", w, h);
+    size_t pixels = (size_t)w * h;
+    int maxThreads = (int)thread::hardware_concurrency();
+    vector<int> counts;
+    for (int n = 1; n < maxThreads; n *= 2) counts.push_back(n);
+    counts.push_back(maxThreads > 0 ? maxThreads : 1);
+    vector<unsigned char> work, out(rgb.size());
+    unsigned refGray = 0, refBox = 0;
+
+    for (size_t i = 0; i < counts.size(); i++) {
+        int n = counts[i];
+        FilterExecutor exec(n);
+        work = rgb;
+        double t0 = now();
+        exec.run(work.data(), pixels, 3, [](unsigned char *p, size_t k) {
+            grayScaleRGB8(p, k, true);
+        });
+        double t1 = now();
+        unsigned sum = checksum(work.data(), work.size());
+        if (i == 0) refGray = sum;
+        string name = "tons de cinza " + to_string(n) + (sum == refGray ? " thr" : " thr DIVERGE");
+        report(name.c_str(), t1 - t0, pixels, pixels * 3);
+
+        t0 = now();
+        exec.runNeighborhood(rgb.data(), (size_t)w * 3, out.data(), (size_t)w * 3, w, h, 3, 1,
+                             [w](const FilterTile &t, const unsigned char *const *src, unsigned char *const *dst) {
+                                 box3(t, src, dst, w);
+                             });
+        t1 = now();
+        sum = checksum(out.data(), out.size());
+        if (i == 0) refBox = sum;
+        name = "média 3x3 " + to_string(n) + (sum == refBox ? " thr" : " thr DIVERGE");
+        report(name.c_str(), t1 - t0, pixels, pixels * 3);
+    }
+}
+
+// Cadeia de 6 filtros: um filtro por passada (como aplicar um de cada vez
+// no exemplo_03) contra a cadeia fundida. A cópia simples da imagem dá a
+// referência de banda de memória.
+void benchPipeline(int w, int h, const vector<unsigned char> &rgb) {
+    printf("Cadeia de filtros fundida (%d x %d)\n", w, h);
+    size_t pixels = (size_t)w * h;
+    FilterExecutor exec;
+    FilterPipeline chain;
+    chain.chromaKey(0, 255, 0, 0.4).grayScale().colorize(40, 0, 90).brightness(10).contrast(1.2).gamma(1.8);
+
+    vector<unsigned char> work = rgb, copy(rgb.size());
+    double t0 = now();
+    exec.run(work.data(), pixels, 3, [&](unsigned char *p, size_t n) {
+        memcpy(copy.data() + (p - work.data()), p, n * 3);
+    });
+    report("cópia (referência)", now() - t0, pixels, pixels * 3);
+
+    t0 = now();
+    FilterPipeline single[6];
+    single[0].chromaKey(0, 255, 0, 0.4);
+    single[1].grayScale();
+    single[2].colorize(40, 0, 90);
+    single[3].brightness(10);
+    single[4].contrast(1.2);
+    single[5].gamma(1.8);
+    for (int i = 0; i < 6; i++) single[i].apply(exec, work.data(), pixels);
+    report("6 passadas", now() - t0, pixels, pixels * 3);
+    unsigned separate = checksum(work.data(), work.size());
+
+    work = rgb;
+    t0 = now();
+    chain.apply(exec, work.data(), pixels);
+    string name = "fundida (" + to_string(chain.stageCount()) + " etapas)" +
+                  (checksum(work.data(), work.size()) == separate ? "" : " DIVERGE");
+    report(name.c_str(), now() - t0, pixels, pixels * 3);
+}
+
+// gaussiano 2D direto, como seria sem separar as passadas (referência)
+void naiveGaussian(const unsigned char *src, unsigned char *dst, int w, int h, double sigma) {
+    int r = (int)ceil(3.0 * sigma);
+    vector<double> k(2 * r + 1);
+    double total = 0;
+    for (int i = -r; i <= r; i++) total += k[i + r] = exp(-(i * i) / (2.0 * sigma * sigma));
+    for (int i = 0; i <= 2 * r; i++) k[i] /= total;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            for (int c = 0; c < 3; c++) {
+                double sum = 0;
+                for (int dy = -r; dy <= r; dy++) {
+                    int yy = y + dy < 0 ? 0 : (y + dy >= h ? h - 1 : y + dy);
+                    for (int dx = -r; dx <= r; dx++) {
+                        int xx = x + dx < 0 ? 0 : (x + dx >= w ? w - 1 : x + dx);
+                        sum += k[dy + r] * k[dx + r] * src[((size_t)yy * w + xx) * 3 + c];
+                    }
+                }
+                dst[((size_t)y * w + x) * 3 + c] = (unsigned char)(sum + 0.5);
+            }
+        }
+    }
+}
+
+// Filtros de vizinhança. O 2D direto roda só em 1 MP, senão demora demais.
+void benchConvolution(int w, int h, const vector<unsigned char> &rgb) {
+    printf("Filtros de vizinhança (%d x %d)\n", w, h);
+    size_t pixels = (size_t)w * h;
+    vector<unsigned char> out(rgb.size());
+    FilterExecutor exec;
+
+    int nh = (int)(1e6 / w) < h ? (int)(1e6 / w) : h;
+    double t0 = now();
+    naiveGaussian(rgb.data(), out.data(), w, nh, 2.0);
+    report("gaussiano 2D direto s=2", now() - t0, (size_t)w * nh, (size_t)w * nh * 3);
+
+    SimdLevel saved = g_simdLevel;
+    SimdLevel levels[] = {SIMD_SCALAR, SIMD_SSE, SIMD_AVX2};
+    for (int i = 0; i < 3 && levels[i] <= saved; i++) {
+        g_simdLevel = levels[i];
+        t0 = now();
+        applyNeighborhood(exec, gaussianBlurFilter(w, 2.0), rgb.data(), out.data(), w, h);
+        string name = string("gaussiano separável ") + simdLevelName(levels[i]);
+        report(name.c_str(), now() - t0, pixels, pixels * 3);
+    }
+    g_simdLevel = saved;
+
+    t0 = now();
+    applyNeighborhood(exec, gaussianBlurFilter(w, 8.0), rgb.data(), out.data(), w, h);
+    report("gaussiano separável s=8", now() - t0, pixels, pixels * 3);
+
+    // somas acumuladas: o tempo não deve crescer com o raio
+    int radii[] = {2, 10, 50};
+    for (int i = 0; i < 3; i++) {
+        t0 = now();
+        applyNeighborhood(exec, boxBlurFilter(w, radii[i]), rgb.data(), out.data(), w, h);
+        string name = "caixa r=" + to_string(radii[i]);
+        report(name.c_str(), now() - t0, pixels, pixels * 3);
+    }
+
+    t0 = now();
+    applyNeighborhood(exec, unsharpMaskFilter(w, 1.5, 1.0), rgb.data(), out.data(), w, h);
+    report("nitidez s=1.5", now() - t0, pixels, pixels * 3);
+
+    t0 = now();
+    applyNeighborhood(exec, sobelFilter(w), rgb.data(), out.data(), w, h);
+    report("Sobel", now() - t0, pixels, pixels * 3);
+}
+
+// Conversões do Image.h: a versão genérica (pixel a pixel, decidida pelos
+// tipos) contra a sobrecarga SIMD do mesmo par de formatos.
+template <class FA, class LA, class FB, class LB>
+void benchConvert(const char *name, const Image<FA, LA> &src, Image<FB, LB> &dst) {
+    size_t pixels = (size_t)src.width() * src.height();
+    size_t bytes = pixels * (FA::channels * sizeof(typename FA::Sample) + FB::channels * sizeof(typename FB::Sample));
+    double t0 = now();
+    convertImage<FA, LA, FB, LB>(src.view(), dst.view());
+    string label = string(name) + " genérica";
+    report(label.c_str(), now() - t0, pixels, bytes);
+    unsigned generic = checksum((const unsigned char *)dst.data(), dst.sampleCount() * sizeof(typename FB::Sample));
+
+    t0 = now();
+    convertImage(src.view(), dst.view());
+    double elapsed = now() - t0;
+    bool same = checksum((const unsigned char *)dst.data(), dst.sampleCount() * sizeof(typename FB::Sample)) == generic;
+    label = string(name) + (same ? " SIMD" : " SIMD DIVERGE");
+    report(label.c_str(), elapsed, pixels, bytes);
+}
+
+void benchImage(int w, int h, const vector<unsigned char> &rgb) {
+    printf("Conversões de formato e layout (%d x %d)\n", w, h);
+    Image<RGB8> src(w, h), back(w, h);
+    memcpy(src.data(), rgb.data(), rgb.size());
+    Image<RGB8, Planar> planar(w, h);
+    Image<RGBF, Planar> planarF(w, h);
+    Image<RGB16> wide(w, h);
+    Image<RGBA8> rgba(w, h);
+
+    benchConvert("RGB8 -> planar", src, planar);
+    benchConvert("planar -> RGB8", planar, back);
+    benchConvert("RGB8 -> float planar", src, planarF);
+    benchConvert("float planar -> RGB8", planarF, back);
+    benchConvert("RGB8 -> RGB16", src, wide);
+    benchConvert("RGB16 -> RGB8", wide, back);
+    benchConvert("RGB8 -> RGBA8", src, rgba);
+    benchConvert("RGBA8 -> RGB8", rgba, back);
+
+    // o mesmo filtro nos dois layouts
+    size_t pixels = (size_t)w * h;
+    double t0 = now();
+    grayScale(planar.view());
+    report("tons de cinza planar", now() - t0, pixels, pixels * 3);
+    t0 = now();
+    grayScale(src.view());
+    report("tons de cinza intercalado", now() - t0, pixels, pixels * 3);
+}
+
+// Redimensionamento direto, sem separar os eixos: para cada pixel de saída
+// o núcleo é avaliado de novo e a soma percorre a janela 2D inteira.
+void naiveResample(const unsigned char *src, int sw, int sh, unsigned char *dst, int dw, int dh, ResampleFilter f) {
+    double sx = (double)sw / dw, sy = (double)sh / dh;
+    double fx = sx > 1 ? sx : 1, fy = sy > 1 ? sy : 1;
+    double rx = resampleSupport(f) * fx, ry = resampleSupport(f) * fy;
+    for (int y = 0; y < dh; y++) {
+        double cy = (y + 0.5) * sy;
+        int y0 = (int)floor(cy - ry + 0.5), y1 = (int)floor(cy + ry + 0.5);
+        y0 = y0 < 0 ? 0 : y0;
+        y1 = y1 > sh ? sh : y1;
+        for (int x = 0; x < dw; x++) {
+            double cx = (x + 0.5) * sx;
+            int x0 = (int)floor(cx - rx + 0.5), x1 = (int)floor(cx + rx + 0.5);
+            x0 = x0 < 0 ? 0 : x0;
+            x1 = x1 > sw ? sw : x1;
+            double sum[3] = { 0, 0, 0 }, total = 0;
+            for (int j = y0; j < y1; j++) {
+                double wy = resampleKernel(f, (j + 0.5 - cy) / fy);
+                for (int i = x0; i < x1; i++) {
+                    double w = wy * resampleKernel(f, (i + 0.5 - cx) / fx);
+                    const unsigned char *p = src + ((size_t)j * sw + i) * 3;
+                    for (int c = 0; c < 3; c++) sum[c] += p[c] * w;
+                    total += w;
+                }
+            }
+            for (int c = 0; c < 3; c++) {
+                double v = total != 0 ? sum[c] / total : 0;
+                dst[((size_t)y * dw + x) * 3 + c] = (unsigned char)(v < 0 ? 0 : (v > 255 ? 255 : v + 0.5));
+            }
+        }
+    }
+}
+
+// Redução pela metade (e miniatura de 1/8) contra a versão direta; as
+// versões SIMD têm que dar o mesmo checksum que a escalar.
+void benchResample(int w, int h, const vector<unsigned char> &rgb) {
+    printf("Redimensionamento (%d x %d -> %d x %d)\n", w, h, w / 2, h / 2);
+    size_t pixels = (size_t)w * h;
+    FilterExecutor exec;
+    Image<RGB8> src(w, h), half(w / 2, h / 2);
+    memcpy(src.data(), rgb.data(), rgb.size());
+    SimdLevel best = g_simdLevel;
+
+    double t0 = now();
+    naiveResample(src.data(), w, h, half.data(), w / 2, h / 2, RESAMPLE_BICUBIC);
+    report("bicúbico direto", now() - t0, pixels, pixels * 3);
+
+    for (int f = RESAMPLE_BILINEAR; f <= RESAMPLE_LANCZOS; f++) {
+        unsigned reference = 0;
+        for (int level = SIMD_SCALAR; level <= best; level++) {
+            g_simdLevel = (SimdLevel)level;
+            t0 = now();
+            resample(exec, src.view(), half.view(), (ResampleFilter)f);
+            double elapsed = now() - t0;
+            unsigned sum = checksum(half.data(), half.sampleCount());
+            if (level == SIMD_SCALAR) reference = sum;
+            string name = string(resampleFilterName((ResampleFilter)f)) + " " + simdLevelName((SimdLevel)level) +
+                          (sum == reference ? "" : " DIVERGE");
+            report(name.c_str(), elapsed, pixels, pixels * 3);
+        }
+    }
+    g_simdLevel = best;
+
+    Image<RGB8> thumb(w / 8, h / 8);
+    t0 = now();
+    resample(exec, src.view(), thumb.view(), RESAMPLE_LANCZOS);
+    report("miniatura 1/8 Lanczos", now() - t0, pixels, pixels * 3);
+
+    Image<RGBF, Planar> planar = convertImage<RGBF, Planar>(src.view());
+    Image<RGBF, Planar> halfF(w / 2, h / 2);
+    t0 = now();
+    resample(exec, planar.view(), halfF.view(), RESAMPLE_BICUBIC);
+    report("bicúbico float planar", now() - t0, pixels, pixels * 12);
+}
+
+// Histograma com uma tabela compartilhada por atômicos (o jeito ingênuo de
+// paralelizar) contra tabelas privadas por thread; depois os ajustes
+// automáticos montados sobre ele.
+void benchHistogram(int w, int h, const vector<unsigned char> &rgb) {
+    printf("Histograma e ajustes automáticos (%d x %d)\n", w, h);
+    size_t pixels = (size_t)w * h;
+    FilterExecutor exec;
+    GrayWeights gw = grayWeights(true);
+
+    vector<atomic<uint64_t> > shared(4 * 256);
+    double t0 = now();
+    exec.run((unsigned char *)rgb.data(), pixels, 3, [&](unsigned char *p, size_t n) {
+        for (size_t i = 0; i < n * 3; i += 3) {
+            shared[p[i]]++;
+            shared[256 + p[i + 1]]++;
+            shared[512 + p[i + 2]]++;
+            shared[768 + grayPixel(p[i], p[i + 1], p[i + 2], gw)]++;
+        }
+    });
+    report("atômicos compartilhados", now() - t0, pixels, pixels * 3);
+
+    Histogram hist;
+    t0 = now();
+    histogramRGB8(exec, rgb.data(), pixels, hist);
+    bool same = true;
+    for (int k = 0; k < 4 * 256; k++) same = same && shared[k] == hist.bins[k / 256][k % 256];
+    report(same ? "privados por thread" : "privados por thread DIVERGE", now() - t0, pixels, pixels * 3);
+
+    const char *names[3] = { "equalização", "níveis automáticos", "CLAHE 8x8" };
+    for (int k = 0; k < 3; k++) {
+        FilterChain chain;
+        if (k == 0) chain.equalize();
+        if (k == 1) chain.autoLevels();
+        if (k == 2) chain.clahe();
+        vector<unsigned char> work = rgb;
+        t0 = now();
+        chain.apply(exec, work.data(), w, h);
+        report(names[k], now() - t0, pixels, pixels * 3);
+    }
+}
+
+// Arquivo a arquivo: imagem inteira na memória contra faixas com leitura,
+// filtro e gravação sobrepostas. O tempo inclui disco nos dois casos.
+void benchStream(const string &dir, int w, int h, const vector<unsigned char> &rgb) {
+    printf("Processamento em faixas (%d x %d)\n", w, h);
+    size_t pixels = (size_t)w * h;
+    string in = dir + "/bench_in.ppm";
+    string out = dir + "/bench_out.ppm";
+    writePPM(in, ppmView(rgb.data(), w, h));
+    FilterExecutor exec;
+    FilterPipeline chain;
+    chain.chromaKey(0, 255, 0, 0.4).grayScale().brightness(10).gamma(1.8);
+
+    double t0 = now();
+    PPMImage img;
+    readPPM(in, img);
+    chain.apply(exec, img.data(), pixels);
+    writePPM(out, img);
+    string name = "imagem inteira (" + to_string(pixels * 3 >> 20) + " MB)";
+    report(name.c_str(), now() - t0, pixels, pixels * 3);
+    unsigned whole = checksum(img.data(), pixels * 3);
+    img.release();
+
+    PPMStreamOptions opt;
+    t0 = now();
+    streamPipeline(in, out, chain, exec, opt);
+    double t1 = now();
+    readPPM(out, img);
+    name = "faixas (" + to_string(ppmStreamMemory(w, opt) >> 20) + " MB)" +
+           (checksum(img.data(), pixels * 3) == whole ? "" : " DIVERGE");
+    report(name.c_str(), t1 - t0, pixels, pixels * 3);
+    img.release();
+
+    opt.bandRows = 32;
+    opt.halo = 1;
+    t0 = now();
+    streamNeighborhood(in, out, exec, 1,
+                       [w](const FilterTile &t, const unsigned char *const *src, unsigned char *const *dst) {
+                           box3(t, src, dst, w);
+                       }, opt);
+    name = "média 3x3 em faixas (" + to_string(ppmStreamMemory(w, opt) >> 20) + " MB)";
+    report(name.c_str(), now() - t0, pixels, pixels * 3);
+    remove(in.c_str());
+    remove(out.c_str());
+}
+
+// A própria cor-chave tem que sair transparente, mesmo com tolerância menor
+// que a célula da tabela e borda dura (caso em que nenhum nó a enxerga)
+bool checkSmallKey() {
+    bool ok = true;
+    vector<unsigned char> rgb(3 * 32), rgba(4 * 32);
+    for (int i = 0; i < 32; i++) {
+        rgb[3 * i] = 35;
+        rgb[3 * i + 1] = 180;
+        rgb[3 * i + 2] = 60;
+    }
+    for (int bits = 5; bits <= 6; bits++) {
+        ChromaKeyLUT key;
+        key.build(35, 180, 60, 0.01, 0.0, 1.0, bits);
+        key.keyRGBA(rgb.data(), rgba.data(), 32);
+        bool keyed = key.alpha(35, 180, 60) == 0 && key.alpha(35, 180, 70) == 255;
+        for (int i = 0; i < 32; i++) keyed = keyed && rgba[4 * i + 3] == 0;
+        printf("  cor-chave exata, tolerância 0.01, tabela %d^3: %s\n", 1 << bits, keyed ? "recortada" : "FALHOU");
+        ok = ok && keyed;
+    }
+    return ok;
+}
+
+// Quadro de vídeo 1080p: chroma-key original, o rígido em SIMD e a tabela
+// 3D com alfa suave (que faz mais trabalho: distância nas bordas, remove
+// reflexo e grava RGBA).
+bool benchChromaKey() {
+    int w = 1920, h = 1080;
+    size_t pixels = (size_t)w * h;
+    printf("Chroma-key em quadro de vídeo (%d x %d)\n", w, h);
+    vector<unsigned char> frame = makeImage(w, h), work, rgba(pixels * 4);
+    // metade da imagem com a cor-chave e um pouco de ruído
+    for (size_t i = 0; i < pixels / 2; i++) {
+        frame[i * 3] = 20 + frame[i * 3 + 2] % 16;
+        frame[i * 3 + 1] = 190 + frame[i * 3 + 2] % 32;
+        frame[i * 3 + 2] = 40;
+    }
+
+    work = frame;
+    double t0 = now();
+    legacyChromaKey(work.data(), w, h, 20, 200, 40, 0.3);
+    report("original (sqrt, borda dura)", now() - t0, pixels, pixels * 3);
+
+    work = frame;
+    t0 = now();
+    chromaKeyRGB8(work.data(), pixels, 20, 200, 40, 0.3);
+    string hard = string("borda dura ") + simdLevelName(g_simdLevel);
+    report(hard.c_str(), now() - t0, pixels, pixels * 3);
+
+    for (int bits = 5; bits <= 6; bits++) {
+        ChromaKeyLUT key;
+        t0 = now();
+        key.build(20, 200, 40, 0.3, 0.1, 1.0, bits);
+        printf("  tabela %d^3 (%zu KB) montada em %.2f ms\n", 1 << bits, key.tableBytes() >> 10, (now() - t0) * 1000.0);
+
+        SimdLevel saved = g_simdLevel;
+        g_simdLevel = SIMD_SCALAR;
+        t0 = now();
+        key.keyRGBA(frame.data(), rgba.data(), pixels);
+        report("RGBA suave escalar", now() - t0, pixels, pixels * 7);
+        g_simdLevel = saved;
+        t0 = now();
+        key.keyRGBA(frame.data(), rgba.data(), pixels);
+        string name = string("RGBA suave ") + simdLevelName(g_simdLevel);
+        report(name.c_str(), now() - t0, pixels, pixels * 7);
+    }
+    return checkSmallKey();
+}
+
+// Os mesmos filtros pontuais na GPU (fragment shader, leitura por PBO)
+// contra a CPU. O tempo da GPU inclui enviar e trazer de volta a imagem; o
+// resultado tem que ser idêntico ao da CPU.
+void benchGL(int w, int h, const vector<unsigned char> &rgb) {
+    printf("Filtros pontuais em OpenGL (%d x %d)\n", w, h);
+    GLFWwindow *window = glCreateHiddenContext();
+    if (!window) {
+        printf("  sem contexto OpenGL, pulando\n");
+        return;
+    }
+    printf("  %s\n", (const char *)glGetString(GL_RENDERER));
+    size_t pixels = (size_t)w * h;
+    {
+        FilterExecutor exec;
+        GLFilterPipeline gl;
+        FilterPipeline chains[6];
+        const char *names[6] = { "tons de cinza", "negativo", "colorização", "chroma-key", "chroma-key suave",
+                                 "cadeia de 6 fundida" };
+        chains[0].grayScale();
+        chains[1].negative();
+        chains[2].colorize(40, 0, 90);
+        chains[3].chromaKey(0, 255, 0, 0.4);
+        chains[4].softChromaKey(0, 255, 0, 0.4, 0.1, 1.0);
+        chains[5].chromaKey(0, 255, 0, 0.4).grayScale().colorize(40, 0, 90).brightness(10).contrast(1.2).gamma(1.8);
+
+        vector<unsigned char> cpu, gpu(rgb.size());
+        bool ready = gl.init();
+        for (int i = 0; ready && i < 6; i++) {
+            if (!gl.setPipeline(chains[i])) break;
+            gl.apply(rgb.data(), gpu.data(), 1);     // aquece (compilação tardia do driver)
+            cpu = rgb;
+            double t0 = now();
+            chains[i].apply(exec, cpu.data(), pixels);
+            string name = string(names[i]) + " CPU";
+            report(name.c_str(), now() - t0, pixels, pixels * 3);
+
+            t0 = now();
+            bool ok = gl.apply(rgb.data(), gpu.data(), pixels);
+            double t = now() - t0;
+            size_t diff = 0;
+            for (size_t k = 0; k < cpu.size(); k++) diff += cpu[k] != gpu[k];
+            name = string(names[i]) + " GL" + (!ok ? " FALHOU" : (diff ? " DIVERGE" : ""));
+            report(name.c_str(), t, pixels, pixels * 3);
+            if (diff) printf("    %zu bytes diferentes da CPU\n", diff);
+        }
+    }
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
+
+// Sequência de quadros: um de cada vez (disco parado durante os filtros e
+// vice-versa) contra leitura, filtros e gravação sobrepostos. Os quadros
+// têm 1/8 da imagem; o tempo inclui disco nos dois casos.
+void benchSequence(const string &dir, int w, int h, const vector<unsigned char> &rgb) {
+    const int frames = 16;
+    int fh = h / 8 > 0 ? h / 8 : 1;
+    printf("Sequência de %d quadros (%d x %d)\n", frames, w, fh);
+    size_t pixels = (size_t)w * fh * frames;
+    string pattern = dir + "/bench_seq_####.ppm";
+    string outDir = dir + "/bench_seq_out";
+    for (int i = 0; i < frames; i++) writePPM(sequenceName(pattern, i), ppmView(rgb.data(), w, fh));
+    FilterExecutor exec;
+    FilterChain chain;
+    chain.chromaKey(0, 255, 0, 0.4).grayScale().gaussianBlur(1.5).brightness(10);
+    filesystem::create_directories(outDir);
+
+    double t0 = now();
+    for (int i = 0; i < frames; i++) {
+        PPMImage img;
+        readPPM(sequenceName(pattern, i), img);
+        chain.apply(exec, img.data(), img.width, img.height);
+        writePPM(outDir + "/" + filesystem::path(sequenceName(pattern, i)).filename().string(), img);
+    }
+    report("um quadro por vez", now() - t0, pixels, pixels * 3);
+
+    for (int workers = 1; workers <= 2; workers++) {
+        SequenceOptions opt;
+        opt.outputDir = outDir;
+        opt.workers = workers;
+        opt.quiet = true;
+        SequenceStats stats;
+        t0 = now();
+        SequenceProcessor(chain, exec, pattern, opt).run(stats);
+        string name = "pipeline, " + to_string(workers) + (workers == 1 ? " trabalhador" : " trabalhadores");
+        report(name.c_str(), now() - t0, pixels, pixels * 3);
+        printf("    %.1f quadros/s; parado: leitura %.0f ms, filtros %.0f ms, gravação %.0f ms\n",
+               stats.frames / stats.seconds, stats.stalled[0] * 1e3, stats.stalled[1] * 1e3, stats.stalled[2] * 1e3);
+    }
+    for (int i = 0; i < frames; i++) remove(sequenceName(pattern, i).c_str());
+    filesystem::remove_all(outDir);
+}
+
+int main(int argc, char **argv) {
+    double mp = argc > 1 ? atof(argv[1]) : 12.0;
+    string dir = argc > 2 ? argv[2] : ".";
+    int w = 4000;
+    int h = (int)(mp * 1e6 / w);
+    if (h < 1) h = 1;
+
+    vector<unsigned char> rgb = makeImage(w, h);
+    benchRead(dir, w, h, rgb);
+    benchWrite(dir, w, h, rgb);
+    benchFilters(w, h, rgb);
+    bool keyed = benchChromaKey();
+    benchExecutor(w, h, rgb);
+    benchPipeline(w, h, rgb);
+    benchConvolution(w, h, rgb);
+    benchImage(w, h, rgb);
+    benchResample(w, h, rgb);
+    benchHistogram(w, h, rgb);
+    benchStream(dir, w, h, rgb);
+    benchSequence(dir, w, h, rgb);
+    benchGL(w, h, rgb);
+    return keyed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,70 +1,35 @@
 #include <iostream>
 #include <string>
+#include <vector>
 #include <stdio.h>
 #include <stdlib.h>
 #include <fstream>
 #include <sstream>
 #include <math.h>
 
+#include "PPM.h"
+#include "FilterExecutor.h"
+#include "FilterChain.h"
+#include "StreamProcessor.h"
+#include "ChromaKey.h"
+#include "BatchProcessor.h"
+#include "Histogram.h"
+#include "Image.h"
+#include "Resample.h"
+#include "SequenceProcessor.h"
+
 using namespace std;
 
-unsigned char *open(string file, int &width, int &height) {
-    ifstream arq(file);
-    char BUFFER[1024];
-    arq.getline(BUFFER, 1024);
-    char type = BUFFER[1];
-    cout << BUFFER << endl;
-    do {
-        arq.getline(BUFFER, 1024);
-        cout << "." << BUFFER << "." << endl;
-    } while (BUFFER[0] == '#');
-    stringstream sstr(BUFFER);
-    int w;
-    int h;
-    sstr >> w;
-    sstr >> h;
-    width = w;
-    height = h;
-    int maxValue;
-    arq >> maxValue;
-    cout << w << " X " << h << " mv: " << maxValue << endl; 
-    unsigned char *data = new unsigned char [w * h * 3];
-    if (type == '3') {
-        // modo texto
-        int j=0;
-        while (!arq.eof()) {
-            int g;
-            arq >> g;
-            data[j++] = (unsigned char)g;
-        }
-    } else { 
-        // modo binário
-        arq.read(reinterpret_cast<char*> (&data), sizeof(data));
-    }
-    arq.close();
-    return data;
-}
+// divide os filtros em pedaços do tamanho da cache entre todos os núcleos
+FilterExecutor executor;
 
 void save(string file, unsigned char *data, int &w, int &h) {
-    ofstream arq(file);
-    arq << "P3" << endl;
-    arq << "#Gerado por chroma-key." << endl;
-    arq << w << " " << h << endl << "255" << endl;
-    int length = w * h * 3;
-    for (int i = 0; i < length; i++) {
-        arq << (int)data[i] << endl;
-    }    
-    arq.close();
-}
-
-double dist(int &r1, int &g1, int &b1, int &r2, int &g2, int &b2) {
-    double r = r1 - r2;
-    double g = g1 - g2;
-    double b = b1 - b2;
-    return sqrt(r*r + g*g + b*b);
+    PPMWriteOptions opt;
+    opt.comment = "Gerado por chroma-key.";
+    writePPM(file, ppmView(data, w, h), opt);
 }
 
-void chromaKey(unsigned char *data, int w, int h) {
+void chromaKey(FilterChain &filters) {
     int r, g, b;
     cout << "Cor-chave: " << endl;
     cout << "\tR: ";
@@ -77,48 +42,72 @@ void chromaKey(unsigned char *data, int w, int h) {
     cout << "% Tolerência (0..1): ";
     double t;
     cin >> t;
-    
 
-    double dmax = 441.6729559301;
-
-    int length = w * h * 3;
-    for (int i = 0; i < length; i += 3) {
-        int ri = data[i] & 0xff;
-        int gi = data[i+1] & 0xff;
-        int bi = data[i+2] & 0xff;
-        double d = dist(r, g, b, ri, gi, bi);
-        if (d/dmax < t) {
-            data[i] = 0;
-            data[i+1] = 0;
-            data[i+2] = 0;
-        }
+    cout << "Suavidade da borda (0..1, 0 = borda dura): ";
+    double soft;
+    cin >> soft;
+    cout << "Remoção do reflexo da cor-chave (0..1): ";
+    double spill;
+    cin >> spill;
+
+    if (soft > 0 || spill > 0) {
+        filters.softChromaKey(r, g, b, t, soft, spill);
+    } else {
+        filters.chromaKey(r, g, b, t);
     }
 }
 
-void grayScale(unsigned char *data, int w, int h) {
-    cout << "Média aritmética (S) ou ponderada? ";
+// recorte com transparência: chroma-key suave que grava o alfa (RGBA)
+struct Cutout {
+    bool enabled;
+    int r, g, b;
+    double tolerance, softness, spill;
+};
+
+void cutout(Cutout &c) {
+    cout << "Cor-chave: " << endl;
+    cout << "\tR: ";
+    cin >> c.r;
+    cout << "\tG: ";
+    cin >> c.g;
+    cout << "\tB: ";
+    cin >> c.b;
+    cout << "% Tolerência (0..1): ";
+    cin >> c.tolerance;
+    cout << "Suavidade da borda (0..1): ";
+    cin >> c.softness;
+    cout << "Remoção do reflexo da cor-chave (0..1): ";
+    cin >> c.spill;
+    c.enabled = true;
+}
+
+// redimensionamento: muda o tamanho da imagem, então é feito antes da cadeia
+struct Resize {
+    bool enabled;
+    int width, height;
+    ResampleFilter filter;
+};
+
+void resize(Resize &r) {
+    cout << "Nova largura (0 = proporcional à altura): ";
+    cin >> r.width;
+    cout << "Nova altura (0 = proporcional à largura): ";
+    cin >> r.height;
+    cout << "Filtro (B-bilinear, C-bicúbico, L-Lanczos): ";
     char op;
     cin >> op;
-    double rw, gw, bw;
-    if ((op == 'S') || (op == 's')) {
-        rw = gw = bw = 1.0/3.0;
-    } else {
-        rw = 0.2125; 
-        gw = 0.7154;
-        bw = 0.0721;
-    }
-
-    int length = w * h * 3;
-    for (int i = 0; i < length; i += 3) {
-        int ri = data[i] & 0xff;
-        int gi = data[i+1] & 0xff;
-        int bi = data[i+2] & 0xff;
+    r.filter = (op == 'B' || op == 'b') ? RESAMPLE_BILINEAR : ((op == 'L' || op == 'l') ? RESAMPLE_LANCZOS : RESAMPLE_BICUBIC);
+    r.enabled = r.width > 0 || r.height > 0;
+}
 
-        data[i] = data[i+1] = data[i+2] = (int)(ri * rw + gi * gw + bi * bw);
-    }
+void grayScale(FilterChain &filters) {
+    cout << "Média aritmética (S) ou ponderada? ";
+    char op;
+    cin >> op;
+    filters.grayScale((op != 'S') && (op != 's'));
 }
 
-void colorize(unsigned char *data, int w, int h) {
+void colorize(FilterChain &filters) {
     int r, g, b;
     cout << "Cor de base: " << endl;
     cout << "\tR: ";
@@ -127,61 +116,329 @@ void colorize(unsigned char *data, int w, int h) {
     cin >> g;
     cout << "\tB: ";
     cin >> b;
-    
-    int length = w * h * 3;
-    for (int i = 0; i < length; i += 3) {
-        int ri = data[i] & 0xff;
-        int gi = data[i+1] & 0xff;
-        int bi = data[i+2] & 0xff;
 
-        data[i]   = ri | r;
-        data[i+1] = gi | g;
-        data[i+2] = bi | b;
+    filters.colorize(r, g, b);
+}
+
+void negative(FilterChain &filters) {
+    filters.negative();
+}
+
+void brightness(FilterChain &filters) {
+    cout << "Brilho (-255..255): ";
+    int delta;
+    cin >> delta;
+    filters.brightness(delta);
+}
+
+void contrast(FilterChain &filters) {
+    cout << "Fator de contraste (1 = sem alteração): ";
+    double c;
+    cin >> c;
+    filters.contrast(c);
+}
+
+void gammaCorrection(FilterChain &filters) {
+    cout << "Gama (1 = sem alteração): ";
+    double g;
+    cin >> g;
+    filters.gamma(g);
+}
+
+void gaussianBlur(FilterChain &filters) {
+    cout << "Sigma do desfoque (em pixels): ";
+    double sigma;
+    cin >> sigma;
+    filters.gaussianBlur(sigma);
+}
+
+void boxBlur(FilterChain &filters) {
+    cout << "Raio da caixa (0..127): ";
+    int radius;
+    cin >> radius;
+    filters.boxBlur(radius);
+}
+
+void sharpen(FilterChain &filters) {
+    cout << "Sigma do desfoque de referência: ";
+    double sigma;
+    cin >> sigma;
+    cout << "Intensidade (1 = dobra os detalhes): ";
+    double amount;
+    cin >> amount;
+    filters.unsharpMask(sigma, amount);
+}
+
+void edges(FilterChain &filters) {
+    filters.sobel();
+}
+
+void equalize(FilterChain &filters) {
+    cout << "Equalizar pela luminância (L) ou canal a canal? ";
+    char op;
+    cin >> op;
+    filters.equalize((op != 'L') && (op != 'l'));
+}
+
+void autoLevels(FilterChain &filters) {
+    cout << "% dos pixels descartados em cada ponta (ex.: 0.5): ";
+    double clip;
+    cin >> clip;
+    filters.autoLevels(clip / 100.0);
+}
+
+void clahe(FilterChain &filters) {
+    cout << "Regiões por eixo (ex.: 8): ";
+    int tiles;
+    cin >> tiles;
+    cout << "Limite de contraste (ex.: 2): ";
+    double limit;
+    cin >> limit;
+    filters.clahe(tiles, limit);
+}
+
+// médias e faixa útil (1% a 99%) de cada canal
+void printStats(const unsigned char *data, int w, int h) {
+    Histogram hist;
+    histogramRGB8(executor, data, (size_t)w * h, hist);
+    const char *names[4] = { "R", "G", "B", "Luminância" };
+    for (int c = 0; c < 4; c++) {
+        printf("%s: média %.1f, faixa %d..%d\n", names[c], hist.mean(c), hist.percentile(c, 0.01),
+               hist.percentile(c, 0.99));
     }
 }
 
-void negative(unsigned char *data, int w, int h) {
-    int length = w * h * 3;
-    for (int i = 0; i < length; i += 3) {
-        int ri = data[i] & 0xff;
-        int gi = data[i+1] & 0xff;
-        int bi = data[i+2] & 0xff;
+// lê do usuário a sequência de filtros e monta a cadeia
+void readFilters(FilterChain &filters, Cutout &cut, Resize &size) {
+    // vários filtros pontuais em sequência são aplicados juntos, em uma passada só
+    cout << "Quais filtros você quer aplicar, em ordem (1-chroma-key, 2-gray-scale, 3-colorize, 4-negative, "
+            "5-brilho, 6-contraste, 7-gama, 8-recorte com transparência, 9-desfoque gaussiano, "
+            "10-desfoque em caixa, 11-nitidez, 12-bordas, 13-equalização, 14-níveis automáticos, "
+            "15-equalização adaptativa (CLAHE), 16-redimensionar (antes dos demais); ex.: 1 2 3)? ";
+    string line;
+    getline(cin, line);
+    stringstream options(line);
 
-        data[i]   = ri ^ 255;
-        data[i+1] = gi ^ 255;
-        data[i+2] = bi ^ 255;
+    int opt;
+    while (options >> opt) {
+        switch(opt) {
+            case 1:  chromaKey(filters);  break;
+            case 2:  grayScale(filters);  break;
+            case 3:  colorize(filters);   break;
+            case 4:  negative(filters);   break;
+            case 5:  brightness(filters); break;
+            case 6:  contrast(filters);   break;
+            case 7:  gammaCorrection(filters); break;
+            case 8:  cutout(cut);         break;
+            case 9:  gaussianBlur(filters); break;
+            case 10: boxBlur(filters);    break;
+            case 11: sharpen(filters);    break;
+            case 12: edges(filters);      break;
+            case 13: equalize(filters);   break;
+            case 14: autoLevels(filters); break;
+            case 15: clahe(filters);      break;
+            case 16: resize(size);        break;
+            default: cout << "Opção inválida!! (" << opt << ")" << endl;
+        }
+        if (cut.enabled) {
+            // o recorte gera RGBA: nenhum filtro pode vir depois dele
+            if (options >> opt) cout << "O recorte é o último passo; filtros depois dele ignorados." << endl;
+            break;
+        }
     }
 }
 
-int main() {
+// arquivos maiores que isto são filtrados em faixas, sem carregar a imagem inteira
+const long long STREAM_THRESHOLD = 512LL * 1024 * 1024;
+
+void usage() {
+    cout << "Uso: exemplo_03                           (interativo)" << endl
+         << "     exemplo_03 [-f FILTROS] [-r TAMANHO] -o DIR [-j N] [-q] ENTRADA..." << endl
+         << "     exemplo_03 -f FILTROS -s PADRÃO -o DIR [-n INÍCIO[:FIM]] [-w N] [-j N] [-q]" << endl
+         << "  FILTROS  passos separados por ';', ex.: \"key:0,255,0,0.4;gray;blur:2\"" << endl
+         << "           key:r,g,b,tol[,suavidade,reflexo] gray[:s] colorize:r,g,b negative" << endl
+         << "           brightness:d contrast:f gamma:g blur:sigma box:raio sharpen:sigma,int sobel" << endl
+         << "           equalize[:rgb] levels[:corte] clahe[:regiões,limite]" << endl
+         << "  -r TAMANHO  redimensiona antes dos filtros: LxA[:bilinear|bicubic|lanczos], ex.: 320x0" << endl
+         << "              exatamente L x A; com L ou A em 0, ela segue a proporção da imagem" << endl
+         << "  ENTRADA  diretório, padrão entre aspas (\"quadros/*.ppm\") ou arquivo" << endl
+         << "  -s PADRÃO  sequência numerada, gravada em ordem: \"quadros/f_%04d.ppm\" ou \"f_####.ppm\"" << endl
+         << "  -n I[:F] primeiro (e último) quadro; sem -n vai de 0 ou 1 até faltar um" << endl
+         << "  -w N     quadros da sequência filtrados ao mesmo tempo (padrão 1, com todos os núcleos)" << endl
+         << "  -j N     imagens em espera entre leitura, filtros e gravação (padrão 4)" << endl
+         << "  -q       só o resumo final" << endl;
+}
+
+// sequência numerada: um buffer por quadro em circulação, saída em ordem
+int processSequence(const string &spec, const string &pattern, const BatchOptions &opt, SequenceOptions seq,
+                    const vector<string> &files) {
+    if (spec.empty() || opt.outputDir.empty() || !files.empty()) {
+        usage();
+        return EXIT_FAILURE;
+    }
+    if (opt.width > 0 || opt.height > 0) {
+        cerr << "-r não vale com -s: os quadros da sequência mantêm o tamanho" << endl;
+        return EXIT_FAILURE;
+    }
+    FilterChain filters;
+    if (!parseFilterChain(spec, filters)) {
+        return EXIT_FAILURE;
+    }
+    seq.outputDir = opt.outputDir;
+    seq.buffers = opt.inFlight;
+    seq.comment = opt.comment;
+    seq.quiet = opt.quiet;
+    SequenceProcessor processor(filters, executor, pattern, seq);
+    SequenceStats stats;
+    bool ok = processor.run(stats);
+    printSequenceStats(stats);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// modo em lote: os mesmos filtros em muitos arquivos, sem perguntas
+int batch(int argc, char **argv) {
+    string spec;
+    BatchOptions opt;
+    opt.comment = "Gerado por chroma-key.";
+    vector<string> files;
+    string sequence;
+    SequenceOptions seq;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if ((arg == "-f" || arg == "-o" || arg == "-j" || arg == "-r" || arg == "-s" || arg == "-n" || arg == "-w") &&
+            i + 1 >= argc) {
+            usage();
+            return EXIT_FAILURE;
+        }
+        if (arg == "-f") {
+            spec = argv[++i];
+        } else if (arg == "-o") {
+            opt.outputDir = argv[++i];
+        } else if (arg == "-r") {
+            if (!parseResize(argv[++i], opt)) {
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "-s") {
+            sequence = argv[++i];
+        } else if (arg == "-n") {
+            if (sscanf(argv[++i], "%d:%d", &seq.first, &seq.last) < 1 || seq.first < 0 ||
+                (seq.last >= 0 && seq.last < seq.first)) {
+                cerr << "Intervalo de quadros inválido: " << argv[i] << endl;
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "-w") {
+            seq.workers = atoi(argv[++i]);
+        } else if (arg == "-j") {
+            opt.inFlight = atoi(argv[++i]);
+        } else if (arg == "-q") {
+            opt.quiet = true;
+        } else if (arg == "-h" || arg == "--help") {
+            usage();
+            return EXIT_SUCCESS;
+        } else if (!listInputs(arg, files)) {
+            return EXIT_FAILURE;
+        }
+    }
+    if (!sequence.empty()) {
+        return processSequence(spec, sequence, opt, seq, files);
+    }
+    bool resizing = opt.width > 0 || opt.height > 0;
+    if ((spec.empty() && !resizing) || opt.outputDir.empty() || files.empty()) {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    // só miniaturas: -r sem -f
+    FilterChain filters;
+    if (!spec.empty() && !parseFilterChain(spec, filters)) {
+        return EXIT_FAILURE;
+    }
+    BatchProcessor processor(filters, executor, opt);
+    BatchStats stats;
+    bool ok = processor.run(files, stats);
+    printBatchStats(stats);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        return batch(argc, argv);
+    }
+
     string file;
+    string output = "../src/ExemplosMoodle/M3_material/output.ppm";
     
     // AQUI PRA LER DO USUÁRIO O NOME DO ARQUIVO
     // cout << "Digite caminho para o arquivo da imagem de entrada: ";
     // getline(cin, file);
     file = "../src/ExemplosMoodle/M3_material/M3_exemplo1.ppm";
 
-    int w, h;
-    unsigned char *data = open(file, w, h);
-    // cout << ((int)data[0]) << "..." << ((int)data[w * h * 3 - 1]) << endl;
+    ifstream probe(file, ios::binary | ios::ate);
+    long long fileSize = probe ? (long long)probe.tellg() : 0;
+    probe.close();
 
+    FilterChain filters;
+    Cutout cut = Cutout();
+    Resize size = Resize();
 
-    int opt;
-    cout << "Qual opção de filtro você quer aplicar (1-chroma-key, 2-gray-scale, 3-colorize, 4-negative)? ";
-    cin >> opt;
+    if (fileSize > STREAM_THRESHOLD) {
+        cout << "Imagem de " << fileSize / (1024 * 1024) << " MB: processando em faixas." << endl;
+        readFilters(filters, cut, size);
+        if (size.enabled) {
+            cout << "Em faixas a imagem não pode mudar de tamanho: redimensionamento ignorado." << endl;
+        }
+        if (cut.enabled) {
+            cout << "Em faixas a saída é PPM, sem alfa: o recorte será composto sobre fundo preto." << endl;
+            filters.softChromaKey(cut.r, cut.g, cut.b, cut.tolerance, cut.softness, cut.spill);
+        }
+        if (!filters.empty()) {
+            PPMStreamOptions opt;
+            opt.comment = "Gerado por chroma-key.";
+            if (!streamChain(file, output, filters, executor, opt)) {
+                return EXIT_FAILURE;
+            }
+        }
+        return EXIT_SUCCESS;
+    }
 
-    switch(opt) {
-        case 1:  chromaKey(data, w, h); break;
-        case 2:  grayScale(data, w, h); break;
-        case 3:  colorize(data, w, h);  break;
-        case 4:  negative(data, w, h);  break;
-        default: cout << "Opção inválida!!";
+    PPMImage ppm;
+    if (!readPPM(file, ppm)) {
+        return EXIT_FAILURE;
     }
+    cout << ppm.width << " X " << ppm.height << " mv: " << ppm.maxval << endl;
+    Image<RGB8> img;
+    ppmToImage(ppm, img);
+    ppm.release();
+    int w = img.width();
+    int h = img.height();
+    unsigned char *data = img.data();
+    printStats(data, w, h);
+    // cout << ((int)data[0]) << "..." << ((int)data[w * h * 3 - 1]) << endl;
 
-    if ((opt > 0) && (opt < 5)){
-        save("../src/ExemplosMoodle/M3_material/output.ppm", data, w, h);
+    readFilters(filters, cut, size);
+
+    if (size.enabled) {
+        resampleSize(w, h, size.width, size.height);
+        img = resampled(executor, img, size.width, size.height, size.filter);
+        w = img.width();
+        h = img.height();
+        data = img.data();
+        cout << "Redimensionada para " << w << " X " << h << " (" << resampleFilterName(size.filter) << ")" << endl;
     }
-    
-    delete [] data;
+    if (!filters.empty()) {
+        filters.apply(executor, data, w, h);
+    }
+    if (cut.enabled) {
+        ChromaKeyLUT key;
+        key.build(cut.r, cut.g, cut.b, cut.tolerance, cut.softness, cut.spill);
+        Image<RGBA8> rgba(w, h);
+        key.keyRGBA(executor, data, rgba.data(), (size_t)w * h);
+        PPMWriteOptions opt;
+        opt.comment = "Gerado por chroma-key.";
+        writeImage("../src/ExemplosMoodle/M3_material/output.pam", rgba, opt);
+    } else if (!filters.empty() || size.enabled) {
+        save(output, data, w, h);
+    }
+
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,35 @@
+#version 410
+
+in vec2 texture_coords;
+
+// atlas com as páginas residentes e tabela de indireção
+// (slotX, slotY, residente) por página virtual
+uniform sampler2D pageCache;
+uniform usampler2D pageTable;
+uniform float offsetx;
+uniform float offsety;
+uniform float viewx;        // fração da largura da imagem visível na tela
+uniform vec2 virtualSize;   // dimensões da imagem completa em pixels
+uniform float pageSize;
+uniform float pageBorder;
+
+out vec4 frag_color; 
+
+void main () {
+    vec2 uv = vec2(fract(texture_coords.x * viewx + offsetx),
+                   clamp(texture_coords.y + offsety, 0.0, 1.0));
+    vec2 p = uv * virtualSize;
+    ivec2 page = clamp(ivec2(floor(p / pageSize)), ivec2(0), textureSize(pageTable, 0) - 1);
+    uvec4 entry = texelFetch(pageTable, page, 0);
+    if (entry.b == 0u) {
+        // página ainda não carregada
+        discard;
+    }
+    vec2 slotOrigin = vec2(entry.rg) * (pageSize + 2.0 * pageBorder);
+    vec2 texel_px = slotOrigin + pageBorder + (p - vec2(page) * pageSize);
+    vec4 texel = texture (pageCache, texel_px / vec2(textureSize(pageCache, 0)));
+    if(texel.a < 0.5) {
+        discard;
+    }
+    frag_color = texel;
+}
@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "Layer.h"
+#include "StreamedTexture.h"
 
 using namespace std;
 
@@ -26,6 +27,13 @@ int g_gl_height = 480;
 
 float PARALLAX_RATE = 0.01f;
 
+// proporção largura/altura do quad onde as camadas são desenhadas
+const float QUAD_ASPECT = 2.0f / 1.454f;
+
+// slots do atlas de páginas de cada camada paginada (--stream)
+const int PAGE_CACHE_SLOTS_X = 12;
+const int PAGE_CACHE_SLOTS_Y = 6;
+
 GLFWwindow *g_window = NULL;
 
 int loadTexture(unsigned int &texture, char *filename)
@@ -67,8 +75,53 @@ int loadTexture(unsigned int &texture, char *filename)
 	stbi_image_free(data);
 }
 
-int main()
+// Modo --stream: a camada é convertida (uma vez) para um arquivo de páginas
+// ao lado da imagem e só as páginas perto da janela visível vão para a GPU.
+void loadLayer(Layer *layer, bool streamed)
 {
+	layer->stream = NULL;
+	layer->pageTableTid = 0;
+	layer->viewx = 1.0f;
+	if (!streamed)
+	{
+		loadTexture(layer->tid, layer->filename);
+		return;
+	}
+
+	string pagesFile = string(layer->filename) + ".pages";
+	FILE *f = fopen(pagesFile.c_str(), "rb");
+	if (f)
+	{
+		fclose(f);
+	}
+	else if (!bakeStreamedTexture(layer->filename, pagesFile.c_str()))
+	{
+		cout << "Failed to bake " << pagesFile << endl;
+		return;
+	}
+
+	StreamedTexture *stream = new StreamedTexture;
+	if (!stream->open(pagesFile.c_str(), PAGE_CACHE_SLOTS_X, PAGE_CACHE_SLOTS_Y))
+	{
+		cout << "Failed to open " << pagesFile << endl;
+		delete stream;
+		return;
+	}
+	layer->stream = stream;
+	layer->tid = stream->getCacheTexture();
+	layer->pageTableTid = stream->getPageTableTexture();
+	// mantém a escala vertical da imagem: panoramas largos mostram só uma fatia
+	layer->viewx = stream->getHeight() * QUAD_ASPECT / stream->getWidth();
+	if (layer->viewx > 1.0f)
+	{
+		layer->viewx = 1.0f;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	bool streamed = (argc > 1) && (strcmp(argv[1], "--stream") == 0);
+
 	// executa instruções de log
 	restart_gl_log();
 
@@ -86,7 +139,7 @@ int main()
 	l0->ratex = 0.0;
 	l0->ratey = 0;
 	layers.push_back(l0);
-	loadTexture(l0->tid, l0->filename);
+	loadLayer(l0, streamed);
 
 	Layer *l1 = new Layer;
 	l1->filename = "../src/ExemplosMoodle/M5_Material/w1.png";
@@ -96,7 +149,7 @@ int main()
 	l1->ratex = 0.2;
 	l1->ratey = 0;
 	layers.push_back(l1);
-	loadTexture(l1->tid, l1->filename);
+	loadLayer(l1, streamed);
 
 	Layer *l2 = new Layer;
 	l2->filename = "../src/ExemplosMoodle/M5_Material/w2.png";
@@ -107,7 +160,7 @@ int main()
 	l2->ratey = 0;
 
 	layers.push_back(l2);
-	loadTexture(l2->tid, l2->filename);
+	loadLayer(l2, streamed);
 
 	Layer *l3 = new Layer;
 	l3->filename = "../src/ExemplosMoodle/M5_Material/w3.png";
@@ -117,7 +170,7 @@ int main()
 	l3->ratex = 0.6;
 	l3->ratey = 0;
 	layers.push_back(l3);
-	loadTexture(l3->tid, l3->filename);
+	loadLayer(l3, streamed);
 
 	Layer *l4 = new Layer;
 	l4->filename = "../src/ExemplosMoodle/M5_Material/w4.png";
@@ -127,7 +180,7 @@ int main()
 	l4->ratex = 0.8;
 	l4->ratey = 0;
 	layers.push_back(l4);
-	loadTexture(l4->tid, l4->filename);
+	loadLayer(l4, streamed);
 
 	// LOAD TEXTURES
 
@@ -168,7 +221,9 @@ int main()
 	char vertex_shader[1024 * 256];
 	char fragment_shader[1024 * 256];
 	parse_file_into_str("../src/ExemplosMoodle/M5_Material/_camadas_vs.glsl", vertex_shader, 1024 * 256);
-	parse_file_into_str("../src/ExemplosMoodle/M5_Material/_camadas_fs.glsl", fragment_shader, 1024 * 256);
+	parse_file_into_str(streamed ? "../src/ExemplosMoodle/M5_Material/_camadas_paged_fs.glsl"
+										 : "../src/ExemplosMoodle/M5_Material/_camadas_fs.glsl",
+						fragment_shader, 1024 * 256);
 
 	GLuint vs = glCreateShader(GL_VERTEX_SHADER);
 	const GLchar *p = (const GLchar *)vertex_shader;
@@ -234,15 +289,37 @@ int main()
 		for (int i = 0; i < layers.size(); i++)
 		{
 
-			layers[i]->offsetx += layers[i]->ratex * PARALLAX_RATE;
+			// a velocidade é em telas, então panoramas largos não disparam
+			layers[i]->offsetx += layers[i]->ratex * PARALLAX_RATE * layers[i]->viewx;
 
 			glUniform1f(glGetUniformLocation(shader_programme, "offsetx"), layers[i]->offsetx);
 			glUniform1f(glGetUniformLocation(shader_programme, "offsety"), layers[i]->offsety);
 			glUniform1f(glGetUniformLocation(shader_programme, "layer_z"), layers[i]->z);
-			// bind Texture
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, layers[i]->tid);
-			glUniform1i(glGetUniformLocation(shader_programme, "sprite"), 0);
+			if (layers[i]->stream)
+			{
+				StreamedTexture *stream = layers[i]->stream;
+				// carrega/pré-busca páginas antes de amarrar as texturas
+				stream->update(layers[i]->offsetx, layers[i]->offsetx + layers[i]->viewx,
+							   layers[i]->offsety, layers[i]->offsety + 1.0f,
+							   layers[i]->ratex * PARALLAX_RATE);
+				glUniform1f(glGetUniformLocation(shader_programme, "viewx"), layers[i]->viewx);
+				glUniform2f(glGetUniformLocation(shader_programme, "virtualSize"), stream->getWidth(), stream->getHeight());
+				glUniform1f(glGetUniformLocation(shader_programme, "pageSize"), stream->getPageSize());
+				glUniform1f(glGetUniformLocation(shader_programme, "pageBorder"), stream->getBorder());
+				glActiveTexture(GL_TEXTURE1);
+				glBindTexture(GL_TEXTURE_2D, layers[i]->pageTableTid);
+				glUniform1i(glGetUniformLocation(shader_programme, "pageTable"), 1);
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, layers[i]->tid);
+				glUniform1i(glGetUniformLocation(shader_programme, "pageCache"), 0);
+			}
+			else
+			{
+				// bind Texture
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, layers[i]->tid);
+				glUniform1i(glGetUniformLocation(shader_programme, "sprite"), 0);
+			}
 			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 		}
 
@@ -263,6 +340,12 @@ int main()
 		glfwSwapBuffers(g_window);
 	}
 
+	// as threads de leitura precisam terminar antes do contexto
+	for (int i = 0; i < layers.size(); i++)
+	{
+		delete layers[i]->stream;
+	}
+
 	// close GL context and any other GLFW resources
 	glfwTerminate();
 	return 0;
@@ -11,6 +11,7 @@
 #include <string>
 #include <assert.h>
 #include <vector>
+#include <algorithm>
 
 using namespace std;
 
@@ -29,42 +30,25 @@ using namespace glm;
 
 #include <cmath>
 
+// Desenho em lote: shader e buffer de vértices compartilhados pelos exercícios
+#include "Batch2D.h"
+
+// Seleção por ponto e retângulo: hierarquia de caixas dos triângulos
+#include "Bvh2D.h"
+
+// Cena em arquivo binário: S grava, L carrega
+#include "Scene2D.h"
+
+#include <stdlib.h>
+
 // Protótipo da função de callback de teclado
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode);
 void mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
-
-// Protótipos das funções
-GLuint createTriangle(float x0, float y0, float x1, float y1, float x2, float y2);
-int setupShader();
-int setupGeometry();
+void cursor_position_callback(GLFWwindow *window, double xpos, double ypos);
 
 // Dimensões da janela (pode ser alterado em tempo de execução)
 const GLuint WIDTH = 800, HEIGHT = 600;
 
-// Código fonte do Vertex Shader (em GLSL): ainda hardcoded
-const GLchar *vertexShaderSource = R"(
-#version 400
-layout (location = 0) in vec3 position;
-uniform mat4 projection;
-uniform mat4 model;
-void main()	
-{
-	//...pode ter mais linhas de código aqui!
-	gl_Position = projection * model * vec4(position.x, position.y, position.z, 1.0);
-}
-)";
-
-// Código fonte do Fragment Shader (em GLSL): ainda hardcoded
-const GLchar *fragmentShaderSource = R"(
-#version 400
-uniform vec4 inputColor;
-out vec4 color;
-void main()
-{
-	color = inputColor;
-}
-)";
-
 struct Triangle
 {
 	vec3 position;
@@ -74,16 +58,36 @@ struct Triangle
 
 struct TriangleVertices
 {
-	vec3 v0, v1, v2;
+	vec2 v0, v1, v2;
 	vec3 color;
-	GLuint VAO;
-    GLuint VBO;
 };
 
-vector<vec3> tempVertices; // Armazena cliques até formar um triângulo
+vector<vec2> tempVertices; // Armazena cliques até formar um triângulo
 vector<TriangleVertices> triangles;
+
+// Todos os triângulos em um único VBO persistente: um clique só acrescenta
+// os 3 vértices novos, e o buffer dobra de capacidade quando enche
+Batch2DBuffer trianglesBuffer;
 int iColor = 0;
 
+// Edição com o botão direito: clique seleciona (e arrasta) o triângulo de
+// cima, arrasto no vazio seleciona os que tocam o retângulo; o cursor
+// destaca o triângulo embaixo dele. Os ids da BVH são os índices em triangles
+Bvh2D bvh;
+vector<int> selected;
+int hovered = -1;
+bool dragging = false, boxSelecting = false;
+vec2 lastCursor, boxStart;
+
+void addTriangle(const TriangleVertices &tri);
+void moveTriangle(int i, vec2 delta);
+void spawnTriangles(int count);
+void outline(Batch2D &batch, const TriangleVertices &tri, vec4 color);
+
+const char *SCENE_FILE = "cena.tri";
+void saveScene();
+void loadScene();
+
 vector<vec3> colors = {
 	vec3(1.0f, 0.0f, 0.0f), // Vermelho
 	vec3(0.0f, 1.0f, 0.0f), // Verde
@@ -93,7 +97,7 @@ vector<vec3> colors = {
 };
 
 // Função MAIN
-int main()
+int main(int argc, char **argv)
 {
 	// Inicialização da GLFW
 	glfwInit();
@@ -118,6 +122,7 @@ int main()
 	// Fazendo o registro da função de callback para a janela GLFW
 	glfwSetKeyCallback(window, key_callback);
 	glfwSetMouseButtonCallback(window, mouse_button_callback);
+	glfwSetCursorPosCallback(window, cursor_position_callback);
 
 	// GLAD: carrega todos os ponteiros d funções da OpenGL
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
@@ -156,30 +161,31 @@ int main()
 	glfwGetFramebufferSize(window, &width, &height);
 	glViewport(0, 0, width, height);
 
-	// Compilando e buildando o programa de shader
-	GLuint shaderID = setupShader();
-
-	GLuint VAO = createTriangle(-0.5, -0.5, 0.5, -0.5, 0.0, 0.5);
+	// O lote compila o shader; os triângulos ficam no buffer persistente
+	Batch2D batch;
+	if (!batch.init())
+		return -1;
 
 	TriangleVertices tri;
-	tri.v0 = vec3(100.0f, 100.0f, 0.0f);
-	tri.v1 = vec3(200.0f, 100.0f, 0.0f);
-	tri.v2 = vec3(150.0f, 200.0f, 0.0f);
+	tri.v0 = vec2(100.0f, 100.0f);
+	tri.v1 = vec2(200.0f, 100.0f);
+	tri.v2 = vec2(150.0f, 200.0f);
 	tri.color = colors[iColor];
 	iColor = (iColor + 1) % colors.size();
-	triangles.push_back(tri);
-
-	glUseProgram(shaderID);
+	addTriangle(tri);
 
-	// Enviando a cor desejada (vec4) para o fragment shader
-	// Utilizamos a variáveis do tipo uniform em GLSL para armazenar esse tipo de info
-	// que não está nos buffers
-	GLint colorLoc = glGetUniformLocation(shaderID, "inputColor");
+	// Cena grande para teste: N triângulos sorteados, indexados de uma vez
+	if (argc > 1)
+	{
+		spawnTriangles(atoi(argv[1]));
+		double start = glfwGetTime();
+		bvh.build();
+		cout << triangles.size() << " triangulos, BVH em " << 1000.0 * (glfwGetTime() - start) << " ms" << endl;
+	}
 
 	// Matriz de projeção paralela ortográfica
 	// mat4 projection = ortho(-10.0, 10.0, -10.0, 10.0, -1.0, 1.0);
 	mat4 projection = ortho(0.0, 800.0, 600.0, 0.0, -1.0, 1.0);
-	glUniformMatrix4fv(glGetUniformLocation(shaderID, "projection"), 1, GL_FALSE, value_ptr(projection));
 
 	// Loop da aplicação - "game loop"
 	while (!glfwWindowShouldClose(window))
@@ -187,6 +193,9 @@ int main()
 		// Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funções de callback correspondentes
 		glfwPollEvents();
 
+		// Adota a BVH reconstruída em segundo plano, ou pede outra
+		bvh.update();
+
 		// Limpa o buffer de cor
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // cor de fundo
 		glClear(GL_COLOR_BUFFER_BIT);
@@ -194,52 +203,30 @@ int main()
 		glLineWidth(10);
 		glPointSize(20);
 
-		glBindVertexArray(VAO); // Conectando ao buffer de geometria
+		batch.begin(projection);
 
-		for (int i = 0; i < triangles.size(); i++)
+		// Uma chamada para todos os triângulos: a cor vem de cada vértice
+		batch.draw(trianglesBuffer);
+
+		// Contornos: selecionados em branco, o do cursor em amarelo
+		glLineWidth(2);
+		for (size_t i = 0; i < selected.size(); i++)
+			outline(batch, triangles[selected[i]], vec4(1.0f, 1.0f, 1.0f, 1.0f));
+		if (hovered >= 0)
+			outline(batch, triangles[hovered], vec4(1.0f, 1.0f, 0.0f, 1.0f));
+		if (boxSelecting)
 		{
-			TriangleVertices tri = triangles[i];
-			// Criar buffer com os vértices do triângulo atual
-			float triangleVertices[] = {
-				tri.v0.x, tri.v0.y, tri.v0.z,
-				tri.v1.x, tri.v1.y, tri.v1.z,
-				tri.v2.x, tri.v2.y, tri.v2.z};
-
-			// Criar temporariamente VBO e VAO
-			GLuint VAO, VBO;
-			glGenVertexArrays(1, &VAO);
-			glGenBuffers(1, &VBO);
-
-			glBindVertexArray(tri.VAO);
-			glBindBuffer(GL_ARRAY_BUFFER, VBO);
-			glBufferData(GL_ARRAY_BUFFER, sizeof(triangleVertices), triangleVertices, GL_STATIC_DRAW);
-
-			// Atributo de posição
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-			glEnableVertexAttribArray(0);
-
-			// Enviar cor e modelo
-			mat4 model = mat4(1.0f); // sem transformações
-			glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
-			glUniform4f(colorLoc, tri.color.r, tri.color.g, tri.color.b, 1.0f);
-
-			glDrawArrays(GL_TRIANGLES, 0, 3);
-
-			// Limpar buffers temporários
-			glBindVertexArray(0);
-			glDeleteBuffers(1, &VBO);
-			glDeleteVertexArrays(1, &VAO);
+			vec4 white(1.0f, 1.0f, 1.0f, 1.0f);
+			batch.line(boxStart, vec2(lastCursor.x, boxStart.y), white);
+			batch.line(vec2(lastCursor.x, boxStart.y), lastCursor, white);
+			batch.line(lastCursor, vec2(boxStart.x, lastCursor.y), white);
+			batch.line(vec2(boxStart.x, lastCursor.y), boxStart, white);
 		}
-		// Desenho com contorno (linhas)
-		// glUniform4f(colorLoc, 1.0f, 0.0f, 1.0f, 1.0f); //enviando cor para variável uniform inputColor
-		// glDrawArrays(GL_LINE_LOOP, 0, 3); //Desenha T0
-		// glDrawArrays(GL_LINE_LOOP, 3, 3); //Desenha T1
 
 		// Desenho só dos pontos (vértices)
-		// glUniform4f(colorLoc, 1.0f, 1.0f, 0.0f, 1.0f); //enviando cor para variável uniform inputColor
-		// glDrawArrays(GL_POINTS, 0, 6);
+		// batch.point(triangles[0].v0, vec4(1.0f, 1.0f, 0.0f, 1.0f));
 
-		glBindVertexArray(0); // Desconectando o buffer de geometria
+		batch.end();
 
 		// Troca os buffers da tela
 		glfwSwapBuffers(window);
@@ -258,197 +245,183 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 {
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, GL_TRUE);
+	if (key == GLFW_KEY_S && action == GLFW_PRESS)
+		saveScene();
+	if (key == GLFW_KEY_L && action == GLFW_PRESS)
+		loadScene();
 }
 
-// Esta função está basntante hardcoded - objetivo é compilar e "buildar" um programa de
-//  shader simples e único neste exemplo de código
-//  O código fonte do vertex e fragment shader está nos arrays vertexShaderSource e
-//  fragmentShader source no iniçio deste arquivo
-//  A função retorna o identificador do programa de shader
-int setupShader()
+void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
 {
-	// Vertex shader
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-	glCompileShader(vertexShader);
-	// Checando erros de compilação (exibição via log no terminal)
-	GLint success;
-	GLchar infoLog[512];
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-	if (!success)
+	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
 	{
-		glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"
-				  << infoLog << std::endl;
+		double xpos, ypos;
+		glfwGetCursorPos(window, &xpos, &ypos);
+		tempVertices.push_back(vec2(xpos, ypos));
+
+		if (tempVertices.size() == 3)
+		{
+			TriangleVertices tri;
+			tri.v0 = tempVertices[0];
+			tri.v1 = tempVertices[1];
+			tri.v2 = tempVertices[2];
+			tri.color = colors[iColor];
+			iColor = (iColor + 1) % colors.size();
+			addTriangle(tri);
+
+			tempVertices.clear();
+		}
 	}
-	// Fragment shader
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-	glCompileShader(fragmentShader);
-	// Checando erros de compilação (exibição via log no terminal)
-	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-	if (!success)
+
+	if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS)
 	{
-		glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n"
-				  << infoLog << std::endl;
+		double xpos, ypos;
+		glfwGetCursorPos(window, &xpos, &ypos);
+		lastCursor = vec2(xpos, ypos);
+
+		int hit = bvh.pick(lastCursor);
+		if (hit >= 0)
+		{
+			// arrasta a seleção inteira se o triângulo já estava nela
+			if (find(selected.begin(), selected.end(), hit) == selected.end())
+				selected.assign(1, hit);
+			dragging = true;
+		}
+		else
+		{
+			boxStart = lastCursor;
+			boxSelecting = true;
+		}
 	}
-	// Linkando os shaders e criando o identificador do programa de shader
-	GLuint shaderProgram = glCreateProgram();
-	glAttachShader(shaderProgram, vertexShader);
-	glAttachShader(shaderProgram, fragmentShader);
-	glLinkProgram(shaderProgram);
-	// Checando por erros de linkagem
-	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-	if (!success)
+
+	if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_RELEASE)
 	{
-		glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
-				  << infoLog << std::endl;
+		if (boxSelecting)
+			bvh.queryRect(boxStart, lastCursor, selected);
+		dragging = boxSelecting = false;
 	}
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
-
-	return shaderProgram;
 }
 
-// Esta função está bastante harcoded - objetivo é criar os buffers que armazenam a
-// geometria de um triângulo
-// Apenas atributo coordenada nos vértices
-// 1 VBO com as coordenadas, VAO com apenas 1 ponteiro para atributo
-// A função retorna o identificador do VAO
-int setupGeometry()
+void cursor_position_callback(GLFWwindow *window, double xpos, double ypos)
 {
-	// Aqui setamos as coordenadas x, y e z do triângulo e as armazenamos de forma
-	// sequencial, já visando mandar para o VBO (Vertex Buffer Objects)
-	// Cada atributo do vértice (coordenada, cores, coordenadas de textura, normal, etc)
-	// Pode ser arazenado em um VBO único ou em VBOs separados
-	GLfloat vertices[] = {
-		// x    y    z
-		// T0
-		-0.5, -0.5, 0.0, // v0
-		0.5, -0.5, 0.0,	 // v1
-		0.0, 0.5, 0.0,	 // v2
-	};
-
-	GLuint VBO, VAO;
-	// Geração do identificador do VBO
-	glGenBuffers(1, &VBO);
-	// Faz a conexão (vincula) do buffer como um buffer de array
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	// Envia os dados do array de floats para o buffer da OpenGl
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-	// Geração do identificador do VAO (Vertex Array Object)
-	glGenVertexArrays(1, &VAO);
-	// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de vértices
-	// e os ponteiros para os atributos
-	glBindVertexArray(VAO);
-	// Para cada atributo do vertice, criamos um "AttribPointer" (ponteiro para o atributo), indicando:
-	//  Localização no shader * (a localização dos atributos devem ser correspondentes no layout especificado no vertex shader)
-	//  Numero de valores que o atributo tem (por ex, 3 coordenadas xyz)
-	//  Tipo do dado
-	//  Se está normalizado (entre zero e um)
-	//  Tamanho em bytes
-	//  Deslocamento a partir do byte zero
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid *)0);
-	glEnableVertexAttribArray(0);
-
-	// Observe que isso é permitido, a chamada para glVertexAttribPointer registrou o VBO como o objeto de buffer de vértice
-	// atualmente vinculado - para que depois possamos desvincular com segurança
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	// Desvincula o VAO (é uma boa prática desvincular qualquer buffer ou array para evitar bugs medonhos)
-	glBindVertexArray(0);
-
-	return VAO;
+	vec2 cursor(xpos, ypos);
+	if (dragging)
+	{
+		for (size_t i = 0; i < selected.size(); i++)
+			moveTriangle(selected[i], cursor - lastCursor);
+	}
+	if (!boxSelecting)
+		hovered = bvh.pick(cursor);
+	lastCursor = cursor;
 }
 
-GLuint createTriangle(float x0, float y0, float x1, float y1, float x2, float y2)
+// Novo triângulo: no buffer de desenho e na BVH, com o mesmo índice
+void addTriangle(const TriangleVertices &tri)
 {
-	GLuint VAO;
-
-	GLfloat vertices[] = {
-		// x    y    z
-		// T0
-		x0, y0, 0.0, // v0
-		x1, y1, 0.0, // v1
-		x2, y2, 0.0, // v2
-	};
-
-	GLuint VBO;
-	// Geração do identificador do VBO
-	glGenBuffers(1, &VBO);
-	// Faz a conexão (vincula) do buffer como um buffer de array
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	// Envia os dados do array de floats para o buffer da OpenGl
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-	// Geração do identificador do VAO (Vertex Array Object)
-	glGenVertexArrays(1, &VAO);
-	// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de vértices
-	// e os ponteiros para os atributos
-	glBindVertexArray(VAO);
-	// Para cada atributo do vertice, criamos um "AttribPointer" (ponteiro para o atributo), indicando:
-	//  Localização no shader * (a localização dos atributos devem ser correspondentes no layout especificado no vertex shader)
-	//  Numero de valores que o atributo tem (por ex, 3 coordenadas xyz)
-	//  Tipo do dado
-	//  Se está normalizado (entre zero e um)
-	//  Tamanho em bytes
-	//  Deslocamento a partir do byte zero
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid *)0);
-	glEnableVertexAttribArray(0);
-
-	// Observe que isso é permitido, a chamada para glVertexAttribPointer registrou o VBO como o objeto de buffer de vértice
-	// atualmente vinculado - para que depois possamos desvincular com segurança
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	// Desvincula o VAO (é uma boa prática desvincular qualquer buffer ou array para evitar bugs medonhos)
-	glBindVertexArray(0);
-
-	return VAO;
+	trianglesBuffer.triangle(tri.v0, tri.v1, tri.v2, vec4(tri.color, 1.0f));
+	bvh.add(tri.v0, tri.v1, tri.v2);
+	triangles.push_back(tri);
 }
 
-void createBuffersForTriangle(TriangleVertices &tri) {
-    float vertices[] = {
-        tri.v0.x, tri.v0.y, tri.v0.z,
-        tri.v1.x, tri.v1.y, tri.v1.z,
-        tri.v2.x, tri.v2.y, tri.v2.z
-    };
-    glGenVertexArrays(1, &tri.VAO);
-    glGenBuffers(1, &tri.VBO);
-
-    glBindVertexArray(tri.VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, tri.VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+// Desloca o triângulo i: reenvia só os vértices dele e reajusta a BVH
+void moveTriangle(int i, vec2 delta)
+{
+	TriangleVertices &tri = triangles[i];
+	tri.v0 += delta;
+	tri.v1 += delta;
+	tri.v2 += delta;
+	trianglesBuffer.setTriangle(i, tri.v0, tri.v1, tri.v2, vec4(tri.color, 1.0f));
+	bvh.set(i, tri.v0, tri.v1, tri.v2);
+}
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+// Espalha 'count' triângulos pequenos pela janela
+void spawnTriangles(int count)
+{
+	if (count <= 0)
+		return;
+	triangles.reserve(triangles.size() + count);
+	unsigned seed = 2024;
+	for (int i = 0; i < count; i++)
+	{
+		TriangleVertices tri;
+		vec2 *v[3] = {&tri.v0, &tri.v1, &tri.v2};
+		vec2 center;
+		seed = seed * 1103515245u + 12345u;
+		center.x = (float)((seed >> 8) % WIDTH);
+		seed = seed * 1103515245u + 12345u;
+		center.y = (float)((seed >> 8) % HEIGHT);
+		for (int j = 0; j < 3; j++)
+		{
+			seed = seed * 1103515245u + 12345u;
+			*v[j] = center + vec2((float)((seed >> 8) % 13) - 6.0f, (float)((seed >> 16) % 13) - 6.0f);
+		}
+		tri.color = colors[i % colors.size()];
+		addTriangle(tri);
+	}
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+void outline(Batch2D &batch, const TriangleVertices &tri, vec4 color)
+{
+	batch.line(tri.v0, tri.v1, color);
+	batch.line(tri.v1, tri.v2, color);
+	batch.line(tri.v2, tri.v0, color);
 }
 
-void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
+// Os vértices vão como estão no buffer de desenho; a cor exata e a
+// seleção, nos atributos de cada triângulo
+void saveScene()
 {
-	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+	double start = glfwGetTime();
+	vector<Scene2DShape> shapes(triangles.size());
+	for (size_t i = 0; i < triangles.size(); i++)
 	{
-		double xpos, ypos;
-		glfwGetCursorPos(window, &xpos, &ypos);
-		tempVertices.push_back(vec3(xpos, ypos, 0.0f));
+		shapes[i].r = triangles[i].color.r;
+		shapes[i].g = triangles[i].color.g;
+		shapes[i].b = triangles[i].color.b;
+		shapes[i].flags = 0;
+	}
+	for (size_t i = 0; i < selected.size(); i++)
+		shapes[selected[i]].flags |= SCENE2D_SELECTED;
 
-		if (tempVertices.size() == 3)
-		{
-			TriangleVertices tri;
-			tri.v0 = tempVertices[0];
-			tri.v1 = tempVertices[1];
-			tri.v2 = tempVertices[2];
-			tri.color = colors[iColor];
-			iColor = (iColor + 1) % colors.size();
-			        createBuffersForTriangle(tri);
+	if (writeScene2D(SCENE_FILE, trianglesBuffer.vertices(), shapes.data(), triangles.size()))
+		cout << "Cena gravada em " << SCENE_FILE << ": " << triangles.size() << " triangulos em "
+			 << 1000.0 * (glfwGetTime() - start) << " ms" << endl;
+}
 
-			triangles.push_back(tri);
-			tempVertices.clear();
-		}
+// Os vértices mapeados vão direto para o buffer de desenho (e para a GPU);
+// a BVH é reconstruída em segundo plano, com varredura até ficar pronta
+void loadScene()
+{
+	double start = glfwGetTime();
+	Scene2DFile scene;
+	if (!scene.load(SCENE_FILE))
+		return;
+
+	size_t count = scene.size();
+	const Batch2DVertex *v = scene.vertices();
+	const Scene2DShape *shapes = scene.shapes();
+	trianglesBuffer.assign(v, 3 * count);
+	trianglesBuffer.upload();
+
+	triangles.resize(count);
+	selected.clear();
+	bvh.clear();
+	for (size_t i = 0; i < count; i++)
+	{
+		TriangleVertices &tri = triangles[i];
+		tri.v0 = vec2(v[3 * i].x, v[3 * i].y);
+		tri.v1 = vec2(v[3 * i + 1].x, v[3 * i + 1].y);
+		tri.v2 = vec2(v[3 * i + 2].x, v[3 * i + 2].y);
+		tri.color = vec3(shapes[i].r, shapes[i].g, shapes[i].b);
+		bvh.add(tri.v0, tri.v1, tri.v2);
+		if (shapes[i].flags & SCENE2D_SELECTED)
+			selected.push_back((int)i);
 	}
+	bvh.rebuild();
+	tempVertices.clear();
+	hovered = -1;
+	dragging = boxSelecting = false;
+
+	cout << "Cena carregada de " << SCENE_FILE << ": " << count << " triangulos em "
+		 << 1000.0 * (glfwGetTime() - start) << " ms" << endl;
 }
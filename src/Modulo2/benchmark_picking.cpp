@@ -0,0 +1,188 @@
+// Medições de desempenho da seleção de triângulos dos editores
+// (Ex1Parte3M2, Ex2).
+//
+// Uso: benchmark_picking [triângulos] [consultas]
+// Sorteia triângulos pequenos (padrão 500000) e mede consultas por ponto e
+// por retângulo pela BVH (Bvh2D) contra a varredura de todos com o mesmo
+// núcleo em lote, conferindo que os resultados batem, e contra a varredura
+// com o teste de triangleCollidePoint2D do ltMath. Mede também o reajuste ao mover
+// triângulos e a reconstrução em segundo plano, com consultas durante ela.
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "Bvh2D.h"
+
+using namespace std;
+
+double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// mesmo teste de triangleCollidePoint2D (ltMath.h, que não é incluído por
+// definir funções fora de linha): a área do triângulo é igual à soma das
+// áreas dos três subtriângulos com o ponto
+float triangleArea2D(const float *t) {
+    return fabs(((t[2] - t[0]) * (t[5] - t[1]) - (t[4] - t[0]) * (t[3] - t[1])) / 2);
+}
+
+bool triangleCollidePoint2D(const float *t, const float *p) {
+    float a = triangleArea2D(t);
+    float sub1[] = { t[0], t[1], t[2], t[3], p[0], p[1] };
+    float sub2[] = { t[0], t[1], p[0], p[1], t[4], t[5] };
+    float sub3[] = { p[0], p[1], t[2], t[3], t[4], t[5] };
+    return a == triangleArea2D(sub1) + triangleArea2D(sub2) + triangleArea2D(sub3);
+}
+
+// sequência fixa de números entre 0 e 1
+struct Random {
+    unsigned seed;
+
+    Random() : seed(2024) {}
+
+    float next() {
+        seed = seed * 1103515245u + 12345u;
+        return (float)(seed >> 8) / (float)(1u << 24);
+    }
+};
+
+const float WORLD = 4000.0f;   // lado da cena
+const float SIZE = 12.0f;      // lado máximo de cada triângulo
+
+void randomTriangle(Random &r, glm::vec2 v[3]) {
+    glm::vec2 center(r.next() * WORLD, r.next() * WORLD);
+    for (int i = 0; i < 3; i++) v[i] = center + glm::vec2(r.next() - 0.5f, r.next() - 0.5f) * SIZE;
+}
+
+// referência: todos os triângulos pelo núcleo, sem árvore
+void scan(const Bvh2DTriangles &t, glm::vec2 min, glm::vec2 max, vector<unsigned char> &hit, vector<int> &out) {
+    out.clear();
+    trianglesTouchRect(t, 0, t.size(), min.x, min.y, max.x, max.y, &hit[0]);
+    for (size_t k = 0; k < t.size(); k++) {
+        if (hit[k]) out.push_back((int)k);
+    }
+}
+
+int main(int argc, char **argv) {
+    int count = argc > 1 ? atoi(argv[1]) : 500000;
+    int queries = argc > 2 ? atoi(argv[2]) : 100000;
+    if (count <= 0 || queries <= 0) {
+        cerr << "Uso: benchmark_picking [triângulos] [consultas]" << endl;
+        return 1;
+    }
+
+    Random r;
+    Bvh2D bvh;
+    Bvh2DTriangles reference;   // mesma orientação que a BVH guarda
+    vector<float> flat(6 * count);
+    reference.resize(count);
+    for (int i = 0; i < count; i++) {
+        glm::vec2 v[3];
+        randomTriangle(r, v);
+        bvh.add(v[0], v[1], v[2]);
+        reference.set(i, v[0], v[1], v[2]);
+        for (int j = 0; j < 3; j++) {
+            flat[6 * i + 2 * j] = v[j].x;
+            flat[6 * i + 2 * j + 1] = v[j].y;
+        }
+    }
+
+    double t0 = now();
+    bvh.build();
+    printf("%d triângulos, construção da BVH: %.1f ms\n", count, 1000 * (now() - t0));
+
+    vector<glm::vec2> points(queries);
+    for (int i = 0; i < queries; i++) points[i] = glm::vec2(r.next() * WORLD, r.next() * WORLD);
+
+    // pontos pela BVH
+    vector<int> found, expected;
+    size_t hits = 0;
+    t0 = now();
+    for (int i = 0; i < queries; i++) {
+        bvh.queryPoint(points[i], found);
+        hits += found.size();
+    }
+    double tree = now() - t0;
+
+    // pontos por varredura, em menos consultas porque cada uma passa por tudo
+    int scans = queries < 200 ? queries : 200;
+    vector<unsigned char> hit(count);
+    int mismatches = 0;
+    t0 = now();
+    for (int i = 0; i < scans; i++) {
+        scan(reference, points[i], points[i], hit, expected);
+        bvh.queryPoint(points[i], found);
+        if (found != expected) mismatches++;
+    }
+    double linear = now() - t0;
+
+    int ltHits = 0;
+    t0 = now();
+    for (int i = 0; i < scans; i++) {
+        float p[2] = { points[i].x, points[i].y };
+        for (int k = 0; k < count; k++) ltHits += triangleCollidePoint2D(&flat[6 * k], p);
+    }
+    double lt = now() - t0;
+
+    printf("ponto, BVH:                      %10.0f consultas/s (%.2f acertos por consulta)\n",
+           queries / tree, (double)hits / queries);
+    printf("ponto, varredura com o núcleo:   %10.0f consultas/s\n", scans / linear);
+    printf("ponto, triangleCollidePoint2D:   %10.0f consultas/s (%d acertos)\n", scans / lt, ltHits);
+
+    // retângulos de seleção de até 100 x 100
+    t0 = now();
+    hits = 0;
+    for (int i = 0; i < queries; i++) {
+        glm::vec2 size(r.next() * 100, r.next() * 100);
+        bvh.queryRect(points[i], points[i] + size, found);
+        hits += found.size();
+    }
+    tree = now() - t0;
+    for (int i = 0; i < scans; i++) {
+        glm::vec2 size(50, 50);
+        scan(reference, points[i], points[i] + size, hit, expected);
+        bvh.queryRect(points[i], points[i] + size, found);
+        if (found != expected) mismatches++;
+    }
+    printf("retângulo, BVH:                  %10.0f consultas/s (%.1f acertos por consulta)\n",
+           queries / tree, (double)hits / queries);
+
+    // arrastos: cada um move um triângulo e reajusta as caixas
+    int moves = queries;
+    t0 = now();
+    for (int i = 0; i < moves; i++) {
+        int id = (int)(r.next() * count) % count;
+        glm::vec2 v[3];
+        randomTriangle(r, v);
+        bvh.set(id, v[0], v[1], v[2]);
+        reference.set(id, v[0], v[1], v[2]);
+        bvh.update();
+    }
+    double refit = now() - t0;
+    printf("reajuste ao mover:               %10.0f movimentos/s\n", moves / refit);
+
+    // a reconstrução roda em outra thread; consultas seguem na árvore velha
+    int during = 0;
+    t0 = now();
+    bvh.rebuild();
+    while (bvh.rebuilding()) {
+        glm::vec2 p(r.next() * WORLD, r.next() * WORLD);
+        bvh.queryPoint(p, found);
+        during++;
+        bvh.update();
+    }
+    printf("reconstrução em segundo plano:   %.1f ms, %d consultas atendidas enquanto isso\n",
+           1000 * (now() - t0), during);
+
+    for (int i = 0; i < scans; i++) {
+        scan(reference, points[i], points[i], hit, expected);
+        bvh.queryPoint(points[i], found);
+        if (found != expected) mismatches++;
+    }
+    printf("consultas divergentes da varredura: %d\n", mismatches);
+    return mismatches ? 1 : 0;
+}
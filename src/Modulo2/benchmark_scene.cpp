@@ -0,0 +1,109 @@
+// Medições de desempenho do formato de cena dos editores de triângulos
+// (Scene2D.h).
+//
+// Uso: benchmark_scene [triângulos] [arquivo]
+// Gera uma cena com o número de triângulos pedido (padrão 10^7), grava em
+// uma chamada e mede a carga, primeiro com o arquivo fora do cache de
+// páginas (quando o sistema deixa descartá-lo) e depois com ele no cache:
+// mapeamento e conferência do cabeçalho, leitura de todas as páginas e a
+// cópia para um Batch2DBuffer, que é o que o editor faz antes do
+// glBufferData. Confere que o que foi lido bate com o que foi gravado.
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Scene2D.h"
+
+using namespace std;
+
+double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// tira o arquivo do cache de páginas, para a próxima leitura vir do disco
+bool evict(const string &file) {
+#ifndef _WIN32
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    fsync(fd);
+    bool ok = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    ::close(fd);
+    return ok;
+#else
+    return false;
+#endif
+}
+
+bool load(const string &file, size_t count, Batch2DBuffer &buffer, const char *label) {
+    double t0 = now();
+    Scene2DFile scene;
+    if (!scene.load(file) || scene.size() != count) return false;
+    double mapped = now();
+
+    // soma os vértices para puxar todas as páginas do mapeamento
+    const Batch2DVertex *v = scene.vertices();
+    uint32_t sum = 0;
+    for (size_t i = 0; i < 3 * count; i++) sum += v[i].color;
+    for (size_t i = 0; i < count; i++) sum += scene.shapes()[i].flags;
+    double touched = now();
+
+    buffer.assign(v, 3 * count);
+    double copied = now();
+
+    printf("carga %s: mapeamento %.2f ms, páginas %.1f ms, cópia para o buffer %.1f ms, total %.1f ms (%u)\n",
+           label, 1000 * (mapped - t0), 1000 * (touched - mapped), 1000 * (copied - touched), 1000 * (copied - t0),
+           sum & 0xff);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    long count = argc > 1 ? atol(argv[1]) : 10000000;
+    string file = argc > 2 ? argv[2] : "benchmark_scene.tri";
+    if (count <= 0) {
+        cerr << "Uso: benchmark_scene [triângulos] [arquivo]" << endl;
+        return 1;
+    }
+
+    // triângulos sorteados em uma área de 4000 x 4000, cores de uma paleta
+    double t0 = now();
+    vector<Batch2DVertex> vertices(3 * count);
+    vector<Scene2DShape> shapes(count);
+    unsigned seed = 2024;
+    for (long i = 0; i < count; i++) {
+        seed = seed * 1103515245u + 12345u;
+        float x = (float)(seed >> 8) / (1 << 24) * 4000, y = (float)(seed & 0xfff);
+        float r = (i % 10) / 10.0f, g = 1.0f - r, b = 0.5f;
+        uint32_t packed = batch2DColor(glm::vec4(r, g, b, 1.0f));
+        Batch2DVertex a = { x, y, 0, 0, packed }, bv = { x + 10, y, 0, 0, packed }, c = { x + 5, y + 10, 0, 0, packed };
+        vertices[3 * i] = a;
+        vertices[3 * i + 1] = bv;
+        vertices[3 * i + 2] = c;
+        shapes[i].r = r;
+        shapes[i].g = g;
+        shapes[i].b = b;
+        shapes[i].flags = i % 100 == 0 ? SCENE2D_SELECTED : 0;
+    }
+    double bytes = 3.0 * count * sizeof(Batch2DVertex) + count * sizeof(Scene2DShape) + sizeof(Scene2DHeader);
+    printf("%ld triângulos (%.0f MB), geração: %.0f ms\n", count, bytes / (1 << 20), 1000 * (now() - t0));
+
+    t0 = now();
+    if (!writeScene2D(file, vertices.data(), shapes.data(), count)) return 1;
+    double written = now() - t0;
+    printf("gravação (uma chamada): %.0f ms, %.0f MB/s\n", 1000 * written, bytes / (1 << 20) / written);
+
+    Batch2DBuffer buffer;
+    bool cold = evict(file);
+    if (!load(file, count, buffer, cold ? "a frio" : "(sem descartar o cache)")) return 1;
+    if (!load(file, count, buffer, "com o arquivo no cache")) return 1;
+
+    Scene2DFile scene;
+    scene.load(file);
+    bool same = memcmp(buffer.vertices(), vertices.data(), vertices.size() * sizeof(Batch2DVertex)) == 0 &&
+                memcmp(scene.shapes(), shapes.data(), shapes.size() * sizeof(Scene2DShape)) == 0;
+    printf("conteúdo lido %s\n", same ? "igual ao gravado" : "DIFERENTE do gravado");
+    remove(file.c_str());
+    return same ? 0 : 1;
+}
@@ -11,6 +11,14 @@
 #include <string>
 #include <assert.h>
 #include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <atomic>
+#include <new>
+#include <chrono>
 
 using namespace std;
 
@@ -30,43 +38,68 @@ using namespace glm;
 #include <cmath>
 #include <ctime>
 
+#include "ColorGrid.h"
+#include "ColorIndex.h"
+#include "ColorRegions.h"
+#include "GLContext.h"
+#include "PPM.h"
+
 // Protótipo da função de callback de teclado
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode);
 void mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
+void cursor_position_callback(GLFWwindow *window, double xpos, double ypos);
+void scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
 
 // Protótipos das funções
 GLuint createQuad();
+GLuint createInstanceBuffer(GLuint VAO);
+void buildVisible(GLuint instanceVBO, const GridWindow &window);
+void uploadChanged(GLuint instanceVBO);
 int setupShader();
 int setupGeometry();
 void eliminarSimilares(float tolerancia);
+void clicarCelula(int row, int col);
+void desenharTabuleiro(GLuint shaderID, GLuint VAO, GLuint instanceVBO);
+int jogarSemJanela();
 
 // Dimensões da janela (pode ser alterado em tempo de execução)
 const GLuint WIDTH = 800, HEIGHT = 600;
-const GLuint ROWS = 6, COLS = 8;
-const GLuint QUAD_WIDTH = 100, QUAD_HEIGHT = 100;
-const float dMax = sqrt(3.0);
+// Tamanho padrão do tabuleiro (pode ser trocado na linha de comando)
+const int ROWS = 6, COLS = 8;
+// Tamanho máximo de uma célula na tela ao abrir, em pixels
+const float QUAD_SIZE = 100;
+// Tolerância da eliminação em cada métrica (ver colorRadius2)
+const float TOLERANCIA_RGB = 0.2f, TOLERANCIA_OKLAB = 0.1f;
 
 // Código fonte do Vertex Shader (em GLSL): ainda hardcoded
 const GLchar *vertexShaderSource = R"(
-#version 400
+#version 330 core
 layout (location = 0) in vec3 position;
+// atributo por instância: cor da célula, com a = 0 se foi eliminada
+layout (location = 1) in vec4 cellColor;
 uniform mat4 projection;
-uniform mat4 model;
-void main()	
+// janela visível: a instância i é a célula firstCell + (i % windowCols, i / windowCols)
+uniform ivec2 firstCell;
+uniform int windowCols;
+out vec3 vColor;
+void main()
 {
-	//...pode ter mais linhas de código aqui!
-	gl_Position = projection * model * vec4(position.x, position.y, position.z, 1.0);
+	ivec2 cell = firstCell + ivec2(gl_InstanceID % windowCols, gl_InstanceID / windowCols);
+	// célula eliminada: tamanho zero, os triângulos degenerados não geram fragmentos
+	vec2 p = vec2(cell) + 0.5 + position.xy * cellColor.a;
+	gl_Position = projection * vec4(p, 0.0, 1.0);
+	vColor = cellColor.rgb;
 }
 )";
 
 // Código fonte do Fragment Shader (em GLSL): ainda hardcoded
 const GLchar *fragmentShaderSource = R"(
-#version 400
-uniform vec4 inputColor;
+#version 330 core
+in vec3 vColor;
 out vec4 color;
 void main()
 {
-	color = inputColor;
+	color = vec4(vColor, 1.0);
 }
 )";
 
@@ -84,14 +117,167 @@ vector<vec3> colors;
 int iColor = 0;
 int iSelected = -1;
 
-// Criação da grid de quadrados
-Quad grid[ROWS][COLS];
+// Tabuleiro (SoA, linha a linha) e a câmera que o mostra
+ColorGrid grid;
+GridCamera camera;
+// Índice das cores ainda no tabuleiro, na métrica escolhida (tecla L troca)
+ColorIndex colorIndex;
+// Modo regiões (tecla C): o clique elimina só as células conectadas à
+// escolhida por cores parecidas, e vale tamanho^2 pontos
+bool modoRegioes = false;
+RegionFinder regionFinder;
+long long pontos = 0;
+// Análise do tabuleiro inteiro (tecla H), com as threads do FilterExecutor
+FilterExecutor executor;
+
+// Janela de células que está no VBO de instâncias, uma cor RGBA8 por célula
+GridWindow shown;
+vector<GLuint> instances;
+GLsizeiptr instanceCapacity = 0; // em bytes
+bool viewChanged = true;
+
+// Arrasto com o botão direito: última posição do cursor
+bool dragging = false;
+double dragX, dragY;
+
+// Modo automático (-a ou -c): cliques sem janela, pelo mesmo código do mouse
+struct Automatico
+{
+	bool ligado = false;
+	int cliques = 1000;          // -a: quantos cliques sorteados
+	string roteiro;              // -c: arquivo com "linha coluna" por clique
+	string quadros;              // -q: prefixo das imagens (PPM) dos quadros
+	int intervalo = 1;           // -e: um quadro a cada tantos cliques
+} automatico;
+
+// Alocações feitas com new desde o início (contadas no modo automático).
+// Fora de linha, para o compilador não casar o free com o new da biblioteca
+atomic<size_t> alocacoes(0), bytesAlocados(0);
+
+#ifdef _MSC_VER
+#define FORA_DE_LINHA __declspec(noinline)
+#else
+#define FORA_DE_LINHA __attribute__((noinline))
+#endif
+
+FORA_DE_LINHA void *operator new(size_t n)
+{
+	alocacoes++;
+	bytesAlocados += n;
+	if (void *p = malloc(n ? n : 1))
+		return p;
+	throw bad_alloc();
+}
+
+FORA_DE_LINHA void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+FORA_DE_LINHA void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+void uso()
+{
+	cerr << "Uso: M3JogoCores [linhas colunas] [-s semente] [-m rgb|oklab] [-r]\n"
+			"                   [-a cliques | -c roteiro] [-q prefixo [-e n]]\n"
+			"  -s  semente do tabuleiro (padrão: o relógio, mostrada ao abrir)\n"
+			"  -m  distância entre cores; -r começa no modo regiões\n"
+			"  -a  joga sozinho, sem janela, clicando em células sorteadas\n"
+			"  -c  joga sozinho os cliques do arquivo (\"linha coluna\" por linha)\n"
+			"  -q  no modo automático, grava os quadros em prefixo_0000.ppm, ...\n"
+			"  -e  um quadro a cada n cliques (padrão 1)" << endl;
+}
+
+// Lê a linha de comando; falso (com a mensagem) se algo não faz sentido
+bool lerOpcoes(int argc, char **argv, int &rows, int &cols, uint32_t &semente, ColorMetric &metrica)
+{
+	vector<int> tamanho;
+	for (int i = 1; i < argc; i++)
+	{
+		string op = argv[i];
+		bool temValor = i + 1 < argc;
+		if (op == "-s" && temValor)
+			semente = (uint32_t)strtoul(argv[++i], NULL, 10);
+		else if (op == "-m" && temValor)
+		{
+			string m = argv[++i];
+			if (m != "rgb" && m != "oklab")
+			{
+				cerr << "Distância desconhecida: " << m << endl;
+				return false;
+			}
+			metrica = m == "rgb" ? COLOR_RGB : COLOR_OKLAB;
+		}
+		else if (op == "-r")
+			modoRegioes = true;
+		else if (op == "-a" && temValor)
+		{
+			automatico.ligado = true;
+			automatico.cliques = atoi(argv[++i]);
+		}
+		else if (op == "-c" && temValor)
+		{
+			automatico.ligado = true;
+			automatico.roteiro = argv[++i];
+		}
+		else if (op == "-q" && temValor)
+			automatico.quadros = argv[++i];
+		else if (op == "-e" && temValor)
+			automatico.intervalo = atoi(argv[++i]);
+		else if (op[0] != '-' && tamanho.size() < 2)
+			tamanho.push_back(atoi(op.c_str()));
+		else
+		{
+			cerr << "Opção inválida: " << op << endl;
+			return false;
+		}
+	}
+	if (tamanho.size() == 1)
+	{
+		cerr << "Falta o número de colunas" << endl;
+		return false;
+	}
+	if (tamanho.size() == 2)
+	{
+		rows = tamanho[0];
+		cols = tamanho[1];
+		if (rows <= 0 || cols <= 0 || (long long)rows * cols > 200000000LL)
+		{
+			cerr << "Tamanho inválido: " << rows << " x " << cols << endl;
+			return false;
+		}
+	}
+	if (automatico.cliques < 0 || automatico.intervalo <= 0)
+	{
+		cerr << "Número de cliques ou intervalo inválido" << endl;
+		return false;
+	}
+	return true;
+}
 
 // Função MAIN
-int main()
+int main(int argc, char **argv)
 {
-	//srand(glfwGetTime()); TODO - Ver como transformar em unsigned int
-	srand(time(0));
+	int rows = ROWS, cols = COLS;
+	uint32_t semente = (uint32_t)time(0);
+	ColorMetric metrica = COLOR_RGB;
+	if (!lerOpcoes(argc, argv, rows, cols, semente, metrica))
+	{
+		uso();
+		return 1;
+	}
+	cout << "Semente: " << semente << " (-s " << semente << " repete este tabuleiro)" << endl;
+
+	// Inicializar a grid (sorteio determinístico pela semente) e o índice de cores
+	grid.resize(rows, cols);
+	grid.randomize(semente);
+	colorIndex.build(grid, metrica);
+
+	if (automatico.ligado)
+		return jogarSemJanela();
 
 	// Inicialização da GLFW
 	glfwInit();
@@ -116,6 +302,8 @@ int main()
 	// Fazendo o registro da função de callback para a janela GLFW
 	glfwSetKeyCallback(window, key_callback);
 	glfwSetMouseButtonCallback(window, mouse_button_callback);
+	glfwSetCursorPosCallback(window, cursor_position_callback);
+	glfwSetScrollCallback(window, scroll_callback);
 
 	// GLAD: carrega todos os ponteiros d funções da OpenGL
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
@@ -139,24 +327,9 @@ int main()
 
 	GLuint VAO = createQuad();
 
-	// Inicializar a grid
-	for (int i = 0; i < ROWS; i++)
-	{
-		for (int j = 0; j < COLS; j++)
-		{
-			Quad quad;
-			vec2 ini_pos = vec2(QUAD_WIDTH / 2, QUAD_HEIGHT / 2);
-			quad.position = vec3(ini_pos.x + j * QUAD_WIDTH, ini_pos.y + i * QUAD_HEIGHT, 0.0);
-			quad.dimensions = vec3(QUAD_WIDTH, QUAD_HEIGHT, 1.0);
-			float r, g, b;
-			r = rand() % 256 / 255.0;
-			g = rand() % 256 / 255.0;
-			b = rand() % 256 / 255.0;
-			quad.color = vec3(r, g, b);
-			quad.eliminated = false;
-			grid[i][j] = quad;
-		}
-	}
+	// Enquadrar o tabuleiro (células de até QUAD_SIZE pixels)
+	camera.fit(grid, WIDTH, HEIGHT, QUAD_SIZE);
+	GLuint instanceVBO = createInstanceBuffer(VAO);
 
 	// Triangle tri;
 	// tri.position = vec3(400.0,300.0,0.0);
@@ -167,59 +340,16 @@ int main()
 
 	glUseProgram(shaderID);
 
-	// Enviando a cor desejada (vec4) para o fragment shader
-	// Utilizamos a variáveis do tipo uniform em GLSL para armazenar esse tipo de info
-	// que não está nos buffers
-	GLint colorLoc = glGetUniformLocation(shaderID, "inputColor");
-
-	// Matriz de projeção paralela ortográfica
-	// mat4 projection = ortho(-10.0, 10.0, -10.0, 10.0, -1.0, 1.0);
-	mat4 projection = ortho(0.0, 800.0, 600.0, 0.0, -1.0, 1.0);
-	glUniformMatrix4fv(glGetUniformLocation(shaderID, "projection"), 1, GL_FALSE, value_ptr(projection));
-
 	// Loop da aplicação - "game loop"
 	while (!glfwWindowShouldClose(window))
 	{
 		// Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funções de callback correspondentes
 		glfwPollEvents();
 
-		// Limpa o buffer de cor
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // cor de fundo
-		glClear(GL_COLOR_BUFFER_BIT);
-
 		glLineWidth(10);
 		glPointSize(20);
 
-		glBindVertexArray(VAO); // Conectando ao buffer de geometria
-
-		if (iSelected > -1)
-		{
-			eliminarSimilares(0.2);
-		}
-
-
-		for (int i = 0; i < ROWS; i++)
-		{
-			for (int j = 0; j < COLS; j++)
-			{
-				if (!grid[i][j].eliminated)
-				{
-					// Matriz de modelo: transformações na geometria (objeto)
-					mat4 model = mat4(1); // matriz identidade
-					// Translação
-					model = translate(model, grid[i][j].position);
-					//  Escala
-					model = scale(model, grid[i][j].dimensions);
-					glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
-					glUniform4f(colorLoc, grid[i][j].color.r, grid[i][j].color.g, grid[i][j].color.b, 1.0f); // enviando cor para variável uniform inputColor
-					// Chamada de desenho - drawcall
-					// Poligono Preenchido - GL_TRIANGLES
-					glDrawArrays(GL_TRIANGLE_STRIP, 0, 6);
-				}
-			}
-		}
-
-		glBindVertexArray(0); // Desconectando o buffer de geometria
+		desenharTabuleiro(shaderID, VAO, instanceVBO);
 
 		// Troca os buffers da tela
 		glfwSwapBuffers(window);
@@ -231,6 +361,37 @@ int main()
 	return 0;
 }
 
+// Limpa a tela e desenha o tabuleiro como a câmera o vê
+void desenharTabuleiro(GLuint shaderID, GLuint VAO, GLuint instanceVBO)
+{
+	// Limpa o buffer de cor
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // cor de fundo
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	glBindVertexArray(VAO); // Conectando ao buffer de geometria
+
+	// Só a janela visível vai para o VBO: remontada quando a câmera a muda,
+	// senão só as células alteradas dentro dela são reenviadas
+	GridWindow visible = camera.visible(grid);
+	if (viewChanged || visible != shown)
+		buildVisible(instanceVBO, visible);
+	else
+		uploadChanged(instanceVBO);
+
+	// Matriz de projeção paralela ortográfica: a área do tabuleiro (em
+	// unidades de célula) que a câmera enxerga
+	mat4 projection = ortho(camera.x, camera.x + camera.width / camera.zoom,
+							camera.y + camera.height / camera.zoom, camera.y, -1.0f, 1.0f);
+	glUniformMatrix4fv(glGetUniformLocation(shaderID, "projection"), 1, GL_FALSE, value_ptr(projection));
+	glUniform2i(glGetUniformLocation(shaderID, "firstCell"), shown.col0, shown.row0);
+	glUniform1i(glGetUniformLocation(shaderID, "windowCols"), shown.cols() > 0 ? shown.cols() : 1);
+
+	// Uma chamada de desenho para a janela inteira: cada instância é uma célula
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)shown.cells());
+
+	glBindVertexArray(0); // Desconectando o buffer de geometria
+}
+
 // Função de callback de teclado - só pode ter uma instância (deve ser estática se
 // estiver dentro de uma classe) - É chamada sempre que uma tecla for pressionada
 // ou solta via GLFW
@@ -238,6 +399,66 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 {
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, GL_TRUE);
+	if (action == GLFW_RELEASE)
+		return;
+
+	// setas (ou WASD) deslocam um décimo da tela; + e - aproximam e afastam
+	// em torno do centro; F volta a enquadrar o tabuleiro; L alterna a
+	// distância entre cores entre RGB e OKLab (a diferença percebida);
+	// C liga e desliga o modo regiões; H mostra a maior região do tabuleiro
+	float step = 0.1f * std::min(camera.width, camera.height);
+	if (key == GLFW_KEY_LEFT || key == GLFW_KEY_A)
+		camera.pan(grid, -step, 0);
+	else if (key == GLFW_KEY_RIGHT || key == GLFW_KEY_D)
+		camera.pan(grid, step, 0);
+	else if (key == GLFW_KEY_UP || key == GLFW_KEY_W)
+		camera.pan(grid, 0, -step);
+	else if (key == GLFW_KEY_DOWN || key == GLFW_KEY_S)
+		camera.pan(grid, 0, step);
+	else if (key == GLFW_KEY_EQUAL || key == GLFW_KEY_KP_ADD)
+		camera.zoomAt(grid, camera.width / 2.0, camera.height / 2.0, 1.25f);
+	else if (key == GLFW_KEY_MINUS || key == GLFW_KEY_KP_SUBTRACT)
+		camera.zoomAt(grid, camera.width / 2.0, camera.height / 2.0, 0.8f);
+	else if (key == GLFW_KEY_F)
+		camera.fit(grid, camera.width, camera.height, QUAD_SIZE);
+	else if (key == GLFW_KEY_L && action == GLFW_PRESS)
+	{
+		colorIndex.build(grid, colorIndex.colorMetric() == COLOR_RGB ? COLOR_OKLAB : COLOR_RGB);
+		cout << "Distância entre cores: " << colorMetricName(colorIndex.colorMetric()) << endl;
+	}
+	else if (key == GLFW_KEY_C && action == GLFW_PRESS)
+	{
+		modoRegioes = !modoRegioes;
+		cout << (modoRegioes ? "Modo regiões: só as células conectadas" : "Modo cores: todas as células parecidas") << endl;
+	}
+	else if (key == GLFW_KEY_H && action == GLFW_PRESS)
+	{
+		RegionLabels labels;
+		double t = glfwGetTime();
+		RegionSummary s = labels.run(executor, grid, TOLERANCIA_RGB);
+		printf("%d regiões em %.1f ms; maior: %d células; o tabuleiro ainda vale %lld pontos\n", s.regions,
+			   (glfwGetTime() - t) * 1e3, s.largest, s.score);
+		if (s.largestCell >= 0)
+			camera.centerOn(grid, s.largestCell / grid.cols, s.largestCell % grid.cols);
+	}
+}
+
+// Roda do mouse: zoom em torno do cursor
+void scroll_callback(GLFWwindow *window, double xoffset, double yoffset)
+{
+	double xpos, ypos;
+	glfwGetCursorPos(window, &xpos, &ypos);
+	camera.zoomAt(grid, xpos, ypos, (float)pow(1.1, yoffset));
+}
+
+// Botão direito pressionado: arrasta o tabuleiro junto com o cursor
+void cursor_position_callback(GLFWwindow *window, double xpos, double ypos)
+{
+	if (!dragging)
+		return;
+	camera.pan(grid, (float)(dragX - xpos), (float)(dragY - ypos));
+	dragX = xpos;
+	dragY = ypos;
 }
 
 // Esta função está basntante hardcoded - objetivo é compilar e "buildar" um programa de
@@ -294,16 +515,20 @@ int setupShader()
 
 void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
 {
+	if (button == GLFW_MOUSE_BUTTON_RIGHT)
+	{
+		dragging = action == GLFW_PRESS;
+		glfwGetCursorPos(window, &dragX, &dragY);
+	}
 	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
 	{
 		double xpos, ypos;
 		glfwGetCursorPos(window, &xpos, &ypos);
-		cout << xpos << "  " << ypos << " ----- ";
-		cout << xpos / QUAD_WIDTH << " " << ypos / QUAD_HEIGHT << endl;
-		int x = xpos / QUAD_WIDTH;
-		int y = ypos / QUAD_HEIGHT;
-		grid[y][x].eliminated = true;
-		iSelected = x + y * COLS; //indice linear do quadrado selecionado
+		// a célula sob o cursor vem da câmera (deslocamento e zoom)
+		int x, y;
+		if (!camera.cellAt(grid, xpos, ypos, y, x))
+			return;
+		clicarCelula(y, x);
 	}
 }
 
@@ -353,25 +578,275 @@ GLuint createQuad()
 	return VAO;
 }
 
+// Cria o VBO de instâncias (vazio: buildVisible o preenche) e o conecta ao VAO
+// do quadrado: a cor avança uma vez por instância (divisor 1), não por vértice
+GLuint createInstanceBuffer(GLuint VAO)
+{
+	GLuint VBO;
+	glGenBuffers(1, &VBO);
+
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(GLuint), (GLvoid *)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribDivisor(1, 1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return VBO;
+}
+
+// Cor da célula k como RGBA8 (na ordem dos bytes do atributo); alfa 0 se eliminada
+GLuint packCell(size_t k)
+{
+	GLuint r = (GLuint)(grid.r[k] * 255.0f + 0.5f);
+	GLuint g = (GLuint)(grid.g[k] * 255.0f + 0.5f);
+	GLuint b = (GLuint)(grid.b[k] * 255.0f + 0.5f);
+	GLuint a = grid.eliminated[k] ? 0 : 255;
+	unsigned char bytes[4] = {(unsigned char)r, (unsigned char)g, (unsigned char)b, (unsigned char)a};
+	GLuint packed;
+	memcpy(&packed, bytes, 4);
+	return packed;
+}
+
+// Monta a janela visível inteira no VBO; o buffer só é realocado quando a
+// janela passa da capacidade atual (que dobra, para não realocar a cada zoom)
+void buildVisible(GLuint instanceVBO, const GridWindow &window)
+{
+	instances.resize(window.cells());
+	size_t n = 0;
+	for (int i = window.row0; i < window.row1; i++)
+	{
+		size_t k = (size_t)grid.index(i, window.col0);
+		for (int j = window.col0; j < window.col1; j++, k++)
+			instances[n++] = packCell(k);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	GLsizeiptr bytes = (GLsizeiptr)(instances.size() * sizeof(GLuint));
+	if (bytes > instanceCapacity)
+	{
+		instanceCapacity = std::max(bytes, 2 * instanceCapacity);
+		glBufferData(GL_ARRAY_BUFFER, instanceCapacity, NULL, GL_DYNAMIC_DRAW);
+	}
+	if (bytes > 0)
+		glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, instances.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	shown = window;
+	viewChanged = false;
+	grid.changed.clear();
+}
+
+// Reenvia só as células alteradas que estão na janela visível, juntando
+// instâncias vizinhas em um único glBufferSubData (as de fora serão lidas do
+// tabuleiro quando a janela chegar nelas)
+void uploadChanged(GLuint instanceVBO)
+{
+	if (grid.changed.empty())
+		return;
+	// posição de cada célula alterada dentro da janela
+	vector<int> slots;
+	for (size_t k = 0; k < grid.changed.size(); k++)
+	{
+		int i = grid.changed[k] / grid.cols, j = grid.changed[k] % grid.cols;
+		if (shown.contains(i, j))
+			slots.push_back((i - shown.row0) * shown.cols() + (j - shown.col0));
+	}
+	grid.changed.clear();
+
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	sort(slots.begin(), slots.end());
+	size_t first = 0;
+	for (size_t k = 1; k <= slots.size(); k++)
+	{
+		if (k < slots.size() && slots[k] <= slots[k - 1] + 1)
+			continue;
+		int begin = slots[first], end = slots[k - 1] + 1;
+		for (int n = begin; n < end; n++)
+		{
+			int i = shown.row0 + n / shown.cols(), j = shown.col0 + n % shown.cols();
+			instances[n] = packCell(grid.index(i, j));
+		}
+		glBufferSubData(GL_ARRAY_BUFFER, begin * sizeof(GLuint), (end - begin) * sizeof(GLuint), &instances[begin]);
+		first = k;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void eliminarSimilares(float tolerancia)
 {
-	int x = iSelected % COLS;
-	int y = iSelected / COLS;
-	vec3 C = grid[y][x].color;
-	grid[y][x].eliminated = true;
-	for (int i = 0; i < ROWS; i++)
+	if (modoRegioes)
 	{
-		for (int j=0; j < COLS; j++)
+		// preenchimento a partir da célula escolhida (ColorRegions.h)
+		static vector<int> region;
+		regionFinder.region(grid, iSelected, tolerancia, region);
+		for (size_t k = 0; k < region.size(); k++)
 		{
-			vec3 O = grid[i][j].color;
-			float d = sqrt(pow(C.r-O.r,2) + pow(C.g-O.g,2) + pow(C.b-O.b,2));
-			float dd = d/dMax;
-			if (dd <= tolerancia)
+			grid.eliminate(region[k]);
+			colorIndex.remove(region[k]);
+		}
+		pontos += (long long)region.size() * region.size();
+		if (!automatico.ligado)
+			cout << region.size() << " células, " << pontos << " pontos" << endl;
+	}
+	else
+	{
+		// só as cores próximas da selecionada são visitadas (ColorIndex.h)
+		static vector<int> found;
+		eliminateSimilar(grid, colorIndex, iSelected, tolerancia, found);
+	}
+	iSelected = -1;
+}
+
+// Um clique na célula (row, col): ela e as parecidas saem do tabuleiro. É o
+// mesmo caminho para o mouse e para o modo automático
+void clicarCelula(int row, int col)
+{
+	iSelected = grid.index(row, col); //indice linear do quadrado selecionado
+	grid.eliminate(iSelected);
+	// as regiões usam a distância RGB
+	eliminarSimilares(colorIndex.colorMetric() == COLOR_OKLAB && !modoRegioes ? TOLERANCIA_OKLAB : TOLERANCIA_RGB);
+}
+
+// Célula sorteada para o próximo clique automático, ou a próxima ainda no
+// tabuleiro a partir dela; -1 com o tabuleiro vazio
+int sortearCelula(uint32_t &estado)
+{
+	estado = estado * 1103515245u + 12345u;
+	size_t n = grid.size();
+	size_t k = ((size_t)(estado >> 8) * 2654435761u) % n;
+	for (size_t i = 0; i < n; i++, k = k + 1 == n ? 0 : k + 1)
+	{
+		if (!grid.eliminated[k])
+			return (int)k;
+	}
+	return -1;
+}
+
+// Contexto invisível e um framebuffer do tamanho da janela para gravar os
+// quadros do modo automático; falso se não há OpenGL
+bool iniciarQuadros(GLuint &shaderID, GLuint &VAO, GLuint &instanceVBO)
+{
+	if (!glCreateHiddenContext())
+		return false;
+	GLuint fbo, rbo;
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glGenRenderbuffers(1, &rbo);
+	glBindRenderbuffer(GL_RENDERBUFFER, rbo);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rbo);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		cerr << "Framebuffer dos quadros incompleto" << endl;
+		return false;
+	}
+	glViewport(0, 0, WIDTH, HEIGHT);
+	shaderID = setupShader();
+	VAO = createQuad();
+	instanceVBO = createInstanceBuffer(VAO);
+	glUseProgram(shaderID);
+	return true;
+}
+
+// Desenha o tabuleiro e grava em prefixo_NNNN.ppm (de cima para baixo)
+bool gravarQuadro(GLuint shaderID, GLuint VAO, GLuint instanceVBO, int numero)
+{
+	static vector<unsigned char> pixels, linhas;
+	desenharTabuleiro(shaderID, VAO, instanceVBO);
+	pixels.resize((size_t)WIDTH * HEIGHT * 3);
+	linhas.resize(pixels.size());
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+	size_t linha = (size_t)WIDTH * 3;
+	for (GLuint y = 0; y < HEIGHT; y++)
+		memcpy(&linhas[y * linha], &pixels[(HEIGHT - 1 - y) * linha], linha);
+	char nome[32];
+	snprintf(nome, sizeof(nome), "_%04d.ppm", numero);
+	return writePPM(automatico.quadros + nome, ppmView(linhas.data(), WIDTH, HEIGHT));
+}
+
+// Modo automático: os cliques (sorteados ou do roteiro) passam por
+// clicarCelula sem janela; mede cliques por segundo e as alocações feitas
+// só pela lógica do jogo (a gravação dos quadros fica de fora)
+int jogarSemJanela()
+{
+	vector<int> roteiro;
+	if (!automatico.roteiro.empty())
+	{
+		ifstream arq(automatico.roteiro);
+		if (!arq)
+		{
+			cerr << "Erro ao abrir " << automatico.roteiro << endl;
+			return 1;
+		}
+		string texto;
+		while (getline(arq, texto))
+		{
+			int row, col;
+			if (texto.empty() || texto[0] == '#')
+				continue;
+			if (sscanf(texto.c_str(), "%d %d", &row, &col) != 2 || row < 0 || col < 0 || row >= grid.rows || col >= grid.cols)
 			{
-				grid[i][j].eliminated = true;
+				cerr << "Clique inválido em " << automatico.roteiro << ": " << texto << endl;
+				return 1;
 			}
+			roteiro.push_back(grid.index(row, col));
+		}
+	}
 
+	bool quadros = !automatico.quadros.empty();
+	GLuint shaderID = 0, VAO = 0, instanceVBO = 0;
+	if (quadros)
+	{
+		if (!iniciarQuadros(shaderID, VAO, instanceVBO))
+			return 1;
+		camera.fit(grid, WIDTH, HEIGHT, QUAD_SIZE);
+		if (!gravarQuadro(shaderID, VAO, instanceVBO, 0))
+			return 1;
+	}
+
+	int total = roteiro.empty() ? automatico.cliques : (int)roteiro.size();
+	uint32_t estado = 2024;
+	int cliques = 0, gravados = 1;
+	size_t eliminadas = 0;
+	size_t alocados = 0, bytes = 0, semAlocar = 0;
+	double tempo = 0;
+	for (; cliques < total; cliques++)
+	{
+		int k = roteiro.empty() ? sortearCelula(estado) : roteiro[cliques];
+		if (k < 0)
+			break;
+		size_t a0 = alocacoes, b0 = bytesAlocados;
+		size_t antes = grid.changed.size();
+		auto t0 = chrono::steady_clock::now();
+		clicarCelula(k / grid.cols, k % grid.cols);
+		tempo += chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+		eliminadas += grid.changed.size() - antes;
+		alocados += alocacoes - a0;
+		bytes += bytesAlocados - b0;
+		semAlocar += alocacoes == a0 ? 1 : 0;
+
+		if (quadros && (cliques + 1) % automatico.intervalo == 0)
+		{
+			if (!gravarQuadro(shaderID, VAO, instanceVBO, gravados++))
+				return 1;
 		}
+		else if (!quadros)
+			grid.changed.clear(); // sem GPU, nada para reenviar
 	}
-	iSelected = -1;
+
+	printf("%d cliques, %zu células eliminadas (%zu restam), %lld pontos\n", cliques, eliminadas,
+		   grid.size() - count(grid.eliminated.begin(), grid.eliminated.end(), 1), pontos);
+	printf("%.3f ms: %.1f cliques/s (%s, %s)\n", tempo * 1e3, cliques / (tempo > 0 ? tempo : 1e-9),
+		   modoRegioes ? "regiões" : "cores", colorMetricName(colorIndex.colorMetric()));
+	printf("alocações nos cliques: %zu (%zu bytes), %.2f por clique; %d de %d cliques sem alocar\n", alocados, bytes,
+		   cliques ? (double)alocados / cliques : 0.0, (int)semAlocar, cliques);
+	if (quadros)
+	{
+		printf("%d quadros em %s_0000.ppm ...\n", gravados, automatico.quadros.c_str());
+		glfwTerminate();
+	}
+	return 0;
 }
@@ -0,0 +1,192 @@
+// Medições de desempenho da lógica do jogo das cores (M3JogoCores).
+//
+// Uso: benchmark_cores [células] [tolerância]
+// Sorteia um tabuleiro quadrado com o número de células pedido (padrão
+// 10^6) e mede cliques por segundo da eliminação por cor, varrendo o
+// tabuleiro e pelo índice de cores, e da eliminação por regiões, além da
+// rotulação do tabuleiro inteiro, conferindo que os resultados batem.
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "ImageFilters.h"
+#include "ColorGrid.h"
+#include "ColorIndex.h"
+#include "ColorRegions.h"
+
+using namespace std;
+
+double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// sequência fixa de cliques: uma célula sorteada, ou a próxima ainda no
+// tabuleiro; -1 com o tabuleiro vazio
+struct Clicker {
+    unsigned seed;
+
+    Clicker() : seed(2024) {}
+
+    int next(const ColorGrid &grid) {
+        seed = seed * 1103515245u + 12345u;
+        size_t n = grid.size();
+        size_t k = ((size_t)(seed >> 8) * 2654435761u) % n;
+        for (size_t i = 0; i < n; i++, k = k + 1 == n ? 0 : k + 1) {
+            if (!grid.eliminated[k]) return (int)k;
+        }
+        return -1;
+    }
+};
+
+ColorGrid makeGrid(int cells) {
+    int side = (int)sqrt((double)cells);
+    side = side < 1 ? 1 : side;
+    ColorGrid grid;
+    grid.resize(side, (cells + side - 1) / side);
+    grid.randomize(1);
+    return grid;
+}
+
+// varredura completa na métrica dada, a referência do índice
+int bruteForce(ColorGrid &grid, ColorMetric metric, int k, float tolerance) {
+    if (metric == COLOR_RGB) return grid.eliminateSimilar(k, tolerance);
+    float c[3], p[3];
+    colorPoint(grid, k, metric, c);
+    float r2 = colorRadius2(metric, tolerance);
+    int count = grid.eliminate(k) ? 1 : 0;
+    for (size_t i = 0; i < grid.size(); i++) {
+        if (grid.eliminated[i]) continue;
+        colorPoint(grid, (int)i, metric, p);
+        float dx = p[0] - c[0], dy = p[1] - c[1], dz = p[2] - c[2];
+        if (dx * dx + dy * dy + dz * dz <= r2) count += grid.eliminate((int)i) ? 1 : 0;
+    }
+    return count;
+}
+
+struct ClickRun {
+    int clicks;
+    long long eliminated;
+    double seconds;
+};
+
+ClickRun runClicks(ColorGrid grid, ColorMetric metric, float tolerance, int maxClicks, bool indexed,
+                   vector<unsigned char> &result) {
+    ClickRun run = { 0, 0, 0 };
+    ColorIndex index;
+    if (indexed) index.build(grid, metric);
+    Clicker clicker;
+    double t = now();
+    for (; run.clicks < maxClicks; run.clicks++) {
+        int k = clicker.next(grid);
+        if (k < 0) break;
+        run.eliminated += indexed ? eliminateSimilar(grid, index, k, tolerance) : bruteForce(grid, metric, k, tolerance);
+        grid.changed.clear();
+    }
+    run.seconds = now() - t;
+    result = grid.eliminated;
+    return run;
+}
+
+void reportClicks(const char *name, const ClickRun &run) {
+    printf("  %-28s %6d cliques %10.1f cliques/s %9.0f células/clique\n", name, run.clicks,
+           run.clicks / (run.seconds > 0 ? run.seconds : 1e-9), run.clicks ? (double)run.eliminated / run.clicks : 0.0);
+}
+
+void benchIndex(const ColorGrid &grid, float tolerance) {
+    printf("eliminação por cor (%zu células, tolerância %.3f)\n", grid.size(), tolerance);
+    const int maxClicks = 200;
+    ColorMetric metrics[2] = { COLOR_RGB, COLOR_OKLAB };
+    for (int m = 0; m < 2; m++) {
+        ColorMetric metric = metrics[m];
+        double t = now();
+        ColorIndex index;
+        index.build(grid, metric);
+        printf("  %-28s %8.2f ms\n", (string("índice ") + colorMetricName(metric) + ", construção").c_str(), (now() - t) * 1e3);
+
+        vector<unsigned char> reference, result;
+        ClickRun brute = runClicks(grid, metric, tolerance, maxClicks, false, reference);
+        reportClicks((string("varredura ") + colorMetricName(metric)).c_str(), brute);
+
+        SimdLevel saved = g_simdLevel;
+        for (int level = SIMD_SCALAR; level <= saved; level++) {
+            g_simdLevel = (SimdLevel)level;
+            ClickRun indexed = runClicks(grid, metric, tolerance, maxClicks, true, result);
+            string name = string("índice ") + colorMetricName(metric) + " " + simdLevelName(g_simdLevel);
+            reportClicks(name.c_str(), indexed);
+            if (result != reference || indexed.clicks != brute.clicks) {
+                printf("  ERRO: %s difere da varredura\n", name.c_str());
+            }
+        }
+        g_simdLevel = saved;
+    }
+}
+
+void benchRegions(const ColorGrid &board, float tolerance) {
+    printf("regiões conectadas (%zu células, tolerância %.3f)\n", board.size(), tolerance);
+    RegionLabels reference;
+    int threads[2] = { 1, 0 };
+    for (int i = 0; i < 2; i++) {
+        FilterExecutor exec(threads[i]);
+        RegionLabels labels;
+        labels.run(exec, board, tolerance);
+        double t = now();
+        const int reps = 5;
+        RegionSummary s;
+        for (int r = 0; r < reps; r++) s = labels.run(exec, board, tolerance);
+        double dt = (now() - t) / reps;
+        string name = "rotulação, " + to_string(exec.threadCount()) + " thread(s)";
+        printf("  %-28s %8.2f ms %10.1f Mcélulas/s  %d regiões, maior %d\n", name.c_str(), dt * 1e3,
+               board.size() / dt / 1e6, s.regions, s.largest);
+        if (i == 0) reference = labels;
+        else if (labels.label != reference.label) printf("  ERRO: rótulos dependem do número de threads\n");
+    }
+
+    // cada região do preenchimento tem que ser exatamente um rótulo
+    RegionFinder finder;
+    vector<int> region;
+    Clicker clicker;
+    int mismatches = 0;
+    for (int c = 0; c < 1000; c++) {
+        int k = clicker.next(board);
+        finder.region(board, k, tolerance, region);
+        bool same = (int)region.size() == reference.size[reference.label[k]];
+        for (size_t i = 0; i < region.size() && same; i++) same = reference.label[region[i]] == reference.label[k];
+        mismatches += same ? 0 : 1;
+    }
+    if (mismatches) printf("  ERRO: %d regiões diferem da rotulação\n", mismatches);
+
+    ColorGrid grid = board;
+    clicker = Clicker();
+    ClickRun run = { 0, 0, 0 };
+    double t = now();
+    for (; run.clicks < 20000; run.clicks++) {
+        int k = clicker.next(grid);
+        if (k < 0) break;
+        finder.region(grid, k, tolerance, region);
+        for (size_t i = 0; i < region.size(); i++) grid.eliminate(region[i]);
+        grid.changed.clear();
+        run.eliminated += region.size();
+    }
+    run.seconds = now() - t;
+    reportClicks("preenchimento", run);
+}
+
+int main(int argc, char **argv) {
+    int cells = argc > 1 ? atoi(argv[1]) : 1000000;
+    float tolerance = argc > 2 ? (float)atof(argv[2]) : -1;
+    ColorGrid grid = makeGrid(cells > 0 ? cells : 1);
+
+    if (tolerance >= 0) {
+        benchIndex(grid, tolerance);
+    } else {
+        // a do jogo e uma mais fina, em que o índice pesa mais
+        benchIndex(grid, 0.2f);
+        benchIndex(grid, 0.05f);
+    }
+    benchRegions(grid, tolerance >= 0 ? tolerance : 0.2f);
+    return EXIT_SUCCESS;
+}